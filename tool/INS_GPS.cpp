@@ -102,6 +102,17 @@
  *   --init_yaw_deg=(heading [deg])
  *      specifies initial true heading in degree. Please also refer the above explanation
  *      about --init_attitude_deg.
+ *   --init_yaw_bank=(number)
+ *      estimates initial true heading without magnetic sensor by a bank of the specified number
+ *      of INS/GPS filters, whose initial headings are evenly spaced in 360 degrees.
+ *      They process the beginning of the log concurrently on threads, and the heading of the filter
+ *      whose GPS innovations are the most likely is adopted as the initial heading, which overrides
+ *      --init_yaw_deg and magnetic sensor. Then, the whole log is processed as usual.
+ *      It cannot be used with --realtime, --sweep, --checkpoint, --resume, or --profile.
+ *      The default is 0, i.e., inactive.
+ *   --init_yaw_bank_duration=(period [sec])
+ *      specifies the period for --init_yaw_bank from the first GPS data available for initialization.
+ *      The default is 120.
  *
  *   --est_bias=<on|off>
  *      specifies whether the mechanism to estimate sensor bias drift is utilized, or not.
@@ -109,6 +120,18 @@
  *   --use_udkf=<off|on>
  *      specifies whether the UD factorized Kalamn filter (UDKF), or the standard Kalman
  *      filter is utilized. The default is off (standard KF).
+ *   --propagation_interval=(number)
+ *      specifies the number of IMU samples per time update of the filter covariance.
+ *      The mechanization is still performed for every IMU sample, and the transition and
+ *      the process noise are accumulated in between. The covariance is always updated before
+ *      GPS or magnetic sensor correction. The default is 1, i.e., every IMU sample.
+ *   --preintegrate=(number)
+ *      combines the specified number of IMU samples into a single delta-velocity and
+ *      delta-angle increment with coning and sculling compensation, and then performs
+ *      time update of INS and the filter with it, which reduces computation for high rate IMU
+ *      such as 1 kHz. Pending samples are always applied before GPS correction.
+ *      The results of time update are output at the reduced rate.
+ *      The default is 1, i.e., no preintegration.
  *
  *   --direct_sylphide=<off|on>
  *   --in_sylphide=<off|on>
@@ -127,11 +150,108 @@
  * The followings are advanced (i.e., very experimental) options;
  *   --back_propagate
  *      apply Kalman filter smoothing to previously time-updated data
- *      (exclusive with --realtime)
+ *      (exclusive with --realtime and --smooth)
+ *   --smooth
+ *      applies fixed-interval (Rauch-Tung-Striebel) smoothing to the whole log.
+ *      The results of the forward filter are kept in a memory-mapped spill file,
+ *      and the smoothed ones are output at the end of the log, whose modes are "SM_TU"
+ *      and "SM_MU" instead of "TU" and "MU". The backward pass is divided into segments,
+ *      which are processed concurrently on threads.
+ *      It cannot be used with --propagation_interval greater than 1, --checkpoint, or --resume.
+ *      (exclusive with --back_propagate and --realtime)
+ *   --smooth_spill=(file)
+ *      specifies the spill file of --smooth, which needs about 2 KB per time update.
+ *      The default is an anonymous temporary file in $TMPDIR or /tmp.
+ *   --smooth_threads=(number)
+ *      specifies the number of segments of the backward pass of --smooth.
+ *      Its default is 0, i.e., the number of CPUs.
  *   --realtime
  *      change GPS synchronization strategy to support realtime applications.
  *      It processes data without sorting and outputs calculation results as quick as possible.
- *      (exclusive with --back_propagate)
+ *      (exclusive with --back_propagate and --smooth)
+ *   --rt_mode=(light_weight|normal|first_order)
+ *      selects how the GPS delay is compensated in --realtime mode, i.e., how a delayed
+ *      observation is mapped to the current state. light_weight (default) approximates
+ *      the inverse of the state transition matrices with their average. normal inverts
+ *      the transition matrix at every IMU sample, and first_order uses (I - A dt) instead.
+ *   --rt_snapshots=(number)
+ *      specifies the number of IMU samples kept for --realtime mode, which are allocated
+ *      in advance. GPS data delayed more than them is ignored. Its default is 512.
+ *   --rt_threads[=on|off]
+ *      splits --realtime processing into reader, decoder, filter, and writer threads,
+ *      which are connected with bounded lock-free queues, in order that neither a slow output
+ *      nor a long GPS correction delays the next read from a serial port.
+ *      The results are the same as the ones without threads unless any item is dropped.
+ *      It cannot be used with --checkpoint, --resume, or --profile.
+ *   --rt_queue_size=(number)
+ *      specifies the capacity of each queue of --rt_threads in items, i.e., pages, packets,
+ *      and output chunks, respectively. Its default is 1024.
+ *   --rt_queue_policy=(block|drop)[,(block|drop),(block|drop)]
+ *      specifies the action when the page, packet, or output queue is full. block (default)
+ *      makes the producer wait, and drop discards the newest item. A single value is applied
+ *      to all the queues.
+ *   --rt_queue_stats[=(file)]
+ *      reports capacity, the numbers of pushed and dropped items, mean and maximum depth,
+ *      and the numbers of waits of producer and consumer of each queue at the end of --rt_threads
+ *      to the standard error or the specified file. The same items are also added to --benchmark.
+ *   --out=shm:/(name)[:(capacity)]
+ *      publishes each solution as a fixed layout binary record to a ring on POSIX shared memory
+ *      instead of text, which is available for multiple processes with NAV_SharedMemory.h.
+ *      The publisher never waits for readers, which detect overwritten records with sequence
+ *      counters. Its default capacity is 256 records.
+ *   --benchmark=(file)
+ *      writes throughput (IMU samples and GPS updates per CPU second), peak memory usage,
+ *      and heap allocation count of the whole process in JSON format.
+ *      The allocation count is only available when the program is built with
+ *      -DENABLE_ALLOCATION_COUNTER, as "make benchmark" does; otherwise, it is null.
+ *      INS_GPS_benchmark.rb runs filter variants with this option and summarizes the results.
+ *      The latency of each IMU and GPS packet is also reported, and in addition, when the log
+ *      is read from a serial port, the one from the arrival of data to the end of its processing.
+ *   --profile[=(file)]
+ *      reports elapsed time of each processing stage (page reading, UBX decoding, calibration,
+ *      sorting, time update, correction, and output)
+ *      in text to the standard error, or in JSON to the specified file.
+ *      The time update is divided into mechanization, before_update_INS, which is
+ *      the call-back of the synchronization strategies, and the rest, i.e., the self time
+ *      of time_update, which is mostly the covariance propagation.
+ *      This option is only available when the program is built with -DENABLE_PROFILER.
+ *   --sweep=(file)
+ *      performs parameter sweep. The log is decoded only once, and then INS/GPS is processed
+ *      concurrently for each line of the file, which consists of options separated by space,
+ *      such as "--gps_init_acc_2d=10 --bp_depth=2 --out=result_10.csv".
+ *      When --out is omitted in a line, the results are written to (file).(line index).csv.
+ *      Log specific options are fixed at decoding, except for sigma values in --calib_file.
+ *   --sweep_jobs=(number)
+ *      specifies the maximum number of concurrent processes for --sweep.
+ *      Its default is the number of CPUs.
+ *   --segments=(number)
+ *      divides the log into the specified number of segments of equal GPS time length,
+ *      and processes them concurrently on threads. Each segment except for the first one
+ *      is started the warm-up period (see --segment_warmup) before its boundary, whose results
+ *      are not output, and its initial heading is taken from the GPS velocity when the speed
+ *      is 1 m/s or more. The results are concatenated in time order, and the differences
+ *      between the adjacent segments at each boundary are reported to the standard error.
+ *      0 means the number of CPUs. It cannot be used with --realtime, --back_propagate, --smooth,
+ *      --sweep, --checkpoint, --resume, --init_yaw_bank, --dump_relative without the base
+ *      position, --out=shm:, --benchmark, or --profile.
+ *      The default is 1, i.e., the whole log is processed sequentially.
+ *   --segment_warmup=(period [sec])
+ *      specifies the warm-up period of --segments. The default is 300.
+ *   --checkpoint=(file)
+ *      saves the whole processing state (log decoder, sort buffer, Kalman filter including
+ *      snapshots of --back_propagate and --realtime, and so on) in binary to the file
+ *      periodically and at the end of the log. The file is replaced atomically.
+ *   --checkpoint_pages=(number)
+ *      specifies the interval of --checkpoint in pages (32 bytes) of the log.
+ *      Its default is 65536 (2 MB).
+ *   --resume=(file)
+ *      restarts processing from the state saved with --checkpoint under the same options.
+ *      The log is read from the offset stored in the checkpoint, and the results are identical
+ *      to the rest of the ones of a non-stop run, which follows the output position reported
+ *      at the resumption.
+ *   --resume_offset=(bytes)
+ *      overrides the log offset for --resume, for example, 0 when the log only contains data
+ *      after the checkpoint.
  *
  */
 
@@ -140,15 +260,21 @@
 //unsigned int fp_control_state = _controlfp(_EM_INEXACT, _MCW_EM);
 
 #include <iostream>
+#include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <string>
 #include <exception>
+#include <typeinfo>
 
 #include <cstdio>
 #include <cmath>
 #include <cstring>
 #include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <limits>
 
 #include <vector>
 #include <list>
@@ -156,37 +282,66 @@
 #include <deque>
 #include <algorithm>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "util/profiler.h"
+#include "util/checkpoint.h"
+#include "util/spsc_queue.h"
+
 #define IS_LITTLE_ENDIAN 1
 #include "SylphideStream.h"
 #include "SylphideProcessor.h"
 
 typedef double float_sylph_t;
 
+/*
+ * Precision of mechanization and filtering, which is float_sylph_t by default.
+ * Single precision is selected by building with -DINS_GPS_FLOAT_T=float;
+ * even then, time stamps, input and output are kept in float_sylph_t,
+ * and the position quaternion and the covariance are accumulated in double.
+ */
+#if !defined(INS_GPS_FLOAT_T)
+#define INS_GPS_FLOAT_T float_sylph_t
+#endif
+typedef INS_GPS_FLOAT_T float_ins_t;
+
 #include "param/matrix.h"
 #include "param/vector3.h"
 #include "param/quaternion.h"
 #include "param/complex.h"
 
-template <>
-struct Vector3Data_TypeMapper<float_sylph_t> {
-  typedef Vector3Data_NoFlyWeight<float_sylph_t> res_t;
-};
-template <>
-struct QuaternionData_TypeMapper<float_sylph_t> {
-  typedef QuaternionData_NoFlyWeight<float_sylph_t> res_t;
-};
+// for float_sylph_t and float_ins_t
+#define NO_FLYWEIGHT(float_t) \
+template <> \
+struct Vector3Data_TypeMapper<float_t> { \
+  typedef Vector3Data_NoFlyWeight<float_t> res_t; \
+}; \
+template <> \
+struct QuaternionData_TypeMapper<float_t> { \
+  typedef QuaternionData_NoFlyWeight<float_t> res_t; \
+}
+NO_FLYWEIGHT(double);
+NO_FLYWEIGHT(float);
+#undef NO_FLYWEIGHT
 
 #include "algorithm/kalman.h"
 
 #include "navigation/INS_GPS_Factory.h"
 #include "navigation/INS_GPS_Synchronization.h"
+#include "navigation/INS_GPS_Smoother.h"
 #include "navigation/INS_GPS_Debug.h"
+#include "navigation/INS_Preintegration.h"
 
 #include "navigation/WGS84.h"
 #include "navigation/MagneticField.h"
 
 #include "analyze_common.h"
 #include "calibration.h"
+#include "NAV_SharedMemory.h"
 
 struct Options : public GlobalOptions<float_sylph_t> {
   typedef GlobalOptions<float_sylph_t> super_t;
@@ -242,6 +397,7 @@ struct Options : public GlobalOptions<float_sylph_t> {
     }
   } dump_relative; ///< Controller for relative (2D) position outputs  bool out_is_N_packet; ///< True for NPacket formatted outputs
   bool out_is_N_packet; ///< True for NPacket formatted outputs
+  NAV_SharedMemory::Writer *out_shm; ///< Destination of binary outputs, NULL when inactive
 
   // Time Stamp
   struct time_stamp_t {
@@ -281,13 +437,18 @@ struct Options : public GlobalOptions<float_sylph_t> {
     INS_GPS_SYNC_OFFLINE,
     INS_GPS_SYNC_BACK_PROPAGATION, ///< a.k.a, smoothing
     INS_GPS_SYNC_REALTIME,
+    INS_GPS_SYNC_SMOOTHING, ///< fixed-interval smoothing over the whole log
   } ins_gps_sync_strategy;
   bool est_bias; ///< True for performing bias estimation
   bool use_udkf; ///< True for UD Kalman filtering
   bool use_egm; ///< True for precise Earth gravity model
+  unsigned int propagation_interval; ///< Number of IMU samples per covariance propagation
+  unsigned int preintegrate; ///< Number of IMU samples combined into a time update
 
-  INS_GPS_Back_Propagate_Property<float_sylph_t> back_propagate_property;
-  INS_GPS_RealTime_Property<float_sylph_t> realttime_property;
+  INS_GPS_Back_Propagate_Property<float_ins_t> back_propagate_property;
+  INS_GPS_RealTime_Property<float_ins_t> realttime_property;
+  INS_GPS_RTS_Smoother_Property<float_ins_t> smoother_property;
+  std::string smooth_spill; ///< Spill file of --smooth, empty for an anonymous temporary file
 
   // GPS options
   bool gps_fake_lock; ///< true when dummy GPS data is used.
@@ -331,31 +492,107 @@ struct Options : public GlobalOptions<float_sylph_t> {
           << atti.roll_deg;
     }
   } initial_attitude;
+  struct init_yaw_bank_t {
+    int hypotheses; ///< Number of initial headings, inactive when less than 2
+    float_sylph_t duration; ///< Evaluation period in seconds
+    init_yaw_bank_t() : hypotheses(0), duration(120) {}
+  } init_yaw_bank;
   std::istream *init_misc; ///< other manual initialization
   std::stringstream init_misc_buf; ///< buffer for init_misc string
 
   // Debug
-  INS_GPS_Debug_Property<float_sylph_t> debug_property;
+  INS_GPS_Debug_Property<float_ins_t> debug_property;
+  std::ostream *benchmark_out; ///< Destination of throughput report in JSON, NULL when inactive
+  std::ostream *profile_out; ///< Destination of per-stage profile, NULL when inactive
+  bool profile_in_json; ///< True when the profile is written in JSON
+
+  // Parameter sweep
+  struct sweep_t {
+    const char *fname; ///< Configuration file, NULL when inactive
+    int jobs; ///< Maximum number of concurrent processes, non-positive for the number of CPUs
+    sweep_t() : fname(NULL), jobs(0) {}
+  } sweep;
+
+  // Segment-parallel processing
+  struct segments_t {
+    int number; ///< Number of segments, 1 for sequential processing, non-positive for the number of CPUs
+    float_sylph_t warmup; ///< Period processed before the boundary of each segment [sec]
+    segments_t() : number(1), warmup(300) {}
+  } segments;
+
+  // Checkpoint
+  struct checkpoint_t {
+    const char *fname; ///< File to be saved, NULL when inactive
+    int pages; ///< Interval in pages
+    const char *resume_fname; ///< File to be restored, NULL when inactive
+    long resume_offset; ///< Log offset in bytes to resume, negative for the stored one
+    checkpoint_t() : fname(NULL), pages(0x10000), resume_fname(NULL), resume_offset(-1) {}
+  } checkpoint;
+
+  // Multithreaded pipeline for realtime mode
+  struct rt_threads_t {
+    bool enabled;
+    unsigned int queue_size; ///< Capacity of each queue in items
+    enum {QUEUE_PAGE, QUEUE_PACKET, QUEUE_OUTPUT, QUEUES};
+    bool drop[QUEUES]; ///< True when the newest item is discarded at overflow, otherwise the producer waits
+    std::ostream *stats_out; ///< Destination of queue statistics, NULL when inactive
+    rt_threads_t() : enabled(false), queue_size(0x400), stats_out(NULL) {
+      for(int i(0); i < QUEUES; ++i){drop[i] = false;}
+    }
+    /**
+     * @param spec "block" or "drop" for all queues, or comma separated ones for each queue
+     * @return (bool) true when success, otherwise false.
+     */
+    bool parse_policy(const char *spec){
+      bool res[QUEUES];
+      int i(0);
+      for(; (i < QUEUES) && *spec; ++i){
+        if(std::strncmp(spec, "block", 5) == 0){
+          res[i] = false; spec += 5;
+        }else if(std::strncmp(spec, "drop", 4) == 0){
+          res[i] = true; spec += 4;
+        }else{
+          return false;
+        }
+        if(*spec == ','){++spec;}else if(*spec){return false;}
+      }
+      if(*spec || (i == 0)){return false;}
+      for(int j(0); j < QUEUES; ++j){drop[j] = res[(i == 1) ? 0 : j];}
+      return (i == 1) || (i == QUEUES);
+    }
+    friend std::ostream &operator<<(std::ostream &out, const rt_threads_t &prop){
+      for(int i(0); i < QUEUES; ++i){
+        out << (i > 0 ? "," : "") << (prop.drop[i] ? "drop" : "block");
+      }
+      return out;
+    }
+  } rt_threads;
 
   Options()
       : super_t(),
       dump_update(true), dump_correct(false), dump_stddev(false), dump_relative(),
-      out_is_N_packet(false),
+      out_is_N_packet(false), out_shm(NULL),
       time_stamp(),
       ins_gps_sync_strategy(INS_GPS_SYNC_OFFLINE),
-      est_bias(true), use_udkf(false), use_egm(false),
+      est_bias(true), use_udkf(false), use_egm(false), propagation_interval(1), preintegrate(1),
       back_propagate_property(),
       realttime_property(),
+      smoother_property(), smooth_spill(),
       gps_fake_lock(false), gps_threshold(),
       use_magnet(false),
       mag_heading_accuracy_deg(3),
       yaw_correct_with_mag_when_speed_less_than_ms(5),
-      initial_attitude(),
+      initial_attitude(), init_yaw_bank(),
       init_misc_buf(), init_misc(&init_misc_buf),
-      debug_property() {
-    realttime_property.rt_mode = INS_GPS_RealTime_Property<float_sylph_t>::RT_LIGHT_WEIGHT;
+      debug_property(), benchmark_out(NULL),
+      profile_out(NULL), profile_in_json(false),
+      sweep(), segments(), checkpoint(), rt_threads() {
+    realttime_property.rt_mode = INS_GPS_RealTime_Property<float_ins_t>::RT_LIGHT_WEIGHT;
+    smoother_property.segments = 0; // the number of CPUs
+  }
+  ~Options(){
+    delete out_shm; // readers are notified of the end.
   }
-  ~Options(){}
 
   /**
    * Check spec
@@ -399,6 +636,29 @@ CHECK_OPTION(target, true, target = is_true(value), (target ? "on" : "off"));
         dump_relative);
     CHECK_ALIAS(out_N_packet);
     CHECK_OPTION_BOOL(out_is_N_packet);
+    if(CHECK_KEY(out)){
+      const char *value(get_value(spec, key_length, false));
+      if(value && (std::strncmp(value, "shm:", 4) == 0)){
+        // shm:/name[:capacity]
+        std::string name(value + 4);
+        unsigned int capacity(0x100);
+        std::string::size_type pos(name.find(':'));
+        if(pos != std::string::npos){
+          capacity = std::atoi(name.c_str() + pos + 1);
+          name.erase(pos);
+        }
+        delete out_shm;
+        out_shm = new NAV_SharedMemory::Writer(name.c_str(), capacity);
+        if(!out_shm->is_open()){
+          std::cerr << "(error!) Failed to open shared memory: " << value << std::endl;
+          exit(-1);
+        }
+        _out = &blackhole;
+        std::cerr << "out: " << name << " (shared memory, capacity " << capacity << ")" << std::endl;
+        return true;
+      }
+      key_checked = false; // others are processed by super_t
+    }
 
     CHECK_OPTION(calendar_time, true,
         time_stamp.parse_calendar_spec(value),
@@ -410,9 +670,79 @@ CHECK_OPTION(target, true, target = is_true(value), (target ? "on" : "off"));
     CHECK_OPTION(realtime, true,
         if(is_true(value)){ins_gps_sync_strategy = INS_GPS_SYNC_REALTIME;},
         (ins_gps_sync_strategy == INS_GPS_SYNC_REALTIME ? "on" : "off"));
+    CHECK_OPTION(smooth, true,
+        if(is_true(value)){ins_gps_sync_strategy = INS_GPS_SYNC_SMOOTHING;},
+        (ins_gps_sync_strategy == INS_GPS_SYNC_SMOOTHING ? "on" : "off"));
+    CHECK_OPTION(smooth_spill, false, smooth_spill = value, value);
+    CHECK_OPTION(smooth_threads, false,
+        smoother_property.segments = std::max(0, std::atoi(value)),
+        smoother_property.segments);
+    {
+      typedef INS_GPS_RealTime_Property<float_ins_t> prop_t;
+      static const char *rt_mode_names[] = {"normal", "light_weight", "first_order"};
+      CHECK_OPTION(rt_mode, false,
+          {
+            int i(sizeof(rt_mode_names) / sizeof(rt_mode_names[0]) - 1);
+            for(; i >= 0; --i){
+              if(std::strcmp(value, rt_mode_names[i]) == 0){break;}
+            }
+            if(i < 0){
+              std::cerr << "(error!) Unknown rt_mode: " << value << std::endl;
+              exit(-1);
+            }
+            realttime_property.rt_mode = (prop_t::rt_mode_t)i;
+          },
+          rt_mode_names[realttime_property.rt_mode]);
+    }
+    CHECK_OPTION(rt_snapshots, false,
+        {
+          int num(std::atoi(value));
+          if(num <= 0){
+            std::cerr << "(error!) rt_snapshots should be positive: " << value << std::endl;
+            exit(-1);
+          }
+          realttime_property.snapshots_max = num;
+        },
+        realttime_property.snapshots_max);
+    CHECK_OPTION(rt_threads, true,
+        rt_threads.enabled = is_true(value),
+        (rt_threads.enabled ? "on" : "off"));
+    CHECK_OPTION(rt_queue_size, false,
+        {
+          int num(std::atoi(value));
+          if(num <= 0){
+            std::cerr << "(error!) rt_queue_size should be positive: " << value << std::endl;
+            exit(-1);
+          }
+          rt_threads.queue_size = num;
+        },
+        rt_threads.queue_size);
+    CHECK_OPTION(rt_queue_policy, false,
+        if(!rt_threads.parse_policy(value)){
+          std::cerr << "(error!) Unknown rt_queue_policy: " << value << std::endl;
+          exit(-1);
+        },
+        rt_threads);
+    if(CHECK_KEY(rt_queue_stats)){
+      const char *value(get_value(spec, key_length, true));
+      std::cerr << "rt_queue_stats: ";
+      if((!value) || is_true(value)){
+        rt_threads.stats_out = &std::cerr;
+        std::cerr << "on" << std::endl;
+      }else{
+        rt_threads.stats_out = &spec2ostream(value);
+      }
+      return true;
+    }
     CHECK_OPTION_BOOL(est_bias);
     CHECK_OPTION_BOOL(use_udkf);
     CHECK_OPTION_BOOL(use_egm);
+    CHECK_OPTION(propagation_interval, false,
+        propagation_interval = std::max(1, std::atoi(value)),
+        propagation_interval);
+    CHECK_OPTION(preintegrate, false,
+        preintegrate = std::max(1, std::atoi(value)),
+        preintegrate);
     CHECK_OPTION(bp_depth, false,
         back_propagate_property.back_propagate_depth = std::atof(value),
         back_propagate_property.back_propagate_depth);
@@ -449,6 +779,12 @@ CHECK_OPTION(target, true, target = is_true(value), (target ? "on" : "off"));
     CHECK_OPTION(init_yaw_deg, false,
         initial_attitude.parse_yaw(value),
         initial_attitude.yaw_deg << " [deg]");
+    CHECK_OPTION(init_yaw_bank, false,
+        init_yaw_bank.hypotheses = std::atoi(value),
+        init_yaw_bank.hypotheses);
+    CHECK_OPTION(init_yaw_bank_duration, false,
+        if((init_yaw_bank.duration = std::atof(value)) <= 0){return false;},
+        init_yaw_bank.duration << " [sec]");
     CHECK_OPTION(init_misc, false,
         {init_misc_buf << value << std::endl; return true;},
         "");
@@ -459,6 +795,43 @@ CHECK_OPTION(target, true, target = is_true(value), (target ? "on" : "off"));
     CHECK_OPTION(debug, false,
         if(!debug_property.check_debug_property_spec(value)){break;},
         debug_property.show_debug_property());
+    if(CHECK_KEY(benchmark)){
+      const char *value(get_value(spec, key_length, false));
+      if(!value){return false;}
+      std::cerr << "benchmark: ";
+      benchmark_out = &spec2ostream(value);
+      return true;
+    }
+    CHECK_OPTION(sweep, false, sweep.fname = value, value);
+    CHECK_OPTION(sweep_jobs, false, sweep.jobs = std::atoi(value), sweep.jobs);
+    CHECK_OPTION(segments, false, segments.number = std::atoi(value), segments.number);
+    CHECK_OPTION(segment_warmup, false,
+        if((segments.warmup = std::atof(value)) < 0){return false;},
+        segments.warmup << " [sec]");
+    CHECK_OPTION(checkpoint, false, checkpoint.fname = value, value);
+    CHECK_OPTION(checkpoint_pages, false,
+        if((checkpoint.pages = std::atoi(value)) <= 0){return false;},
+        checkpoint.pages);
+    CHECK_OPTION(resume, false, checkpoint.resume_fname = value, value);
+    CHECK_OPTION(resume_offset, false,
+        checkpoint.resume_offset = std::atol(value),
+        checkpoint.resume_offset << " [bytes]");
+    if(CHECK_KEY(profile)){
+#if defined(ENABLE_PROFILER) && ENABLE_PROFILER
+      const char *value(get_value(spec, key_length, true));
+      std::cerr << "profile: ";
+      if((!value) || is_true(value)){
+        profile_out = &std::cerr;
+        std::cerr << "on" << std::endl;
+      }else{
+        profile_out = &spec2ostream(value);
+        profile_in_json = true;
+      }
+#else
+      std::cerr << "(warning!) profile: ignored, please build with -DENABLE_PROFILER" << std::endl;
+#endif
+      return true;
+    }
 #undef CHECK_OPTION
     
     return super_t::check_spec(spec);
@@ -524,6 +897,71 @@ class NAV : public Updatable {
   public:
     typedef NAVData<float_sylph_t> data_t;
     typedef std::vector<const data_t *> updated_items_t;
+
+    /**
+     * Hypothesis of initial heading for --init_yaw_bank.
+     * A NAV having it outputs nothing, and accumulates log-likelihood of GPS innovations instead.
+     */
+    struct hypothesis_t {
+      float_sylph_t yaw_deg; ///< Initial heading [deg]
+      std::istream *init_misc; ///< Used instead of Options::init_misc, which is shared
+      float_sylph_t log_likelihood; ///< Sum of log-likelihood of GPS innovations
+      unsigned int corrections; ///< Number of GPS corrections
+      hypothesis_t(const float_sylph_t &_yaw_deg, std::istream *_init_misc)
+          : yaw_deg(_yaw_deg), init_misc(_init_misc), log_likelihood(0), corrections(0) {}
+    };
+    hypothesis_t *hypothesis; ///< NULL unless the NAV is a hypothesis
+
+    /**
+     * Segment of the log for --segments.
+     * A NAV having it writes the results after the beginning of the segment to its own stream,
+     * and keeps the last results of the warm-up period and of the output to check continuity.
+     */
+    struct segment_t {
+      int index; ///< 0 for the first segment, which has no warm-up period
+      float_sylph_t itow_begin; ///< GPS time of week from which results are output
+      std::ostream *out; ///< Used instead of Options::out()
+      std::istream *init_misc; ///< Used instead of Options::init_misc, which is shared
+      struct snapshot_t {
+        bool valid;
+        float_sylph_t itow; ///< Time of the packet which updated the results
+        float_sylph_t latitude, longitude, height; // [rad], [rad], [m]
+        float_sylph_t v_north, v_east, v_down; // [m/s]
+        float_sylph_t heading; // [rad]
+        snapshot_t() : valid(false) {}
+        void set(const data_t &data, const float_sylph_t &_itow){
+          itow = _itow;
+          latitude = data.latitude(); longitude = data.longitude(); height = data.height();
+          v_north = data.v_north(); v_east = data.v_east(); v_down = data.v_down();
+          heading = data.heading();
+          valid = true;
+        }
+      } warmup_end, last;
+      segment_t(const int &_index, const float_sylph_t &_itow_begin,
+          std::ostream *_out, std::istream *_init_misc)
+          : index(_index), itow_begin(_itow_begin), out(_out), init_misc(_init_misc),
+          warmup_end(), last() {}
+      /**
+       * @param itow time of the packet which updated the results
+       * @param items updated results
+       * @return (bool) true when the results are output, false during the warm-up period
+       */
+      bool output(const float_sylph_t &itow, const updated_items_t &items){
+        float_sylph_t elapsed(itow - itow_begin);
+        static const float_sylph_t week_sec(60 * 60 * 24 * 7);
+        if(elapsed < -week_sec / 2){ // week rollover
+          elapsed += week_sec;
+        }else if(elapsed >= week_sec / 2){
+          elapsed -= week_sec;
+        }
+        bool res((index == 0) || (elapsed >= 0));
+        if(!items.empty()){(res ? last : warmup_end).set(*items.back(), itow);}
+        return res;
+      }
+    };
+    segment_t *segment; ///< NULL unless the NAV processes a segment of the log
+
+    NAV() : Updatable(), hypothesis(NULL), segment(NULL) {}
     virtual ~NAV(){}
   public:
     virtual void label(std::ostream &out) const = 0;
@@ -531,7 +969,19 @@ class NAV : public Updatable {
       return updated_items_t();
     }
     virtual void inspect(std::ostream &out) const {}
-    virtual float_sylph_t &operator[](const unsigned &index) = 0;
+
+    /**
+     * Save or restore internal states
+     *
+     * @param ar archive
+     * @return (bool) true when success, false when failed or unsupported
+     */
+    virtual bool checkpoint(CheckpointArchive &ar) {return false;}
+
+    /**
+     * Output the results which are available only at the end of the log, such as the ones of --smooth
+     */
+    virtual void finish() {}
 
     template <class Container>
     static typename Container::const_iterator nearest(
@@ -633,32 +1083,66 @@ struct NAV_Factory {
       options.out() << std::endl;
     }
     void updated() const {
+      if(BaseNAV::hypothesis){return;}
+      PROFILER_SCOPE("output");
       const NAV::updated_items_t &items(BaseNAV::updated_items());
       if(items.empty()){return;}
+      std::ostream &out(BaseNAV::segment ? *(BaseNAV::segment->out) : options.out());
 
-      if(options.out_is_N_packet){
+      if(options.out_shm){
+        for(NAV::updated_items_t::const_iterator it(items.begin()), it_end(items.end());
+            it != it_end; ++it){
+          NAV_SharedMemoryRecord &rec(options.out_shm->slot());
+          rec.itow = (*it)->time_stamp();
+          rec.longitude = rad2deg((*it)->longitude());
+          rec.latitude = rad2deg((*it)->latitude());
+          rec.height = (*it)->height();
+          rec.v_north = (*it)->v_north();
+          rec.v_east = (*it)->v_east();
+          rec.v_down = (*it)->v_down();
+          rec.heading = rad2deg((*it)->heading());
+          rec.pitch = rad2deg((*it)->euler_theta());
+          rec.roll = rad2deg((*it)->euler_phi());
+          rec.azimuth = rad2deg((*it)->azimuth());
+          options.out_shm->commit();
+        }
+      }else if(options.out_is_N_packet){
         char buf[SYLPHIDE_PAGE_SIZE];
         items.back()->encode_N0(buf);
-        options.out().write(buf, sizeof(buf));
+        out.write(buf, sizeof(buf));
       }else{
         for(NAV::updated_items_t::const_iterator it(items.begin()), it_end(items.end());
             it != it_end; ++it){
-          options.out() << (**it);
+          out << (**it);
           if(options.dump_relative){
-            options.out() << ',' << options.dump_relative(**it);
+            out << ',' << options.dump_relative(**it);
           }
-          options.out() << std::endl;
+          out << std::endl;
         }
       }
 
+      if(BaseNAV::segment){return;} // the debug output is shared
       options.out_debug() << items.back()->time_stamp() << ',';
       BaseNAV::inspect(options.out_debug());
       options.out_debug() << std::endl;
     }
+    void finish(){
+      while(BaseNAV::flush()){updated();}
+    }
+    /**
+     * Template in order to defer access to members of packets,
+     * which are still incomplete types here.
+     */
+    template <class PacketT>
+    void update_packet(const PacketT &packet){
+      BaseNAV::update(packet);
+      if(BaseNAV::segment
+          && !BaseNAV::segment->output(packet.itow, BaseNAV::updated_items())){return;}
+      updated();
+    }
 #define update_func(type) \
 virtual void update(const type &packet){ \
-  BaseNAV::update(packet); \
-  updated(); \
+  update_packet(packet); \
 }
     update_func(A_Packet);
     update_func(G_Packet);
@@ -674,7 +1158,7 @@ virtual void update(const type &packet){ \
  */
 struct Packet{
   virtual ~Packet() {}
-  virtual void apply(NAV &nav) const = 0;
+  virtual void apply(Updatable &target) const = 0;
 
   float_sylph_t itow;
 
@@ -710,8 +1194,8 @@ struct Packet{
 
 template <class T>
 struct BasicPacket : public Packet {
-  void apply(NAV &nav) const {
-    nav.update(static_cast<const T &>(*this));
+  void apply(Updatable &target) const {
+    target.update(static_cast<const T &>(*this));
   }
 };
 
@@ -756,9 +1240,83 @@ struct TimePacket : public BasicPacket<TimePacket> {
   }
 };
 
+/*
+ * Save or restore values for checkpoint
+ */
+template <class FloatT>
+void archive(CheckpointArchive &ar, Vector3<FloatT> &v){
+  Vector3<FloatT> buf(ar.loading() ? Vector3<FloatT>() : v);
+  for(unsigned i(0); i < 3; ++i){ar & buf[i];}
+  v = buf;
+}
+template <class FloatT>
+void archive(CheckpointArchive &ar, Quaternion<FloatT> &q){
+  Quaternion<FloatT> buf(ar.loading() ? Quaternion<FloatT>() : q);
+  for(unsigned i(0); i < 4; ++i){ar & buf[i];}
+  q = buf;
+}
+template <class FloatT>
+void archive(CheckpointArchive &ar, Matrix<FloatT> &mat){
+  unsigned int rows(mat.rows()), columns(mat.columns());
+  ar & rows & columns;
+  if(!ar.good()){return;}
+  Matrix<FloatT> buf(ar.loading() ? Matrix<FloatT>(rows, columns) : mat);
+  for(unsigned int i(0); i < rows; ++i){
+    for(unsigned int j(0); j < columns; ++j){
+      ar & buf(i, j);
+    }
+  }
+  mat = buf;
+}
+template <class FloatT>
+void archive(CheckpointArchive &ar, INS_Preintegration<FloatT> &preintegration){
+  archive(ar, preintegration.alpha);
+  archive(ar, preintegration.beta);
+  archive(ar, preintegration.upsilon);
+  archive(ar, preintegration.gamma);
+  ar & preintegration.deltaT & preintegration.samples;
+}
+void archive(CheckpointArchive &ar, A_Packet &packet){
+  ar & packet.itow;
+  archive(ar, packet.accel);
+  archive(ar, packet.omega);
+}
+void archive(CheckpointArchive &ar, G_Packet &packet){
+  // lever_arm is not saved, it is a property of the log
+  ar & packet.itow;
+  ar.pod(static_cast<GPS_Solution<float_sylph_t> &>(packet));
+}
+void archive(CheckpointArchive &ar, M_Packet &packet){
+  ar & packet.itow;
+  archive(ar, packet.mag);
+}
+void archive(CheckpointArchive &ar, TimePacket &packet){
+  ar & packet.itow & packet.week_num & packet.leap_sec
+      & packet.valid_week_num & packet.valid_leap_sec;
+}
+template <class T>
+void archive(CheckpointArchive &ar, std::deque<T> &buf){
+  unsigned long size(buf.size());
+  ar & size;
+  if(ar.loading()){
+    buf.clear();
+    for(; (size > 0) && ar.good(); --size){
+      buf.push_back(T());
+      archive(ar, buf.back());
+    }
+  }else{
+    for(typename std::deque<T>::iterator it(buf.begin()), it_end(buf.end()); it != it_end; ++it){
+      archive(ar, *it);
+    }
+  }
+}
+
 template <class INS_GPS>
 class INS_GPS_NAVData;
 
+template <class PureINS, class TimeStamp>
+class INS_NAVData;
+
 template <class INS_GPS>
 class INS_GPS_NAV : public NAV {
   public:
@@ -771,6 +1329,26 @@ class INS_GPS_NAV : public NAV {
     ins_gps_t *ins_gps;
     Helper helper;
 
+    /**
+     * Conversion of input, whose precision is float_sylph_t, to float_t
+     */
+    static const vec3_t &cast(const vec3_t &v){return v;}
+    template <class T>
+    static vec3_t cast(const Vector3<T> &v){return vec3_t(v[0], v[1], v[2]);}
+    template <class T>
+    static vec3_t cast(const T (&v)[3]){return vec3_t(v[0], v[1], v[2]);}
+    static const GPS_Solution<float_t> &cast(const GPS_Solution<float_t> &gps){return gps;}
+    template <class T>
+    static GPS_Solution<float_t> cast(const GPS_Solution<T> &gps){
+      GPS_Solution<float_t> res;
+      res.v_n = gps.v_n; res.v_e = gps.v_e; res.v_d = gps.v_d;
+      res.sigma_vel = gps.sigma_vel;
+      res.latitude = gps.latitude; res.longitude = gps.longitude; res.height = gps.height;
+      res.sigma_2d = gps.sigma_2d; res.sigma_height = gps.sigma_height;
+      res.valid_velocity = gps.valid_velocity; res.valid_position = gps.valid_position;
+      return res;
+    }
+
     void setup_filter(void *){}
 
     template <class BaseINS, template <class> class Filter>
@@ -815,6 +1393,8 @@ class INS_GPS_NAV : public NAV {
         
         ins_gps->getFilter().setQ(Q);
       }
+
+      ins_gps->setPropagationInterval(options.propagation_interval);
     }
 
     void setup_filter(
@@ -875,6 +1455,24 @@ class INS_GPS_NAV : public NAV {
       ins_gps->setup_realtime(options.realttime_property);
     }
 
+    template <class Base_INS_GPS>
+    void setup_filter(INS_GPS_RTS_Smoother<Base_INS_GPS> *){
+      setup_filter((Base_INS_GPS *)ins_gps);
+      INS_GPS_RTS_Smoother_Property<float_t> property(options.smoother_property);
+      property.spill_fname = options.smooth_spill.empty() ? NULL : options.smooth_spill.c_str();
+      property.smooth_covariance = options.dump_stddev;
+#if defined(__unix__) || defined(__APPLE__)
+      if(property.segments == 0){
+        long cpus(sysconf(_SC_NPROCESSORS_ONLN));
+        property.segments = (cpus > 0) ? (unsigned int)cpus : 1;
+      }
+#endif
+      if(!ins_gps->setup_smoother(property)){
+        std::cerr << "(error!) smooth: spill file cannot be opened." << std::endl;
+        exit(-1);
+      }
+    }
+
     template <class Base_INS_GPS>
     void setup_filter(INS_GPS_Debug<Base_INS_GPS> *){
       setup_filter((Base_INS_GPS *)ins_gps);
@@ -891,10 +1489,11 @@ class INS_GPS_NAV : public NAV {
       delete ins_gps;
     }
 
+    template <class T>
     void setup_filter(
-        const vec3_t &accel_sigma,
-        const vec3_t &gyro_sigma){
-      setup_filter(accel_sigma, gyro_sigma, ins_gps);
+        const T (&accel_sigma)[3],
+        const T (&gyro_sigma)[3]){
+      setup_filter(cast(accel_sigma), cast(gyro_sigma), ins_gps);
     }
 
     void inspect(std::ostream &out, void *) const {}
@@ -979,11 +1578,140 @@ class INS_GPS_NAV : public NAV {
       if(std::strlen(line) == 0){return true;}
 
       bool res(init_misc(line, ins_gps));
-      if(res){
+      if(res && !hypothesis && !segment){
         std::cerr << "Init (misc): " << line << std::endl;
       }
       return res;
     }
+
+  protected:
+    static void checkpoint(CheckpointArchive &ar, void *){}
+
+    static void checkpoint(CheckpointArchive &ar, INS<float_t> *ins){
+      for(unsigned int i(0), i_end(ins->state_values()); i < i_end; ++i){
+        ar & (*ins)[i];
+      }
+      if(ar.loading()){ins->recalc(false);} // already regularized
+    }
+
+    template <class PureINS, class TimeStamp>
+    static void checkpoint(CheckpointArchive &ar, INS_NAVData<PureINS, TimeStamp> *ins){
+      ins->checkpoint_header(ar);
+      checkpoint(ar, (PureINS *)ins);
+    }
+
+    static void checkpoint(CheckpointArchive &ar, KalmanFilter<float_t> &filter){
+      mat_t P(filter.getP()), Q(filter.getQ());
+      archive(ar, P);
+      archive(ar, Q);
+      if(ar.loading()){
+        filter.setP(P);
+        filter.setQ(Q);
+      }
+    }
+
+    static void checkpoint(CheckpointArchive &ar, KalmanFilterUD<float_t> &filter){
+      // U and D are used instead of P, because decomposition of restored P would differ.
+      mat_t U(filter.getU()), D(filter.getD()), Q(filter.getQ());
+      archive(ar, U);
+      archive(ar, D);
+      archive(ar, Q);
+      if(ar.loading()){
+        filter.setUD(U, D);
+        filter.setQ(Q);
+      }
+    }
+
+    template <class BaseINS, template <class> class Filter>
+    static void checkpoint(CheckpointArchive &ar, Filtered_INS2<BaseINS, Filter> *fins){
+      // Accumulated samples are saved as they are, because flushing them changes the results.
+      ar.pod(fins->propagation());
+      checkpoint(ar, fins->getFilter_deferred());
+      checkpoint(ar, (BaseINS *)fins);
+    }
+
+    template <class BaseFINS>
+    static void checkpoint(CheckpointArchive &ar, Filtered_INS_BiasEstimated<BaseFINS> *fins){
+      archive(ar, fins->beta_accel());
+      archive(ar, fins->beta_gyro());
+      ar & fins->deltaT_sum();
+#if BIAS_EST_MODE == 1
+      archive(ar, fins->modified_bias_accel());
+      archive(ar, fins->modified_bias_gyro());
+#elif BIAS_EST_MODE == 2
+      ar & fins->deltaT_sum_previous();
+      archive(ar, fins->drift_bias_accel_sum());
+      archive(ar, fins->drift_bias_gyro_sum());
+#endif
+      checkpoint(ar, (BaseFINS *)fins);
+    }
+
+    template <class Base_INS_GPS>
+    static void checkpoint(CheckpointArchive &ar, INS_GPS_Back_Propagate<Base_INS_GPS> *ins){
+      typedef typename INS_GPS_Back_Propagate<Base_INS_GPS>::snapshots_t snapshots_t;
+      snapshots_t &snapshots(ins->get_snapshots());
+      unsigned long size(snapshots.size());
+      ar & size;
+      if(ar.loading()){
+        snapshots.clear();
+        for(; (size > 0) && ar.good(); --size){
+          Base_INS_GPS ins_gps;
+          mat_t Phi, GQGt;
+          float_t elapsedT;
+          checkpoint(ar, &ins_gps);
+          archive(ar, Phi);
+          archive(ar, GQGt);
+          ar & elapsedT;
+          snapshots.push_back(typename snapshots_t::value_type(ins_gps, Phi, GQGt, elapsedT));
+        }
+      }else{
+        for(typename snapshots_t::iterator it(snapshots.begin()), it_end(snapshots.end());
+            it != it_end; ++it){
+          checkpoint(ar, &(it->ins_gps));
+          archive(ar, it->Phi);
+          archive(ar, it->GQGt);
+          ar & it->elapsedT_from_last_correct;
+        }
+      }
+      checkpoint(ar, (Base_INS_GPS *)ins);
+    }
+
+    template <class Base_INS_GPS>
+    static void checkpoint(CheckpointArchive &ar, INS_GPS_RealTime<Base_INS_GPS> *ins){
+      typedef typename INS_GPS_RealTime<Base_INS_GPS>::snapshots_t snapshots_t;
+      snapshots_t &snapshots(ins->get_snapshots());
+      unsigned int size(snapshots.size());
+      ar & size;
+      if(ar.loading()){
+        snapshots.clear();
+        if(size > snapshots.capacity()){
+          ar.invalidate();
+          return;
+        }
+      }
+      for(unsigned int i(0); (i < size) && ar.good(); ++i){
+        typename INS_GPS_RealTime<Base_INS_GPS>::snapshot_content_t &snapshot(
+            ar.loading() ? snapshots.push_back() : snapshots[i]);
+        checkpoint(ar, (INS<float_t> *)&snapshot.ins_gps);
+        archive(ar, snapshot.A);
+        archive(ar, snapshot.Gamma);
+        archive(ar, snapshot.Phi_inv);
+        archive(ar, snapshot.GQGt);
+        ar & snapshot.elapsedT_from_last_update;
+      }
+      checkpoint(ar, (Base_INS_GPS *)ins);
+    }
+
+  public:
+    /**
+     * Save or restore the filter and the helper, where debug information such as
+     * the covariance snapshot of --debug is excluded.
+     */
+    bool checkpoint(CheckpointArchive &ar){
+      checkpoint(ar, ins_gps);
+      helper.checkpoint(ar);
+      return ar.good();
+    }
     
     float_t &operator[](const unsigned &index){return ins_gps->operator[](index);}
     
@@ -991,13 +1719,44 @@ class INS_GPS_NAV : public NAV {
         const vec3_t &accel,
         const vec3_t &gyro,
         const float_t &elapsedT){
+      PROFILER_SCOPE("time_update");
       ins_gps->update(accel, gyro, elapsedT);
       return *this;
     }
   
+  protected:
+    static float_t log_likelihood(void *,
+        const G_Packet &gps, const vec3_t *lever_arm_b, const vec3_t *omega_b2i_4b){
+      return 0;
+    }
+
+    /**
+     * Log-likelihood of GPS innovation @f$ \ln N(z; 0, H P H^{T} + R) @f$ for --init_yaw_bank.
+     * The gyro bias is not subtracted from omega_b2i_4b, because its effect is negligible.
+     */
+    template <class BaseFINS>
+    static float_t log_likelihood(INS_GPS2<BaseFINS> *ins,
+        const G_Packet &gps, const vec3_t *lever_arm_b, const vec3_t *omega_b2i_4b){
+      CorrectInfo<float_t> info(lever_arm_b
+          ? ins->correct_info(cast(gps), *lever_arm_b, *omega_b2i_4b)
+          : ins->correct_info(cast(gps)));
+      mat_t S(info.H * ins->getP() * info.H.transpose() + info.R);
+      return -((info.z.transpose() * S.inverse() * info.z)(0, 0)
+          + std::log(S.determinant()) + std::log(M_PI * 2) * S.rows()) / 2;
+    }
+
+    void check_hypothesis(
+        const G_Packet &gps,
+        const vec3_t *lever_arm_b = NULL, const vec3_t *omega_b2i_4b = NULL){
+      if(!hypothesis){return;}
+      hypothesis->log_likelihood += log_likelihood(ins_gps, gps, lever_arm_b, omega_b2i_4b);
+      ++(hypothesis->corrections);
+    }
+
   public:
     NAV &correct(const G_Packet &gps){
-      ins_gps->correct(gps);
+      check_hypothesis(gps);
+      ins_gps->correct(cast(gps));
       return *this;
     }
 
@@ -1005,7 +1764,8 @@ class INS_GPS_NAV : public NAV {
         const G_Packet &gps,
         const vec3_t &lever_arm_b,
         const vec3_t &omega_b2i_4b){
-      ins_gps->correct(gps, lever_arm_b, omega_b2i_4b);
+      check_hypothesis(gps, &lever_arm_b, &omega_b2i_4b);
+      ins_gps->correct(cast(gps), lever_arm_b, omega_b2i_4b);
       return *this;
     }
 
@@ -1055,6 +1815,15 @@ class INS_GPS_NAV : public NAV {
       return helper.updated_items();
     }
 
+    /**
+     * Prepare the next result kept until the end of the log, which is returned by updated_items()
+     *
+     * @return (bool) true when prepared, false when no result remains
+     */
+    bool flush(){
+      return helper.flush();
+    }
+
     void update(const A_Packet &packet){
       helper.before_any_update();
       helper.time_update(packet);
@@ -1072,12 +1841,43 @@ class INS_GPS_NAV : public NAV {
     }
 };
 
+#if defined(ENABLE_PROFILER) && ENABLE_PROFILER
+/**
+ * Outermost layer for --profile, which measures the call-back of the time update
+ * overridden by the synchronization and debug layers.
+ */
+template <class INS_GPS>
+class INS_GPS_Profiled : public INS_GPS {
+  public:
+#if defined(__GNUC__) && (__GNUC__ < 5)
+    typedef typename INS_GPS::float_t float_t;
+    typedef typename INS_GPS::mat_t mat_t;
+#else
+    using typename INS_GPS::float_t;
+    using typename INS_GPS::mat_t;
+#endif
+    INS_GPS_Profiled() : INS_GPS() {}
+    INS_GPS_Profiled(const INS_GPS_Profiled<INS_GPS> &orig, const bool &deepcopy = false)
+        : INS_GPS(orig, deepcopy) {}
+    ~INS_GPS_Profiled(){}
+  protected:
+    void before_update_INS(const mat_t &A, const mat_t &B, const float_t &elapsedT){
+      PROFILER_SCOPE("before_update_INS");
+      INS_GPS::before_update_INS(A, B, elapsedT);
+    }
+};
+#endif
+
 template <class INS_GPS>
 struct INS_GPS_NAV_Factory : public NAV_Factory<INS_GPS> {
 
   template <class Calibration>
   static NAV *generate(const Calibration &calibration){
+#if defined(ENABLE_PROFILER) && ENABLE_PROFILER
+    typedef INS_GPS_NAV_Factory<INS_GPS_NAV<INS_GPS_Profiled<INS_GPS> > > nav_t;
+#else
     typedef INS_GPS_NAV_Factory<INS_GPS_NAV<INS_GPS> > nav_t;
+#endif
     typename nav_t::disp_t *res(new typename nav_t::disp_t());
     res->setup_filter(calibration.sigma_accel().values, calibration.sigma_gyro().values);
     return res;
@@ -1088,7 +1888,7 @@ struct INS_GPS_NAV_Factory : public NAV_Factory<INS_GPS> {
   struct Checker {
     template <class Calibration>
     static NAV *check_covariance(const Calibration &calibration){
-      typedef INS_GPS_Debug_Property<float_sylph_t> prop_t;
+      typedef INS_GPS_Debug_Property<float_ins_t> prop_t;
       switch(options.debug_property.debug_target){
         case prop_t::DEBUG_KF_P:
         case prop_t::DEBUG_KF_FULL:
@@ -1106,6 +1906,8 @@ struct INS_GPS_NAV_Factory : public NAV_Factory<INS_GPS> {
           return Checker<INS_GPS_Back_Propagate<T> >::check_covariance(calibration);
         case Options::INS_GPS_SYNC_REALTIME:
           return Checker<INS_GPS_RealTime<T> >::check_covariance(calibration);
+        case Options::INS_GPS_SYNC_SMOOTHING:
+          return Checker<INS_GPS_RTS_Smoother<T> >::check_covariance(calibration);
         case Options::INS_GPS_SYNC_OFFLINE:
         default:
           return check_covariance(calibration);
@@ -1119,7 +1921,7 @@ struct INS_GPS_NAV_Factory : public NAV_Factory<INS_GPS> {
 
     template <class Calibration>
     static NAV *check_pure_ins(const Calibration &calibration){
-      typedef INS_GPS_Debug_Property<float_sylph_t> prop_t;
+      typedef INS_GPS_Debug_Property<float_ins_t> prop_t;
       return (options.debug_property.debug_target == prop_t::DEBUG_PURE_INERTIAL)
           ? Checker<INS_GPS_Debug_PureInertial<T> >::check_navdata(calibration)
           : check_navdata(calibration);
@@ -1144,9 +1946,9 @@ struct INS_GPS_NAV_Factory : public NAV_Factory<INS_GPS> {
 };
 
 template <class PureINS, class TimeStamp = typename PureINS::float_t>
-class INS_NAVData : public PureINS, public NAVData<typename PureINS::float_t> {
+class INS_NAVData : public PureINS, public NAVData<float_sylph_t> {
   public:
-    typedef NAVData<typename PureINS::float_t> super_data_t;
+    typedef NAVData<float_sylph_t> super_data_t;
     typedef TimeStamp time_stamp_t;
   protected:
     mutable const char *mode;
@@ -1157,7 +1959,7 @@ class INS_NAVData : public PureINS, public NAVData<typename PureINS::float_t> {
         : PureINS(orig, deepcopy), mode(orig.mode), itow(orig.itow) {}
     ~INS_NAVData(){}
 #define MAKE_PROXY_FUNC(fname) \
-typename PureINS::float_t fname() const {return PureINS::fname();}
+float_sylph_t fname() const {return PureINS::fname();}
     MAKE_PROXY_FUNC(longitude);
     MAKE_PROXY_FUNC(latitude);
     MAKE_PROXY_FUNC(height);
@@ -1170,7 +1972,14 @@ typename PureINS::float_t fname() const {return PureINS::fname();}
     MAKE_PROXY_FUNC(euler_psi);
     MAKE_PROXY_FUNC(azimuth);
 #undef MAKE_PROXY_FUNC
-    typename PureINS::float_t time_stamp() const {return (typename PureINS::float_t)itow;}
+    float_sylph_t time_stamp() const {return (float_sylph_t)itow;}
+
+    void update(
+        const typename PureINS::vec3_t &accel, const typename PureINS::vec3_t &gyro,
+        const typename PureINS::float_t &deltaT){
+      PROFILER_SCOPE("mechanization");
+      PureINS::update(accel, gyro, deltaT);
+    }
 
     void set_header(const char *_mode) const {
       mode = _mode;
@@ -1179,6 +1988,18 @@ typename PureINS::float_t fname() const {return PureINS::fname();}
       mode = _mode;
       itow = _itow;
     }
+    void checkpoint_header(CheckpointArchive &ar) const {
+      static const char *modes[] = {"N/A", "TU", "MU", "BP_TU", "BP_MU", "SM_TU", "SM_MU"};
+      static const int modes_size(sizeof(modes) / sizeof(modes[0]));
+      int index(0);
+      while((index < modes_size) && (std::strcmp(modes[index], mode) != 0)){index++;}
+      ar & index;
+      if(ar.loading()){
+        if((index < 0) || (index >= modes_size)){ar.invalidate(); return;}
+        mode = modes[index];
+      }
+      ar.pod(itow);
+    }
 
     static struct label_time_t {
       template <class T>
@@ -1321,8 +2142,7 @@ class INS_GPS_NAVData : public INS_GPS {
         std::ostream &out, const Filtered_INS_BiasEstimated<BaseFINS> *fins) const {
       dump2(out, (const BaseFINS *)fins);
       if(options.dump_stddev){
-        const mat_t &P(
-            const_cast<Filtered_INS_BiasEstimated<BaseFINS> *>(fins)->getFilter().getP());
+        const mat_t P(fins->getP());
         for(int i(Filtered_INS_BiasEstimated<BaseFINS>::P_SIZE_WITHOUT_BIAS), j(0);
             j < Filtered_INS_BiasEstimated<BaseFINS>::P_SIZE_BIAS; ++i, ++j){
           out << ',' << sqrt(P(i, i));
@@ -1352,6 +2172,9 @@ class StreamProcessor
 
   protected:
     Updatable *updatable;
+    istream *in;
+    int invoked;
+    ComportStream::buf_t::time_ns_t arrival;
 
     typedef AbstractSylphideProcessor<float_sylph_t> super_t;
     typedef A_Packet_Observer<float_sylph_t> A_Observer_t;
@@ -1364,6 +2187,22 @@ class StreamProcessor
       Handler &operator=(const Handler &another){
         return *this;
       }
+      /**
+       * Save or restore bytes remaining in an observer
+       */
+      template <class Observer>
+      static void checkpoint(CheckpointArchive &ar, Observer &observer, bool &previous_seek_next){
+        unsigned int stored(observer.stored());
+        ar & stored & previous_seek_next;
+        if((!ar.good()) || (stored > observer.size())){ar.invalidate(); return;}
+        std::vector<char> buf(stored + 1);
+        if(!ar.loading()){observer.inspect(&buf[0], stored);}
+        ar.bytes(&buf[0], stored);
+        if(ar.loading()){
+          observer.skip(observer.stored());
+          observer.write(&buf[0], stored);
+        }
+      }
     };
 
     /**
@@ -1385,6 +2224,7 @@ class StreamProcessor
       }
       ~AHandler(){}
       void operator()(const A_Observer_t &observer){
+        PROFILER_SCOPE("AHandler");
         if(!observer.validate()){return;}
 
         float_sylph_t itow(observer.fetch_ITOW());
@@ -1405,6 +2245,10 @@ class StreamProcessor
 
         Handler::outer.updatable->update(packet_latest);
       }
+      void checkpoint(CheckpointArchive &ar){
+        Handler::checkpoint(ar, *this, previous_seek_next);
+        archive(ar, packet_latest);
+      }
     } a_handler;
 
     /**
@@ -1488,6 +2332,7 @@ class StreamProcessor
        * {class, id} = {0x01, 0x12} : velocity
        */
       void check_nav(const G_Observer_t &observer, const G_Observer_t::packet_type_t &packet_type){
+        const char *msg(observer.message());
         switch(packet_type.mid){
           case 0x02:   // NAV-POSLLH
           case 0x14: { // NAV-HPPOSLLH
@@ -1498,20 +2343,20 @@ class StreamProcessor
 
             if(packet_type.mid == 0x14){
               // Assumption, 0x02 and 0x14 are generated before 0x12
-              if((observer[6 + 3] & 0x01) != 0){return;} // invalid?
-              itow_ms = observer.fetch_ITOW_ms(4);
+              if((msg[6 + 3] & 0x01) != 0){return;} // invalid?
+              itow_ms = G_Observer_t::decode_ITOW_ms(msg, 4);
               if(itow_ms == itow_ms_0x0102){ // when 0x0102 comes earlier
                 packet_latest.valid_position = false; // accept overwrite with 0x0114
               }
-              position = observer.fetch_position_hp();
-              position_acc = observer.fetch_position_acc_hp();
+              position = G_Observer_t::decode_position_hp(msg);
+              position_acc = G_Observer_t::decode_position_acc_hp(msg);
             }else{
-              itow_ms = observer.fetch_ITOW_ms();
+              itow_ms = G_Observer_t::decode_ITOW_ms(msg);
               if(itow_ms == itow_ms_0x0102){ // when 0x0114 comes earlier
                 return; // skip 0x0102.
               }
-              position = observer.fetch_position();
-              position_acc = observer.fetch_position_acc();
+              position = G_Observer_t::decode_position(msg);
+              position_acc = G_Observer_t::decode_position_acc(msg);
             }
 
             //cerr << "G_Arrive 0x02 : " << observer.fetch_ITOW() << endl;
@@ -1535,12 +2380,12 @@ class StreamProcessor
             return;
           }
           case 0x03: { // NAV-STATUS
-            G_Observer_t::status_t st(observer.fetch_status());
+            G_Observer_t::status_t st(G_Observer_t::decode_status(msg));
             status.gps = st.fix_type;
             return;
           }
           case 0x06: { // NAV-SOL
-            G_Observer_t::solution_t solution(observer.fetch_solution());
+            G_Observer_t::solution_t solution(G_Observer_t::decode_solution(msg));
             if(solution.status_flags & G_Observer_t::solution_t::WN_VALID){
               update_week_number(solution.week);
             }
@@ -1548,9 +2393,9 @@ class StreamProcessor
           }
           case 0x12: { // NAV-VELNED
             G_Observer_t::velocity_t
-                velocity(observer.fetch_velocity());
+                velocity(G_Observer_t::decode_velocity(msg));
             G_Observer_t::velocity_acc_t
-                velocity_acc(observer.fetch_velocity_acc());
+                velocity_acc(G_Observer_t::decode_velocity_acc(msg));
 
             //cerr << "G_Arrive 0x12 : " << current_itow << " =? " << packet.itow << endl;
 
@@ -1558,7 +2403,7 @@ class StreamProcessor
               update_PV(itow_ms_0x0112);
             }
 
-            itow_ms_0x0112 = observer.fetch_ITOW_ms();
+            itow_ms_0x0112 = G_Observer_t::decode_ITOW_ms(msg);
 
             packet_latest.v_n = velocity.north;
             packet_latest.v_e = velocity.east;
@@ -1573,9 +2418,8 @@ class StreamProcessor
           }
           case 0x20: { // NAV-TIMEGPS
             TimePacket packet;
-            packet.itow = observer.fetch_ITOW();
-            char buf[4];
-            observer.inspect(buf, sizeof(buf), 6 + 8);
+            packet.itow = (float_sylph_t)1E-3 * G_Observer_t::decode_ITOW_ms(msg);
+            const char *buf(msg + 6 + 8);
             if(packet.valid_week_num = ((unsigned char)buf[3] & 0x02)){
               // valid week number
               update_week_number(packet.week_num = le_char2_2_num<unsigned short>(*buf));
@@ -1621,6 +2465,13 @@ class StreamProcessor
           case 0x02: check_rxm(observer, packet_type); break;
         }
       }
+
+      void checkpoint(CheckpointArchive &ar){
+        Handler::checkpoint(ar, *this, previous_seek_next);
+        archive(ar, packet_latest);
+        ar & itow_ms_0x0102 & itow_ms_0x0112 & week_number;
+        ar.pod(status);
+      }
     } g_handler;
 
     struct MHandler : public M_Observer_t, public Handler {
@@ -1664,16 +2515,16 @@ class StreamProcessor
 
         Handler::outer.updatable->update(packet_latest);
       }
+      void checkpoint(CheckpointArchive &ar){
+        Handler::checkpoint(ar, *this, previous_seek_next);
+        archive(ar, packet_latest);
+      }
     } m_handler;
-
-  protected:
-    int invoked;
-    istream *in;
     
   public:
     StreamProcessor()
         : super_t(), updatable(&updatable_blackhole),
-        in(NULL), invoked(0),
+        in(NULL), invoked(0), arrival(0),
         a_handler(*this),
         g_handler(*this),
         m_handler(*this) {
@@ -1681,7 +2532,7 @@ class StreamProcessor
     }
     StreamProcessor(const StreamProcessor &another)
         : super_t(another), updatable(another.updatable),
-        in(another.in), invoked(another.invoked),
+        in(another.in), invoked(another.invoked), arrival(another.arrival),
         a_handler(*this),
         g_handler(*this),
         m_handler(*this) {
@@ -1703,20 +2554,67 @@ class StreamProcessor
       return in;
     }
 
+    Vector3<float_sylph_t> *lever_arm() const {
+      return g_handler.packet_latest.lever_arm;
+    }
+
     /**
-     * Process stream in units of 1 page
-     * 
-     * @param in stream
+     * @return (std::streamoff) size of processed log in bytes
+     */
+    std::streamoff processed_bytes() const {
+      return (std::streamoff)invoked * SYLPHIDE_PAGE_SIZE;
+    }
+
+    /**
+     * @return arrival time of the last processed page in ComportStream::buf_t::monotonic_ns(),
+     * or 0 when the input is not a serial port.
+     */
+    const ComportStream::buf_t::time_ns_t &arrival_ns() const {
+      return arrival;
+    }
+
+    /**
+     * Save or restore decoder states, where the input stream is excluded.
+     */
+    void checkpoint(CheckpointArchive &ar){
+      ar & invoked;
+      a_handler.checkpoint(ar);
+      g_handler.checkpoint(ar);
+      m_handler.checkpoint(ar);
+    }
+
+    /**
+     * Skip input without processing, for example, to resume
+     *
+     * @param bytes size to be skipped
      * @return (bool) true when success, otherwise false.
      */
-    bool process_1page(){
-      char buffer[SYLPHIDE_PAGE_SIZE];
-      
+    bool skip(std::streamoff bytes){
+      if(bytes <= 0){return true;}
+      if(!in->seekg(bytes, ios::cur).fail()){return true;}
+      in->clear(); // unseekable, such as a pipe
+      for(char buffer[0x1000]; bytes > 0; bytes -= in->gcount()){
+        in->read(buffer, (std::streamsize)((bytes > (std::streamoff)sizeof(buffer)) ? sizeof(buffer) : bytes));
+        if(in->gcount() == 0){return false;}
+      }
+      return true;
+    }
+
+    /**
+     * Read 1 page from stream
+     *
+     * @param buffer destination
+     * @return (int) read size in bytes, or 0 when failed
+     */
+    int read_1page(char (&buffer)[SYLPHIDE_PAGE_SIZE]){
       int read_count;
       in->read(buffer, SYLPHIDE_PAGE_SIZE);
       read_count = static_cast<int>(in->gcount());
-      if(in->fail() || (read_count == 0)){return false;}
+      if(in->fail() || (read_count == 0)){return 0;}
       invoked++;
+      if(ComportStream::buf_t *com = dynamic_cast<ComportStream::buf_t *>(in->rdbuf())){
+        arrival = com->arrival_ns();
+      }
     
 #if DEBUG
       cerr << "--read-- : " << invoked << " page" << endl;
@@ -1736,14 +2634,25 @@ class StreamProcessor
         cerr << "--skipped-- : " << invoked << " page ; count = " << read_count << endl;
 #endif
       }
+      return read_count;
+    }
 
+    /**
+     * Process 1 page, which can be called from a thread other than the one of read_1page().
+     *
+     * @param buffer page
+     * @param read_count size of page
+     * @return (bool) true when success, otherwise false.
+     */
+    bool process(char *buffer, const int &read_count){
       switch(buffer[0]){
         case 'A':
           super_t::process_packet(
               buffer, read_count,
               a_handler, a_handler.previous_seek_next, a_handler);
           break;
-        case 'G':
+        case 'G': {
+          PROFILER_SCOPE("G_Packet_Observer");
           super_t::process_packet(
               buffer, read_count,
               g_handler, g_handler.previous_seek_next, g_handler);
@@ -1751,6 +2660,7 @@ class StreamProcessor
             return false;
           }
           break;
+        }
         case 'M':
           if(!options.use_magnet){break;}
           super_t::process_packet(
@@ -1762,6 +2672,19 @@ class StreamProcessor
       return true;
     }
 
+    /**
+     * Process stream in units of 1 page
+     * 
+     * @param in stream
+     * @return (bool) true when success, otherwise false.
+     */
+    bool process_1page(){
+      PROFILER_SCOPE("process_1page");
+      char buffer[SYLPHIDE_PAGE_SIZE];
+      int read_count(read_1page(buffer));
+      return (read_count > 0) && process(buffer, read_count);
+    }
+
     bool check_spec(const char *spec, const bool &dry_run = false){
       const char *value;
       if(value = Options::get_value(spec, "calib_file", false)){ // calibration file
@@ -1802,6 +2725,7 @@ class INS_GPS_NAV<INS_GPS>::Helper {
       TIME_UPDATED,
       MEASUREMENT_UPDATED,
       WAITING_UPDATE,
+      SMOOTHED,
     } status;
     INS_GPS_NAV<INS_GPS> &nav;
     const int min_a_packets_for_init; // must be greater than 0
@@ -1824,14 +2748,16 @@ class INS_GPS_NAV<INS_GPS>::Helper {
     typedef PacketBuffer<M_Packet> recent_m_t;
     recent_m_t recent_m;
 
-    vec3_t get_mag(const float_t &itow){
+    INS_Preintegration<float_t> preintegration; ///< A packets not applied yet, see --preintegrate
+
+    Vector3<float_sylph_t> get_mag(const float_sylph_t &itow){
       if(recent_m.buf.size() < 2){
-        return vec3_t(1, 0, 0); // heading is north
+        return Vector3<float_sylph_t>(1, 0, 0); // heading is north
       }
       typename recent_m_t::buf_t::const_iterator
           it_a(nearest(recent_m.buf, itow, 2)),
           it_b(it_a + 1);
-      float_t
+      float_sylph_t
           weight_a((it_b->itow - itow) / (it_b->itow - it_a->itow)),
           weight_b(1. - weight_a);
       /* Reduce excessive extrapolation.
@@ -1851,9 +2777,10 @@ class INS_GPS_NAV<INS_GPS>::Helper {
     template <class TimeStamp>
     struct TimeStampGenerator {
       void update(const TimePacket &packet){}
-      TimeStamp operator()(const float_t &t, const int &wn = 0) const {
+      TimeStamp operator()(const float_sylph_t &t, const int &wn = 0) const {
         return (TimeStamp)t;
       }
+      void checkpoint(CheckpointArchive &ar){}
     };
 
     template <class FloatT>
@@ -1873,6 +2800,9 @@ class INS_GPS_NAV<INS_GPS>::Helper {
       stamp_t operator()(const FloatT &itow, const int &wn) const {
         return stamp_t(itow2calendar.convert(itow, wn), itow);
       }
+      void checkpoint(CheckpointArchive &ar){
+        ar.pod(itow2calendar);
+      }
     };
 
     TimeStampGenerator<typename INS_GPS::time_stamp_t> t_stamp_generator;
@@ -1887,11 +2817,20 @@ class INS_GPS_NAV<INS_GPS>::Helper {
       recent_m.push(packet);
     }
 
+    void checkpoint(CheckpointArchive &ar){
+      ar.pod(status);
+      archive(ar, recent_a.buf);
+      archive(ar, recent_m.buf);
+      archive(ar, preintegration);
+      t_stamp_generator.checkpoint(ar);
+    }
+
     Helper(INS_GPS_NAV<INS_GPS> &_nav)
         : status(UNINITIALIZED), nav(_nav),
         min_a_packets_for_init(options.initial_attitude.mode == options.initial_attitude.FULL_GIVEN ? 1 : 0x10),
         recent_a(max(min_a_packets_for_init, 0x100)),
         recent_m(0x10),
+        preintegration(),
         t_stamp_generator() {
     }
   
@@ -1904,7 +2843,7 @@ class INS_GPS_NAV<INS_GPS>::Helper {
       // When smoothing is activated
       switch(status){
         case MEASUREMENT_UPDATED: {
-          float_t itow(recent_a.buf.back().itow);
+          float_sylph_t itow(recent_a.buf.back().itow);
           typedef typename INS_GPS_Back_Propagate<Base_INS_GPS>::snapshots_t snapshots_t;
           const snapshots_t &snapshots(ins_gps->get_snapshots());
           int index(0);
@@ -1927,11 +2866,33 @@ class INS_GPS_NAV<INS_GPS>::Helper {
           }
           break;
         }
+        case SMOOTHED: // never reached, only for --smooth
+        default:
+          break;
       }
 
       return res;
     }
 
+    /**
+     * In the forward pass of --smooth, the epochs which would be output are marked instead.
+     * Their smoothed results are output by flush().
+     */
+    template <class Base_INS_GPS>
+    NAV::updated_items_t updated_items(
+        const INS_GPS_RTS_Smoother<Base_INS_GPS> *ins_gps) const {
+      NAV::updated_items_t res;
+      if(status == SMOOTHED){
+        res.push_back(ins_gps->get_output());
+        return res;
+      }
+      const NAV::updated_items_t &items(updated_items((void *)NULL));
+      if(!items.empty()){
+        nav.ins_gps->mark(items.back()->time_stamp(), (status == TIME_UPDATED) ? 0 : 1);
+      }
+      return res;
+    }
+
     NAV::updated_items_t updated_items(void *) const {
       NAV::updated_items_t res;
 
@@ -1945,6 +2906,9 @@ class INS_GPS_NAV<INS_GPS>::Helper {
           if(!options.dump_correct){break;}
           res.push_back(nav.ins_gps);
           break;
+        case SMOOTHED: // output by flush()
+        default:
+          break;
       }
       return res;
     }
@@ -1955,7 +2919,33 @@ class INS_GPS_NAV<INS_GPS>::Helper {
     }
 
   protected:
-    void time_update(const A_Packet &a_packet, float_t deltaT){
+    bool flush(void *){return false;}
+
+    template <class Base_INS_GPS>
+    bool flush(INS_GPS_RTS_Smoother<Base_INS_GPS> *ins_gps){
+      if(!ins_gps->smooth()){
+        if(!nav.hypothesis){
+          cerr << "(error!) smooth: spill file cannot be extended, no result is output." << endl;
+        }
+        return false;
+      }
+      static const char *modes[] = {"SM_TU", "SM_MU"};
+      double t;
+      unsigned int tag;
+      const typename INS_GPS_RTS_Smoother<Base_INS_GPS>::output_t *item(ins_gps->next(t, tag));
+      if(!item){return false;}
+      item->set_header(modes[tag], t_stamp_generator(t));
+      status = SMOOTHED;
+      return true;
+    }
+
+  public:
+    bool flush(){
+      return flush(nav.ins_gps);
+    }
+
+  protected:
+    void time_update(const A_Packet &a_packet, float_sylph_t deltaT){
 
       static const int one_week(60 * 60 * 7 * 24);
       if(deltaT <= -(one_week / 2)){ // Check roll over
@@ -1969,7 +2959,23 @@ class INS_GPS_NAV<INS_GPS>::Helper {
         return;
       }
 
-      nav.update(a_packet.accel, a_packet.omega, deltaT);
+      if(options.preintegrate > 1){
+        preintegration.add(cast(a_packet.accel), cast(a_packet.omega), deltaT);
+        if(preintegration.size() >= options.preintegrate){flush_preintegration();}
+        return;
+      }
+
+      nav.update(cast(a_packet.accel), cast(a_packet.omega), deltaT);
+      status = TIME_UPDATED;
+    }
+
+    /**
+     * Perform time update with the preintegrated A packets if exist.
+     */
+    void flush_preintegration(){
+      if(preintegration.empty()){return;}
+      nav.update(preintegration.accel(), preintegration.gyro(), preintegration.interval());
+      preintegration.clear();
       status = TIME_UPDATED;
     }
 
@@ -1985,7 +2991,7 @@ class INS_GPS_NAV<INS_GPS>::Helper {
         const A_Packet &previous(recent_a.buf.back());
 
         // Check interval from the last time update
-        float_t deltaT(previous.interval(a_packet));
+        float_sylph_t deltaT(previous.interval(a_packet));
         time_update(a_packet, deltaT);
         nav.ins_gps->set_header("TU",  t_stamp_generator(a_packet.itow));
       }
@@ -2009,13 +3015,13 @@ class INS_GPS_NAV<INS_GPS>::Helper {
     }
 
     void initialize(
-        const float_t &itow,
-        const float_t &latitude,
-        const float_t &longitude,
-        const float_t &height,
-        const float_t &v_north,
-        const float_t &v_east,
-        const float_t &v_down){
+        const float_sylph_t &itow,
+        const float_sylph_t &latitude,
+        const float_sylph_t &longitude,
+        const float_sylph_t &height,
+        const float_sylph_t &v_north,
+        const float_sylph_t &v_east,
+        const float_sylph_t &v_down){
 
       float_t
           yaw(deg2rad(options.initial_attitude.yaw_deg)),
@@ -2030,7 +3036,7 @@ class INS_GPS_NAV<INS_GPS>::Helper {
         for(typename recent_a_t::buf_t::iterator it(recent_a.buf.begin()), it_end(recent_a.buf.end());
             it != it_end;
             ++it){
-          acc += it->accel;
+          acc += cast(it->accel);
         }
         acc /= recent_a.buf.size();
         vec3_t acc_reg(-acc / acc.abs());
@@ -2050,41 +3056,52 @@ class INS_GPS_NAV<INS_GPS>::Helper {
         }
         break;
       }
+      if(nav.hypothesis){yaw = deg2rad(nav.hypothesis->yaw_deg);}
+      if(nav.segment && (nav.segment->index > 0)
+          && (std::sqrt(pow(v_north, 2) + pow(v_east, 2)) >= 1)){
+        // Segments started in the middle of the log use the heading of GPS velocity.
+        yaw = std::atan2(v_east, v_north);
+      }
 
       status = JUST_INITIALIZED;
 
-      cerr << "Init : " << setprecision(10) << itow << endl;
-      cerr << "Initial attitude (yaw, pitch, roll) [deg]: "
-          << rad2deg(yaw) << ", "
-          << rad2deg(pitch) << ", "
-          << rad2deg(roll) << endl;
+      if(!nav.hypothesis && !nav.segment){
+        cerr << "Init : " << setprecision(10) << itow << endl;
+        cerr << "Initial attitude (yaw, pitch, roll) [deg]: "
+            << rad2deg(yaw) << ", "
+            << rad2deg(pitch) << ", "
+            << rad2deg(roll) << endl;
+      }
 
       nav.ins_gps->initPosition(latitude, longitude, height);
       nav.ins_gps->initVelocity(v_north, v_east, v_down);
       nav.ins_gps->initAttitude(yaw, pitch, roll);
 
-      options.dump_relative.set_base(latitude, longitude);
+      if(!nav.hypothesis){options.dump_relative.set_base(latitude, longitude);}
 
-      for(char buf[0x4000]; !options.init_misc->eof(); ){ // Miscellaneous setup
-        options.init_misc->getline(buf, sizeof(buf));
+      std::istream &init_misc(nav.hypothesis
+          ? *(nav.hypothesis->init_misc)
+          : (nav.segment ? *(nav.segment->init_misc) : *options.init_misc));
+      for(char buf[0x4000]; !init_misc.eof(); ){ // Miscellaneous setup
+        init_misc.getline(buf, sizeof(buf));
         nav.init_misc(buf);
       }
     }
 
-    void time_update_before_measurement_update(const float_t &advanceT, void *){
+    void time_update_before_measurement_update(const float_sylph_t &advanceT, void *){
       if(advanceT <= 0){return;}
       // Time update up to the GPS observation
       time_update(recent_a.buf.back(), advanceT);
     }
 
     template <class Base_INS_GPS>
-    void time_update_before_measurement_update(const float_t &advanceT, INS_GPS_RealTime<Base_INS_GPS> *){
+    void time_update_before_measurement_update(const float_sylph_t &advanceT, INS_GPS_RealTime<Base_INS_GPS> *){
       return;
     }
 
     bool check_time_synchronization(const Packet &packet) const {
       if(recent_a.buf.empty()){return false;}
-      float_t
+      float_sylph_t
           delta_base(recent_a.buf.front().interval_rollover(recent_a.buf.back())), // a.newest - a.oldest
           delta(recent_a.buf.back().interval_rollover(packet)); // packet - a.newest
       return (delta_base >= 0) // newest > oldest
@@ -2106,25 +3123,27 @@ class INS_GPS_NAV<INS_GPS>::Helper {
         return;
       }
       if(status >= JUST_INITIALIZED){
-        cerr << "MU : " << setprecision(10) << g_packet.itow << endl;
+        if(!nav.hypothesis && !nav.segment){cerr << "MU : " << setprecision(10) << g_packet.itow << endl;}
         
         // calculate GPS data timing;
         // negative(realtime mode, delayed), or slightly positive(other modes, because of already sorted)
-        float_t gps_advance(recent_a.buf.back().interval(g_packet));
+        float_sylph_t gps_advance(recent_a.buf.back().interval(g_packet));
         time_update_before_measurement_update(gps_advance, nav.ins_gps);
+        flush_preintegration();
 
+        PROFILER_SCOPE("gps_correction");
         if(g_packet.lever_arm){ // When use lever arm effect.
           vec3_t omega_b2i_4n;
           int packets_for_mean(0x10), i(0);
           typename recent_a_t::buf_t::const_iterator it(
               nearest(recent_a.buf, g_packet.itow, packets_for_mean));
           for(; (i < packets_for_mean) && (it != recent_a.buf.end()); i++, it++){
-            omega_b2i_4n += it->omega;
+            omega_b2i_4n += cast(it->omega);
           }
           omega_b2i_4n /= i;
           nav.correct(
               g_packet,
-              *g_packet.lever_arm,
+              cast(*g_packet.lever_arm),
               omega_b2i_4n,
               gps_advance);
         }else{ // When do not use lever arm effect.
@@ -2182,70 +3201,1162 @@ class NAV_Generator {
       switch(options.time_stamp.mode){
         case Options::time_stamp_t::CALENDAR_TIME:
           return check_egm<INS_GPS_Factory<
-              INS_NAVData<INS<float_sylph_t>, CalendarTimeStamp<float_sylph_t> > > >();
+              INS_NAVData<INS<float_ins_t>, CalendarTimeStamp<float_sylph_t> > > >();
         case Options::time_stamp_t::ITOW:
         default:
           return check_egm<INS_GPS_Factory<
-              INS_NAVData<INS<float_sylph_t> > > >();
+              INS_NAVData<INS<float_ins_t>, float_sylph_t> > >();
       }
     }
 };
 
-void loop(){
-  struct NAV_Manager {
-    NAV *nav;
-    NAV_Manager() : nav(NAV_Generator::generate()){}
-    ~NAV_Manager(){
-      delete nav;
+#if defined(ENABLE_ALLOCATION_COUNTER) && ENABLE_ALLOCATION_COUNTER
+/**
+ * Heap allocation counter for benchmark, which replaces the global operator new.
+ * Because the replacement affects the whole program, it is enabled only in the benchmark build.
+ * Allocations are counted only after it is activated by --benchmark.
+ * Its increment is atomic, because operator new is also called by the threads of
+ * --rt_threads, --init_yaw_bank, or --segments.
+ */
+struct AllocationCounter {
+#if defined(SPSC_QUEUE_USE_STD_ATOMIC)
+  typedef std::atomic<unsigned long> count_t;
+  static void increment(count_t &v){v.fetch_add(1, std::memory_order_relaxed);}
+  static unsigned long load(const count_t &v){return v.load(std::memory_order_relaxed);}
+#elif defined(__GNUC__)
+  typedef unsigned long count_t;
+  static void increment(count_t &v){__sync_fetch_and_add(&v, 1UL);}
+  static unsigned long load(count_t &v){return __sync_fetch_and_add(&v, 0UL);}
+#else
+  typedef volatile unsigned long count_t; // not atomic, only for legacy compilers
+  static void increment(count_t &v){++v;}
+  static unsigned long load(const count_t &v){return v;}
+#endif
+  static count_t count;
+  static bool active;
+  static void activate(){active = true;}
+  static unsigned long get(){return load(count);}
+};
+AllocationCounter::count_t AllocationCounter::count(0);
+bool AllocationCounter::active(false);
+
+#if defined(__cplusplus) && (__cplusplus >= 201103L)
+#define THROW_BAD_ALLOC
+#else
+#define THROW_BAD_ALLOC throw(std::bad_alloc)
+#endif
+#if defined(__GNUC__)
+// free() inlined into callers is reported as mismatched with operator new by -Wall of GCC.
+#define NOINLINE __attribute__((noinline))
+#else
+#define NOINLINE
+#endif
+void *operator new(std::size_t size) THROW_BAD_ALLOC {
+  if(AllocationCounter::active){AllocationCounter::increment(AllocationCounter::count);}
+  void *res(std::malloc(size ? size : 1));
+  if(!res){throw std::bad_alloc();}
+  return res;
+}
+NOINLINE void operator delete(void *ptr) throw() {
+  std::free(ptr);
+}
+#if defined(__cplusplus) && (__cplusplus >= 201402L)
+NOINLINE void operator delete(void *ptr, std::size_t) throw() {
+  std::free(ptr);
+}
+#endif
+#undef NOINLINE
+#undef THROW_BAD_ALLOC
+#endif
+
+/**
+ * Throughput and resource usage monitor, which is activated by --benchmark option.
+ * It is inserted between a stream processor and packet consumers to count packets,
+ * and to measure the latency from the arrival of each IMU or GPS packet to the completion
+ * of its processing, which includes output in --realtime mode.
+ */
+struct Benchmark : public Updatable {
+  Updatable *target;
+  unsigned long packets_A, packets_G, packets_M;
+  std::clock_t clock_start;
+  unsigned long allocation_start;
+  Profiler::stage_t latency_A, latency_G;
+  Profiler::tick_t tick_start, ref_start;
+  Profiler::stage_t latency_input; ///< in nanoseconds
+  typedef std::vector<std::pair<const char *, SPSC_QueueStats> > queues_t;
+  queues_t queues; ///< statistics of queues of --rt_threads
+
+  Benchmark()
+      : target(&updatable_blackhole),
+      packets_A(0), packets_G(0), packets_M(0),
+      clock_start(0), allocation_start(0),
+      latency_A("imu"), latency_G("gps"),
+      tick_start(0), ref_start(0),
+      latency_input("input"), queues() {}
+
+  void start(){
+    clock_start = std::clock();
+#if defined(ENABLE_ALLOCATION_COUNTER) && ENABLE_ALLOCATION_COUNTER
+    AllocationCounter::activate();
+    allocation_start = AllocationCounter::get();
+#endif
+    tick_start = Profiler::tick();
+    ref_start = Profiler::reference_ns();
+  }
+  Updatable *insert(Updatable *_target){
+    target = _target;
+    return this;
+  }
+
+#define update_func(type, counter) \
+virtual void update(const type &packet){ \
+  ++counter; \
+  target->update(packet); \
+}
+#define update_func_timed(type, counter, latency) \
+virtual void update(const type &packet){ \
+  ++counter; \
+  Profiler::tick_t t(Profiler::tick()); \
+  target->update(packet); \
+  latency.add(Profiler::tick() - t, 0); \
+}
+  update_func_timed(A_Packet, packets_A, latency_A);
+  update_func_timed(G_Packet, packets_G, latency_G);
+  update_func(M_Packet, packets_M);
+#undef update_func_timed
+#undef update_func
+
+  /**
+   * Measure the latency from the arrival of a page at a serial port
+   * to the end of its processing
+   *
+   * @param arrival_ns arrival time, 0 means unavailable
+   */
+  void check_arrival(const ComportStream::buf_t::time_ns_t &arrival_ns){
+    if(arrival_ns == 0){return;}
+    latency_input.add(ComportStream::buf_t::monotonic_ns() - arrival_ns, 0);
+  }
+  virtual void update(const TimePacket &packet){
+    target->update(packet);
+  }
+
+  /**
+   * Peak resident set size of this process
+   *
+   * @return [kB], or negative value when unavailable
+   */
+  static long peak_rss_kb(){
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0){
+#if defined(__APPLE__)
+      return usage.ru_maxrss / 1024; // in bytes
+#else
+      return usage.ru_maxrss;
+#endif
     }
-  } nav_manager;
-  
-  nav_manager.nav->label(options.out());
+#endif
+    return -1;
+  }
 
-  // TODO multiple log stream will be support.
-  StreamProcessor &proc(processors.front());
-  if(options.ins_gps_sync_strategy == Options::INS_GPS_SYNC_REALTIME){
-    // Realtime mode supports only one stream.
-    proc.update_target() = nav_manager.nav;
-    while(proc.process_1page());
-    return;
+  /**
+   * Print latency statistics in JSON, where p99 is approximated with the histogram
+   */
+  static void report_latency(std::ostream &out, const Profiler::stage_t &stage, const double &sf){
+    out << "{\"mean\": " << Profiler::to_ns(sf, stage.count > 0 ? ((double)stage.total / stage.count) : 0)
+        << ", \"p99\": " << Profiler::to_ns(sf, stage.count > 0 ? stage.percentile(0.99) : 0)
+        << ", \"max\": " << Profiler::to_ns(sf, stage.max) << "}";
   }
 
-  struct buffer_t : public Updatable {
-    typedef deque<const Packet *> packet_pool_t;
-    packet_pool_t packet_pool;
-    NAV &nav;
-    void sort_and_apply(int packets){
-      stable_sort(packet_pool.begin(), packet_pool.end(), Packet::compare_rollover);
-      while(packets-- > 0){
-        packet_pool_t::reference front(packet_pool.front());
-        front->apply(nav);
-        delete front;
-        packet_pool.pop_front();
+  void report(std::ostream &out) const {
+    float_sylph_t cpu_sec((float_sylph_t)(std::clock() - clock_start) / CLOCKS_PER_SEC);
+    double ns_per_tick(1);
+#if defined(PROFILER_USE_TSC)
+    {
+      Profiler::tick_t ticks(Profiler::tick() - tick_start), ns(Profiler::reference_ns() - ref_start);
+      ns_per_tick = ((ticks > 0) && (ns > 0)) ? ((double)ns / ticks) : 0;
+    }
+#endif
+    const char *sync_strategy("offline");
+    switch(options.ins_gps_sync_strategy){
+      case Options::INS_GPS_SYNC_BACK_PROPAGATION: sync_strategy = "back_propagate"; break;
+      case Options::INS_GPS_SYNC_REALTIME: sync_strategy = "realtime"; break;
+      case Options::INS_GPS_SYNC_SMOOTHING: sync_strategy = "smooth"; break;
+      default: break;
+    }
+    out << "{" << std::endl
+        << "  \"variant\": {"
+          << "\"kf\": \"" << (options.use_udkf ? "UD" : "standard") << "\", "
+          << "\"est_bias\": " << (options.est_bias ? "true" : "false") << ", "
+          << "\"use_egm\": " << (options.use_egm ? "true" : "false") << ", "
+          << "\"propagation_interval\": " << options.propagation_interval << ", "
+          << "\"preintegrate\": " << options.preintegrate << ", "
+          << "\"sync\": \"" << sync_strategy << "\", "
+          << "\"time_stamp\": \""
+            << (options.time_stamp.mode == Options::time_stamp_t::CALENDAR_TIME ? "calendar" : "itow")
+            << "\"}," << std::endl
+        << "  \"imu_samples\": " << packets_A << "," << std::endl
+        << "  \"gps_updates\": " << packets_G << "," << std::endl
+        << "  \"mag_samples\": " << packets_M << "," << std::endl
+        << "  \"cpu_time_sec\": " << cpu_sec << "," << std::endl
+        << "  \"imu_samples_per_sec\": " << (cpu_sec > 0 ? (packets_A / cpu_sec) : 0) << "," << std::endl
+        << "  \"gps_updates_per_sec\": " << (cpu_sec > 0 ? (packets_G / cpu_sec) : 0) << "," << std::endl
+        << "  \"peak_rss_kb\": " << peak_rss_kb() << "," << std::endl
+        << "  \"allocations\": "
+#if defined(ENABLE_ALLOCATION_COUNTER) && ENABLE_ALLOCATION_COUNTER
+          << (AllocationCounter::get() - allocation_start)
+#else
+          << "null"
+#endif
+          << "," << std::endl
+        << "  \"imu_latency_ns\": ";
+    report_latency(out, latency_A, ns_per_tick);
+    out << "," << std::endl
+        << "  \"gps_latency_ns\": ";
+    report_latency(out, latency_G, ns_per_tick);
+    if(latency_input.count > 0){
+      out << "," << std::endl
+          << "  \"input_latency_ns\": ";
+      report_latency(out, latency_input, 1);
+    }
+    if(!queues.empty()){
+      out << "," << std::endl
+          << "  \"queues\": [";
+      for(queues_t::const_iterator it(queues.begin()), it_end(queues.end()); it != it_end; ++it){
+        out << (it == queues.begin() ? "" : ",") << std::endl << "    ";
+        report_queue(out, it->first, it->second, true);
       }
+      out << "]";
     }
-    void sort_and_apply2 () {
-      if(packet_pool.size() < 0x200){return;}
-      sort_and_apply(0x100);
+    out << std::endl
+        << "}" << std::endl;
+  }
+
+  /**
+   * Print queue statistics in text or JSON
+   */
+  static void report_queue(
+      std::ostream &out, const char *name, const SPSC_QueueStats &stats, const bool &in_json = false){
+    if(in_json){
+      out << "{\"name\": \"" << name << "\""
+          << ", \"capacity\": " << stats.capacity
+          << ", \"pushed\": " << stats.pushed
+          << ", \"dropped\": " << stats.dropped
+          << ", \"depth_mean\": " << stats.depth_mean()
+          << ", \"depth_max\": " << stats.depth_max
+          << ", \"producer_waits\": " << stats.producer_waits
+          << ", \"consumer_waits\": " << stats.consumer_waits << "}";
+    }else{
+      out << name << " queue: capacity " << stats.capacity
+          << ", pushed " << stats.pushed
+          << ", dropped " << stats.dropped
+          << ", depth mean " << stats.depth_mean()
+          << ", max " << stats.depth_max
+          << ", waits producer " << stats.producer_waits
+          << ", consumer " << stats.consumer_waits << std::endl;
     }
-    buffer_t(NAV &_nav) : packet_pool(), nav(_nav) {}
-    ~buffer_t() {
-      sort_and_apply(packet_pool.size());
+  }
+} benchmark;
+
+/**
+ * Buffer to apply packets to NAV in time order.
+ * Packets are sorted in a sliding window in order to compensate for the output delay of GPS.
+ */
+struct SortBuffer : public Updatable {
+  typedef deque<const Packet *> packet_pool_t;
+  packet_pool_t packet_pool;
+  NAV &nav;
+  bool own; ///< True when packets are copied at push, and deleted after application
+  void sort_and_apply(int packets){
+    PROFILER_SCOPE("buffer_t");
+    stable_sort(packet_pool.begin(), packet_pool.end(), Packet::compare_rollover);
+    while(packets-- > 0){
+      packet_pool_t::reference front(packet_pool.front());
+      front->apply(nav);
+      if(own){delete front;}
+      packet_pool.pop_front();
     }
+  }
+  void sort_and_apply2 () {
+    if(packet_pool.size() < 0x200){return;}
+    sort_and_apply(0x100);
+  }
+  SortBuffer(NAV &_nav, const bool &_own = true) : packet_pool(), nav(_nav), own(_own) {}
+  ~SortBuffer() {
+    flush();
+  }
+  void flush(){
+    sort_and_apply(packet_pool.size());
+  }
 #define update_func(type) \
 virtual void update(const type &packet){ \
-  packet_pool.push_back(new type(packet)); \
+  packet_pool.push_back(own ? new type(packet) : &packet); \
   sort_and_apply2(); \
 }
-    update_func(A_Packet);
-    update_func(G_Packet);
-    update_func(M_Packet);
-    update_func(TimePacket);
+  update_func(A_Packet);
+  update_func(G_Packet);
+  update_func(M_Packet);
+  update_func(TimePacket);
 #undef update_func
-  } buffer(*nav_manager.nav);
-  proc.update_target() = &buffer;
 
-  while(proc.process_1page());
+  /**
+   * Save or restore pending packets
+   *
+   * @param ar archive
+   * @param lever_arm lever arm of the log assigned to restored G packets
+   */
+  void checkpoint(CheckpointArchive &ar, Vector3<float_sylph_t> *lever_arm){
+    unsigned long size(packet_pool.size());
+    ar & size;
+    if(!ar.loading()){
+      struct writer_t : public Updatable {
+        CheckpointArchive &ar;
+        writer_t(CheckpointArchive &_ar) : ar(_ar) {}
+#define update_func(type, tag) \
+virtual void update(const type &packet){ \
+  char c(tag); \
+  archive(ar & c, const_cast<type &>(packet)); \
+}
+        update_func(A_Packet, 'A');
+        update_func(G_Packet, 'G');
+        update_func(M_Packet, 'M');
+        update_func(TimePacket, 'T');
+#undef update_func
+      } writer(ar);
+      for(packet_pool_t::iterator it(packet_pool.begin()), it_end(packet_pool.end());
+          it != it_end; ++it){
+        (*it)->apply(writer);
+      }
+      return;
+    }
+    if(!own){ar.invalidate(); return;}
+    for(; (size > 0) && ar.good(); --size){
+      char c;
+      ar & c;
+      switch(c){
+#define restore_packet(type, tag) \
+case tag: { \
+  type *packet(new type()); \
+  archive(ar, *packet); \
+  packet_pool.push_back(packet); \
+  break; \
+}
+        restore_packet(A_Packet, 'A');
+        case 'G': {
+          G_Packet *packet(new G_Packet());
+          archive(ar, *packet);
+          packet->lever_arm = lever_arm;
+          packet_pool.push_back(packet);
+          break;
+        }
+        restore_packet(M_Packet, 'M');
+        restore_packet(TimePacket, 'T');
+#undef restore_packet
+        default:
+          ar.invalidate();
+      }
+    }
+  }
+};
+
+struct NAV_Manager {
+  NAV *nav;
+  NAV_Manager() : nav(NAV_Generator::generate()){}
+  ~NAV_Manager(){
+    delete nav;
+  }
+};
+
+/**
+ * Checkpoint of the whole processing state, i.e., the decoder, the sort buffer, and the NAV.
+ * It is taken at a page boundary with the offset of the next page in the log,
+ * from which a resumed run restarts.
+ */
+struct Checkpoint {
+  NAV &nav;
+  StreamProcessor &proc;
+  SortBuffer &buffer;
+  int pages; ///< Pages processed after the last save
+
+  Checkpoint(NAV &_nav, StreamProcessor &_proc, SortBuffer &_buffer)
+      : nav(_nav), proc(_proc), buffer(_buffer), pages(0) {}
+
+  /**
+   * @param ar archive
+   * @param out_pos output position corresponding to the checkpoint, negative when unknown
+   * @return (bool) true when success, otherwise false.
+   */
+  bool serialize(CheckpointArchive &ar, std::streamoff &out_pos){
+    ar.marker("INS_GPS checkpoint");
+    ar.marker(typeid(nav).name()); // filter configuration must be the same
+    ar.pod(out_pos);
+    ar.pod(options.dump_relative.mode);
+    ar.pod(options.dump_relative.base);
+    proc.checkpoint(ar);
+    buffer.checkpoint(ar, proc.lever_arm());
+    if(!nav.checkpoint(ar)){return false;}
+    ar.marker("end");
+    return ar.good();
+  }
+
+  bool save(){
+    const char *fname(options.checkpoint.fname);
+    std::string fname_tmp(std::string(fname) + ".tmp");
+    options.out().flush();
+    std::streamoff out_pos(options.out().tellp());
+    {
+      std::ofstream out(fname_tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      CheckpointArchive ar(out);
+      if(!serialize(ar, out_pos)){
+        cerr << "(warning!) Failed to save checkpoint: " << fname_tmp << endl;
+        return false;
+      }
+    }
+#if defined(_WIN32)
+    std::remove(fname); // rename() fails when the destination exists.
+#endif
+    if(std::rename(fname_tmp.c_str(), fname) != 0){
+      cerr << "(warning!) Failed to save checkpoint: " << fname << endl;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Call after each page processed
+   */
+  void tick(){
+    if(!options.checkpoint.fname){return;}
+    if(++pages < options.checkpoint.pages){return;}
+    pages = 0;
+    save();
+  }
+
+  void resume(){
+    const char *fname(options.checkpoint.resume_fname);
+    std::ifstream in(fname, std::ios::in | std::ios::binary);
+    CheckpointArchive ar(in);
+    std::streamoff out_pos(-1);
+    if(!serialize(ar, out_pos)){
+      cerr << "(error!) Invalid checkpoint for the current options: " << fname << endl;
+      exit(-1);
+    }
+    std::streamoff offset((options.checkpoint.resume_offset >= 0)
+        ? (std::streamoff)options.checkpoint.resume_offset
+        : proc.processed_bytes());
+    if(!proc.skip(offset)){
+      cerr << "(error!) Log is shorter than the offset to resume: " << offset << endl;
+      exit(-1);
+    }
+    cerr << "Resume: " << fname << ", log offset " << offset << " [bytes]";
+    if(out_pos >= 0){
+      cerr << ", previous output should be truncated at " << out_pos << " [bytes]";
+    }
+    cerr << endl;
+  }
+};
+
+/**
+ * Multithreaded pipeline for --realtime mode, which is activated by --rt_threads option.
+ * The stages are connected with bounded lock-free queues as
+ *   (input) => reader => [page] => decoder => [packet] => filter => [output] => writer => (output)
+ * where the filter stage is performed by the caller of run().
+ * A stage dropping items under the drop policy continues to work with the next item.
+ */
+class RealTimePipeline {
+  public:
+    typedef ComportStream::buf_t::time_ns_t time_ns_t;
+    struct page_t {
+      char buffer[SYLPHIDE_PAGE_SIZE];
+      int size;
+      time_ns_t arrival;
+    };
+    struct packet_t {
+      enum {A, G, M, TIME} type;
+      A_Packet a;
+      G_Packet g;
+      M_Packet m;
+      TimePacket t;
+      time_ns_t arrival;
+      void apply(Updatable &target) const {
+        switch(type){
+          case A: target.update(a); break;
+          case G: target.update(g); break;
+          case M: target.update(m); break;
+          case TIME: target.update(t); break;
+        }
+      }
+    };
+    struct chunk_t {
+      char buffer[0x400];
+      std::size_t size;
+    };
+
+  protected:
+    typedef Options::rt_threads_t prop_t;
+    SPSC_Queue<page_t> pages;
+    SPSC_Queue<packet_t> packets;
+    SPSC_Queue<chunk_t> chunks;
+    StreamProcessor &proc;
+
+    template <class QueueT>
+    static typename QueueT::policy_t policy(const int &index){
+      return options.rt_threads.drop[index] ? QueueT::DROP : QueueT::BLOCK;
+    }
+
+    struct Reader : public Thread {
+      RealTimePipeline &pipeline;
+      Reader(RealTimePipeline &_pipeline) : Thread(), pipeline(_pipeline) {}
+      void run(){
+        SPSC_Queue<page_t>::policy_t policy(
+            RealTimePipeline::policy<SPSC_Queue<page_t> >(prop_t::QUEUE_PAGE));
+        // Read even when the queue is full in order to drain the input under the drop policy
+        for(page_t page; (page.size = pipeline.proc.read_1page(page.buffer)) > 0; ){
+          page.arrival = pipeline.proc.arrival_ns();
+          if((!pipeline.pages.push(page, policy)) && pipeline.pages.is_cancelled()){break;}
+        }
+        pipeline.pages.close();
+      }
+    } reader;
+
+    struct Decoder : public Thread, public Updatable {
+      RealTimePipeline &pipeline;
+      SPSC_Queue<packet_t>::policy_t policy;
+      time_ns_t arrival;
+      Decoder(RealTimePipeline &_pipeline)
+          : Thread(), Updatable(), pipeline(_pipeline),
+          policy(RealTimePipeline::policy<SPSC_Queue<packet_t> >(prop_t::QUEUE_PACKET)),
+          arrival(0) {}
+      void run(){
+        while(page_t *page = pipeline.pages.read_slot()){
+          arrival = page->arrival;
+          bool res(pipeline.proc.process(page->buffer, page->size));
+          pipeline.pages.release();
+          if(!res){break;}
+        }
+        pipeline.pages.cancel(); // stop the reader when the time range is over
+        pipeline.packets.close();
+      }
+#define update_func(packet_type, member, tag) \
+virtual void update(const packet_type &packet){ \
+  if(packet_t *slot = pipeline.packets.write_slot(policy)){ \
+    slot->type = packet_t::tag; \
+    slot->member = packet; \
+    slot->arrival = arrival; \
+    pipeline.packets.commit(); \
+  } \
+}
+      update_func(A_Packet, a, A);
+      update_func(G_Packet, g, G);
+      update_func(M_Packet, m, M);
+      update_func(TimePacket, t, TIME);
+#undef update_func
+    } decoder;
+
+    /**
+     * Output buffer of the filter stage, which passes text to the writer in chunks
+     * at every flush or when a chunk is filled.
+     */
+    struct ChunkStreambuf : public std::streambuf {
+      SPSC_Queue<chunk_t> &queue;
+      SPSC_Queue<chunk_t>::policy_t policy;
+      char buffer[sizeof(((chunk_t *)NULL)->buffer)];
+      ChunkStreambuf(SPSC_Queue<chunk_t> &_queue)
+          : std::streambuf(), queue(_queue),
+          policy(RealTimePipeline::policy<SPSC_Queue<chunk_t> >(prop_t::QUEUE_OUTPUT)) {
+        setp(buffer, buffer + sizeof(buffer));
+      }
+      void publish(){
+        std::size_t size(pptr() - pbase());
+        if(size == 0){return;}
+        if(chunk_t *slot = queue.write_slot(policy)){
+          std::memcpy(slot->buffer, buffer, size);
+          slot->size = size;
+          queue.commit();
+        }
+        setp(buffer, buffer + sizeof(buffer));
+      }
+      int_type overflow(int_type c){
+        publish();
+        if(!traits_type::eq_int_type(c, traits_type::eof())){
+          *pptr() = traits_type::to_char_type(c);
+          pbump(1);
+        }
+        return traits_type::not_eof(c);
+      }
+      int sync(){
+        publish();
+        return 0;
+      }
+    } out_buf;
+    std::ostream out;
+
+    struct Writer : public Thread {
+      RealTimePipeline &pipeline;
+      std::ostream *dest;
+      Writer(RealTimePipeline &_pipeline) : Thread(), pipeline(_pipeline), dest(NULL) {}
+      void run(){
+        SPSC_Queue<chunk_t> &chunks(pipeline.chunks);
+        while(chunk_t *chunk = chunks.read_slot()){
+          dest->write(chunk->buffer, chunk->size);
+          chunks.release();
+          if(!chunks.try_read_slot()){dest->flush();} // flush only when idle
+        }
+        dest->flush();
+      }
+    } writer;
+
+  public:
+    RealTimePipeline(StreamProcessor &_proc)
+        : pages(options.rt_threads.queue_size),
+        packets(options.rt_threads.queue_size),
+        chunks(options.rt_threads.queue_size),
+        proc(_proc),
+        reader(*this), decoder(*this),
+        out_buf(chunks), out(&out_buf),
+        writer(*this) {}
+
+    /**
+     * Process the whole stream with threads
+     *
+     * @param target destination of packets, which is called in the current thread
+     * @return (bool) false when threads are unavailable, and nothing is processed.
+     */
+    bool run(Updatable &target){
+      if(!Thread::available()){return false;}
+
+      // Output is redirected to the writer.
+      writer.dest = options._out;
+      out.copyfmt(*writer.dest);
+      options._out = &out;
+      if(!writer.start()){
+        options._out = writer.dest;
+        return false;
+      }
+
+      proc.update_target() = &decoder;
+      if(!(decoder.start() && reader.start())){
+        cerr << "(error!) Failed to start threads." << endl;
+        exit(-1);
+      }
+
+      while(packet_t *packet = packets.read_slot()){
+        packet->apply(target);
+        if(options.benchmark_out){benchmark.check_arrival(packet->arrival);}
+        packets.release();
+      }
+
+      out.flush();
+      chunks.close();
+      writer.join();
+      options._out = writer.dest;
+      decoder.join();
+      reader.join(); // may wait for the next arrival when the input is a serial port
+
+      static const char *names[] = {"page", "packet", "output"};
+      SPSC_QueueStats stats[] = {pages.stats(), packets.stats(), chunks.stats()};
+      for(int i(0); i < prop_t::QUEUES; ++i){
+        if(options.rt_threads.stats_out){
+          Benchmark::report_queue(*options.rt_threads.stats_out, names[i], stats[i]);
+        }
+        if(options.benchmark_out){
+          benchmark.queues.push_back(std::make_pair(names[i], stats[i]));
+        }
+      }
+      if(options.rt_threads.stats_out){options.rt_threads.stats_out->flush();}
+      return true;
+    }
+};
+
+/**
+ * Decoded packets in arrival order, which are replayed for parameter sweep.
+ */
+struct PacketRecorder : public Updatable {
+  typedef std::vector<const Packet *> packets_t;
+  packets_t packets;
+  PacketRecorder() : packets() {}
+  ~PacketRecorder(){
+    for(packets_t::iterator it(packets.begin()), it_end(packets.end()); it != it_end; ++it){
+      delete *it;
+    }
+  }
+#define update_func(type) \
+virtual void update(const type &packet){ \
+  packets.push_back(new type(packet)); \
+}
+  update_func(A_Packet);
+  update_func(G_Packet);
+  update_func(M_Packet);
+  update_func(TimePacket);
+#undef update_func
+
+  /**
+   * Apply packets to NAV in the same order as loop()
+   */
+  void replay(NAV &nav) const {
+    if(options.ins_gps_sync_strategy == Options::INS_GPS_SYNC_REALTIME){
+      for(packets_t::const_iterator it(packets.begin()), it_end(packets.end()); it != it_end; ++it){
+        (*it)->apply(nav);
+      }
+      return;
+    }
+    SortBuffer buffer(nav, false);
+    for(packets_t::const_iterator it(packets.begin()), it_end(packets.end()); it != it_end; ++it){
+      (*it)->apply(buffer);
+    }
+  }
+};
+
+/**
+ * Bank of NAVs with evenly spaced initial headings, which is activated by --init_yaw_bank option.
+ * The beginning of the log is recorded until the evaluation period from the first G packet
+ * available for initialization is covered, and then replayed for each NAV on a thread.
+ * The NAVs are weighted by the likelihood of their GPS innovations,
+ * and the initial heading of the most likely one is selected.
+ */
+struct InitialYawBank : public PacketRecorder {
+  float_sylph_t itow_start; ///< Time of the first G packet available for initialization
+  bool started, covered;
+
+  InitialYawBank() : PacketRecorder(), itow_start(0), started(false), covered(false) {}
+
+  using PacketRecorder::update;
+  void update(const G_Packet &packet){
+    PacketRecorder::update(packet);
+    if(!started){
+      started = (packet.sigma_2d <= options.gps_threshold.init_acc_2d)
+          && (packet.sigma_height <= options.gps_threshold.init_acc_v);
+      itow_start = packet.itow;
+      return;
+    }
+    float_sylph_t elapsed(packet.itow - itow_start);
+    if(elapsed < 0){elapsed += 60 * 60 * 24 * 7;} // week rollover
+    if(elapsed >= options.init_yaw_bank.duration){covered = true;}
+  }
+
+  struct runner_t : public Thread {
+    const PacketRecorder &recorder;
+    std::istringstream init_misc;
+    NAV::hypothesis_t hypothesis;
+    NAV *nav;
+    runner_t(const PacketRecorder &_recorder,
+        const float_sylph_t &yaw_deg, const std::string &_init_misc)
+        : Thread(), recorder(_recorder), init_misc(_init_misc),
+        hypothesis(yaw_deg, &init_misc), nav(NAV_Generator::generate()) {
+      nav->hypothesis = &hypothesis;
+    }
+    ~runner_t(){
+      join();
+      delete nav;
+    }
+    void run(){recorder.replay(*nav);}
+  };
+
+  /**
+   * Decode the beginning of the log, and evaluate hypotheses.
+   * The decoded packets are kept in order to be applied to the main NAV.
+   *
+   * @param proc stream processor, whose target is temporarily replaced
+   * @param yaw_deg selected initial heading
+   * @return (bool) true when selected, false when no hypothesis has been corrected with GPS.
+   */
+  bool run(StreamProcessor &proc, float_sylph_t &yaw_deg){
+    {
+      Updatable *target(proc.update_target());
+      proc.update_target() = this;
+      while((!covered) && proc.process_1page());
+      proc.update_target() = target;
+    }
+
+    // Options::init_misc is consumed here, and then restored for the main NAV.
+    std::string init_misc;
+    {
+      std::stringstream ss;
+      ss << options.init_misc->rdbuf();
+      init_misc = ss.str();
+      options.init_misc_buf.clear();
+      options.init_misc_buf.str(init_misc);
+      options.init_misc = &options.init_misc_buf;
+    }
+
+    const int n(options.init_yaw_bank.hypotheses);
+    std::vector<runner_t *> runners;
+    for(int i(0); i < n; ++i){
+      runners.push_back(new runner_t(*this, (float_sylph_t)360 * i / n, init_misc));
+    }
+    for(int i(0); i < n; ++i){
+      if(!runners[i]->start()){runners[i]->run();} // without thread
+    }
+    unsigned int corrections(0);
+    for(int i(0); i < n; ++i){
+      runners[i]->join();
+      corrections = std::max(corrections, runners[i]->hypothesis.corrections);
+    }
+
+    // Only the hypotheses having the full number of finite likelihoods are compared.
+    int best(-1);
+    std::vector<bool> valid(n, false);
+    for(int i(0); i < n; ++i){
+      const NAV::hypothesis_t &h(runners[i]->hypothesis);
+      if((corrections == 0) || (h.corrections < corrections)
+          || !(h.log_likelihood >= -std::numeric_limits<float_sylph_t>::max())){continue;}
+      valid[i] = true;
+      if((best < 0) || (h.log_likelihood > runners[best]->hypothesis.log_likelihood)){best = i;}
+    }
+
+    // Weights are normalized likelihoods, which are scaled by the best one to avoid underflow.
+    std::vector<float_sylph_t> weight(n, 0);
+    if(best >= 0){
+      float_sylph_t sum(0);
+      for(int i(0); i < n; ++i){
+        if(!valid[i]){continue;}
+        sum += (weight[i] = std::exp(
+            runners[i]->hypothesis.log_likelihood - runners[best]->hypothesis.log_likelihood));
+      }
+      for(int i(0); i < n; ++i){weight[i] /= sum;}
+    }
+
+    cerr << "init_yaw_bank: " << packets.size() << " packets are evaluated." << endl;
+    cerr << "  (yaw [deg], GPS corrections, log-likelihood, weight)" << endl;
+    for(int i(0); i < n; ++i){
+      const NAV::hypothesis_t &h(runners[i]->hypothesis);
+      cerr << "  " << h.yaw_deg << ", " << h.corrections << ", "
+          << h.log_likelihood << ", " << weight[i]
+          << ((i == best) ? " (selected)" : "") << endl;
+    }
+    if(best >= 0){yaw_deg = runners[best]->hypothesis.yaw_deg;}
+
+    for(int i(0); i < n; ++i){delete runners[i];}
+    return best >= 0;
+  }
+
+  /**
+   * Apply the recorded packets in arrival order, i.e., in the same manner as the stream processor
+   */
+  void apply(Updatable &target) const {
+    for(packets_t::const_iterator it(packets.begin()), it_end(packets.end()); it != it_end; ++it){
+      (*it)->apply(target);
+    }
+  }
+};
+
+void loop(){
+  NAV_Manager nav_manager;
+
+  // TODO multiple log stream will be support.
+  StreamProcessor &proc(processors.front());
+
+  // Realtime mode supports only one stream, and does not use the sort buffer.
+  SortBuffer buffer(*nav_manager.nav);
+  Updatable *target((options.ins_gps_sync_strategy == Options::INS_GPS_SYNC_REALTIME)
+      ? static_cast<Updatable *>(nav_manager.nav)
+      : static_cast<Updatable *>(&buffer));
+  proc.update_target() = options.benchmark_out ? benchmark.insert(target) : target;
+
+  Checkpoint checkpoint(*nav_manager.nav, proc, buffer);
+  if(options.checkpoint.resume_fname){
+    checkpoint.resume();
+  }else{
+    nav_manager.nav->label(options.out());
+  }
+
+  if(options.init_yaw_bank.hypotheses > 1){
+    InitialYawBank bank;
+    float_sylph_t yaw_deg;
+    if(bank.run(proc, yaw_deg)){
+      options.initial_attitude.yaw_deg = yaw_deg;
+      if(options.initial_attitude.mode < options.initial_attitude.YAW_ONLY){
+        options.initial_attitude.mode = options.initial_attitude.YAW_ONLY;
+      }
+    }else{
+      cerr << "(warning!) init_yaw_bank: no GPS correction, initial heading is not changed." << endl;
+    }
+    bank.apply(*proc.update_target()); // the main NAV processes the recorded packets again
+  }
+
+  if(options.rt_threads.enabled){
+    RealTimePipeline pipeline(proc);
+    if(pipeline.run(*proc.update_target())){return;}
+    cerr << "(warning!) rt_threads: ignored, because thread is unavailable." << endl;
+  }
+
+  while(proc.process_1page()){
+    checkpoint.tick();
+    if(options.benchmark_out){benchmark.check_arrival(proc.arrival_ns());}
+  }
+
+  if(options.checkpoint.fname){
+    checkpoint.save(); // before the remaining packets in the sort buffer are flushed
+  }
+  buffer.flush();
+  nav_manager.nav->finish();
+}
+
+void setup_output(){
+  if(options.out_sylphide){
+    options._out = new SylphideOStream(options.out(), SYLPHIDE_PAGE_SIZE);
+  }else{
+    options.out() << setprecision(10);
+  }
+  options.out_debug() << setprecision(16);
+}
+
+/**
+ * Parameter sweep.
+ * The log is decoded only once, and then NAVs configured by each line of the sweep file
+ * are processed concurrently.
+ * Because the configuration is held in the global options, each configuration is processed
+ * in a forked process, which shares the decoded packets in copy-on-write manner.
+ * Where fork() is unavailable, only a single configuration is acceptable.
+ */
+void sweep(){
+  typedef std::vector<std::string> config_t;
+  std::vector<config_t> configs;
+  {
+    cerr << "Sweep configurations: ";
+    istream &in(options.spec2istream(options.sweep.fname));
+    for(std::string line; std::getline(in, line); ){
+      std::istringstream ss(line);
+      config_t config;
+      for(std::string spec; ss >> spec; ){
+        if(spec[0] == '#'){break;} // comment
+        config.push_back(spec);
+      }
+      if(!config.empty()){configs.push_back(config);}
+    }
+  }
+
+  PacketRecorder recorder;
+  {
+    StreamProcessor &proc(processors.front());
+    proc.update_target() = &recorder;
+    while(proc.process_1page());
+  }
+  cerr << "Sweep: " << recorder.packets.size() << " packets are decoded, "
+      << configs.size() << " configurations will be processed." << endl;
+
+  struct runner_t {
+    static int run(const PacketRecorder &recorder, const config_t &config, const int &index){
+      std::ostream *out_default(&options.out());
+      for(config_t::const_iterator it(config.begin()), it_end(config.end()); it != it_end; ++it){
+        std::vector<char> spec(it->begin(), it->end());
+        spec.push_back('\0');
+        if(options.check_spec(&spec[0])){continue;}
+        // log specific options; only sigma in calibration is effective because already decoded.
+        if(processors.front().check_spec(&spec[0])){continue;}
+        cerr << "(error!) Unknown option in sweep configuration(" << index << "): " << *it << endl;
+        return -1;
+      }
+      if(&options.out() == out_default){
+        std::stringstream ss;
+        ss << options.sweep.fname << "." << index << ".csv";
+        cerr << "out: ";
+        options._out = &options.spec2ostream(ss.str().c_str(), true);
+      }
+      setup_output();
+      {
+        NAV_Manager nav_manager;
+        nav_manager.nav->label(options.out());
+        recorder.replay(*nav_manager.nav);
+        nav_manager.nav->finish();
+      }
+      options.out().flush();
+      return 0;
+    }
+  };
+
+#if defined(__unix__) || defined(__APPLE__)
+  int jobs(options.sweep.jobs);
+  if(jobs <= 0){
+    long cpus(sysconf(_SC_NPROCESSORS_ONLN));
+    jobs = (cpus > 0) ? (int)cpus : 1;
+  }
+  int running(0), failed(0);
+  for(int i(0); (i < (int)configs.size()) || (running > 0); ){
+    if((i < (int)configs.size()) && (running < jobs)){
+      cout.flush();
+      cerr.flush();
+      pid_t pid(fork());
+      if(pid == 0){ // child
+        int res(runner_t::run(recorder, configs[i], i));
+        cerr.flush();
+        _exit(res == 0 ? 0 : 1);
+      }else if(pid < 0){
+        cerr << "(error!) fork() failed." << endl;
+        exit(-1);
+      }
+      ++running;
+      ++i;
+      continue;
+    }
+    int status;
+    if(wait(&status) < 0){break;}
+    --running;
+    if(!(WIFEXITED(status) && (WEXITSTATUS(status) == 0))){++failed;}
+  }
+  if(failed > 0){
+    cerr << "(error!) " << failed << " configuration(s) failed." << endl;
+    exit(-1);
+  }
+#else
+  if(configs.size() > 1){
+    cerr << "(error!) Multiple sweep configurations are not supported on this platform." << endl;
+    exit(-1);
+  }
+  if((!configs.empty()) && (runner_t::run(recorder, configs[0], 0) != 0)){
+    exit(-1);
+  }
+#endif
+}
+
+/**
+ * Segment-parallel processing.
+ * The log is decoded only once, and divided into segments of equal GPS time length,
+ * which are processed concurrently by NAVs on threads. Each NAV processes the packets
+ * from the warm-up period before the beginning of its segment to the end, and outputs
+ * only the results in the segment. The outputs are concatenated in time order,
+ * and the differences of the results at each boundary are reported.
+ */
+void segmented(){
+  PacketRecorder recorder;
+  {
+    StreamProcessor &proc(processors.front());
+    proc.update_target() = &recorder;
+    while(proc.process_1page());
+  }
+
+  static const float_sylph_t week_sec(60 * 60 * 24 * 7);
+  struct elapsed_t { // GPS time relative to the first G packet
+    const Packet *base;
+    elapsed_t() : base(NULL) {}
+    float_sylph_t operator()(const Packet &packet) const {
+      float_sylph_t res(packet.itow - base->itow);
+      if(res < -week_sec / 2){ // week rollover
+        res += week_sec;
+      }else if(res >= week_sec / 2){
+        res -= week_sec;
+      }
+      return res;
+    }
+  } elapsed;
+  float_sylph_t length(0);
+  for(PacketRecorder::packets_t::const_iterator it(recorder.packets.begin()), it_end(recorder.packets.end());
+      it != it_end; ++it){
+    if(!dynamic_cast<const G_Packet *>(*it)){continue;}
+    if(!elapsed.base){elapsed.base = *it;}
+    length = std::max(length, elapsed(**it));
+  }
+
+  int n(options.segments.number);
+#if defined(__unix__) || defined(__APPLE__)
+  if(n <= 0){
+    long cpus(sysconf(_SC_NPROCESSORS_ONLN));
+    n = (cpus > 0) ? (int)cpus : 1;
+  }
+#endif
+  if((n <= 0) || (!elapsed.base)){n = 1;}
+  cerr << "Segments: " << recorder.packets.size() << " packets are decoded, "
+      << length << " [sec] is divided into " << n << " segment(s)." << endl;
+
+  // Options::init_misc is consumed here, and then given to each segment.
+  std::string init_misc;
+  {
+    std::stringstream ss;
+    ss << options.init_misc->rdbuf();
+    init_misc = ss.str();
+  }
+
+  struct runner_t : public Thread {
+    const PacketRecorder &recorder;
+    const elapsed_t &elapsed;
+    float_sylph_t t_start, t_end; ///< Packets in [t_start, t_end) are processed.
+    bool first, last;
+    std::stringstream buf;
+    std::istringstream init_misc;
+    NAV::segment_t segment;
+    NAV *nav;
+    runner_t(const PacketRecorder &_recorder, const elapsed_t &_elapsed,
+        const int &index, const float_sylph_t &t_begin, const float_sylph_t &_t_end,
+        const bool &_last, const std::string &_init_misc)
+        : Thread(), recorder(_recorder), elapsed(_elapsed),
+        t_start(t_begin - options.segments.warmup), t_end(_t_end),
+        first(index == 0), last(_last),
+        buf(), init_misc(_init_misc),
+        segment(index, (_elapsed.base ? _elapsed.base->itow : 0) + t_begin,
+          (index == 0) ? &options.out() : &buf, &init_misc),
+        nav(NAV_Generator::generate()) {
+      buf.copyfmt(options.out()); // e.g., precision
+      nav->segment = &segment;
+    }
+    ~runner_t(){
+      join();
+      delete nav;
+    }
+    void run(){
+      {
+        SortBuffer buffer(*nav, false);
+        for(PacketRecorder::packets_t::const_iterator it(recorder.packets.begin()), it_end(recorder.packets.end());
+            it != it_end; ++it){
+          if(elapsed.base){
+            float_sylph_t t(elapsed(**it));
+            if((!last) && (t >= t_end)){continue;}
+            // Time packets are always applied for the time stamp.
+            if((!first) && (t < t_start) && !dynamic_cast<const TimePacket *>(*it)){continue;}
+          }
+          (*it)->apply(buffer);
+        }
+      }
+      nav->finish();
+    }
+  };
+
+  std::vector<runner_t *> runners;
+  for(int i(0); i < n; ++i){
+    runners.push_back(new runner_t(recorder, elapsed,
+        i, length * i / n, length * (i + 1) / n, i == (n - 1), init_misc));
+  }
+  runners[0]->nav->label(options.out());
+  for(int i(0); i < n; ++i){
+    if(!runners[i]->start()){runners[i]->run();} // without thread
+  }
+  for(int i(0); i < n; ++i){
+    runners[i]->join();
+    if(i > 0){
+      std::streambuf *buf(runners[i]->buf.rdbuf());
+      if(buf->in_avail() > 0){options.out() << buf;}
+    }
+  }
+  options.out().flush();
+
+  // Continuity check at the boundaries
+  for(int i(1); i < n; ++i){
+    const NAV::segment_t::snapshot_t
+        &prev(runners[i - 1]->segment.last), &next(runners[i]->segment.warmup_end);
+    cerr << "Segment boundary(" << i << ") at " << runners[i]->segment.itow_begin << ": ";
+    if(!(prev.valid && next.valid)){
+      cerr << "(warning!) not compared, because a segment has no result." << endl;
+      continue;
+    }
+    float_sylph_t
+        d_north((next.latitude - prev.latitude)
+          * WGS84Generic<float_sylph_t>::R_meridian(prev.latitude)),
+        d_east((next.longitude - prev.longitude)
+          * WGS84Generic<float_sylph_t>::R_normal(prev.latitude) * std::cos(prev.latitude)),
+        d_heading(rad2deg(next.heading - prev.heading));
+    d_heading -= std::floor((d_heading + 180) / 360) * 360; // [-180, 180)
+    cerr << "(horizontal [m], height [m], velocity [m/s], heading [deg]) = ("
+        << std::sqrt(pow(d_north, 2) + pow(d_east, 2)) << ", "
+        << (next.height - prev.height) << ", "
+        << std::sqrt(pow(next.v_north - prev.v_north, 2)
+          + pow(next.v_east - prev.v_east, 2) + pow(next.v_down - prev.v_down, 2)) << ", "
+        << d_heading << ")";
+    if(prev.itow != next.itow){
+      cerr << " between " << prev.itow << " and " << next.itow;
+    }
+    cerr << endl;
+  }
+
+  for(int i(0); i < n; ++i){delete runners[i];}
 }
 
 int main(int argc, char *argv[]){
@@ -2326,15 +4437,71 @@ int main(int argc, char *argv[]){
     cerr << "(error!) too many log." << endl;
     exit(-1);
   }
+  if(options.rt_threads.enabled){
+    if(options.ins_gps_sync_strategy != Options::INS_GPS_SYNC_REALTIME){
+      cerr << "(error!) rt_threads requires --realtime." << endl;
+      exit(-1);
+    }
+    if(options.checkpoint.fname || options.checkpoint.resume_fname || options.profile_out){
+      cerr << "(error!) rt_threads cannot be used with --checkpoint, --resume, or --profile." << endl;
+      exit(-1);
+    }
+  }
+  if(options.ins_gps_sync_strategy == Options::INS_GPS_SYNC_SMOOTHING){
+    if((options.propagation_interval > 1)
+        || options.checkpoint.fname || options.checkpoint.resume_fname){
+      cerr << "(error!) smooth cannot be used with --propagation_interval(> 1), --checkpoint, or --resume." << endl;
+      exit(-1);
+    }
+  }
+  if(options.segments.number != 1){
+    if((options.ins_gps_sync_strategy != Options::INS_GPS_SYNC_OFFLINE)
+        || options.sweep.fname
+        || options.checkpoint.fname || options.checkpoint.resume_fname
+        || (options.init_yaw_bank.hypotheses > 1)
+        || (options.dump_relative.mode == Options::dump_relative_t::MODE_BASE_UNSET)
+        || options.out_shm || options.benchmark_out || options.profile_out){
+      cerr << "(error!) segments cannot be used with --realtime, --back_propagate, --smooth, --sweep, "
+          << "--checkpoint, --resume, --init_yaw_bank, --dump_relative without the base position, "
+          << "--out=shm:, --benchmark, or --profile." << endl;
+      exit(-1);
+    }
+  }
+  if(options.init_yaw_bank.hypotheses > 1){
+    if((options.ins_gps_sync_strategy == Options::INS_GPS_SYNC_REALTIME)
+        || options.sweep.fname
+        || options.checkpoint.fname || options.checkpoint.resume_fname
+        || options.profile_out){
+      cerr << "(error!) init_yaw_bank cannot be used with --realtime, --sweep, --checkpoint, --resume, or --profile." << endl;
+      exit(-1);
+    }
+  }
 
-  if(options.out_sylphide){
-    options._out = new SylphideOStream(options.out(), SYLPHIDE_PAGE_SIZE);
+  if(options.benchmark_out){benchmark.start();}
+  if(options.profile_out){Profiler::get().start();}
+
+  if(options.sweep.fname){
+    sweep();
+  }else if(options.segments.number != 1){
+    setup_output();
+    segmented();
   }else{
-    options.out() << setprecision(10);
+    setup_output();
+    loop();
   }
-  options.out_debug() << setprecision(16);
 
-  loop();
+  if(options.benchmark_out){
+    benchmark.report(*options.benchmark_out);
+    options.benchmark_out->flush();
+  }
+  if(options.profile_out){
+    if(options.profile_in_json){
+      Profiler::get().print_json(*options.profile_out);
+    }else{
+      Profiler::get().print(*options.profile_out);
+    }
+    options.profile_out->flush();
+  }
 
   return 0;
 }
@@ -0,0 +1,172 @@
+#!/usr/bin/ruby
+
+# Throughput benchmark of INS_GPS filter variants
+
+# Copyright (c) 2019 M.Naruoka (fenrir)
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without modification,
+# are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+#   this list of conditions and the following disclaimer.
+# - Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+# - Neither the name of the naruoka.org nor the names of its contributors
+#   may be used to endorse or promote products derived from this software
+#   without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+# THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+# BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+# OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+# HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+# STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+require 'json'
+require 'tempfile'
+require 'rbconfig'
+
+class INS_GPS_Benchmark
+  # name => options passed to INS_GPS
+  VARIANTS = {
+    :kf => [],
+    :kf_no_bias => ['--est_bias=off'],
+    :udkf => ['--use_udkf'],
+    :udkf_no_bias => ['--use_udkf', '--est_bias=off'],
+    :kf_egm => ['--use_egm'],
+    :kf_decimated => ['--propagation_interval=10'],
+    :udkf_decimated => ['--use_udkf', '--propagation_interval=10'],
+    :preintegrate => ['--preintegrate=5'],
+    :init_yaw_bank => ['--init_yaw_bank=8'],
+    :back_propagate => ['--back_propagate'],
+    :udkf_back_propagate => ['--use_udkf', '--back_propagate'],
+    :realtime => ['--realtime'],
+    :udkf_realtime => ['--use_udkf', '--realtime'],
+    :realtime_normal => ['--realtime', '--rt_mode=normal'],
+    :realtime_first_order => ['--realtime', '--rt_mode=first_order'],
+    :realtime_threads => ['--realtime', '--rt_threads'],
+    :calendar_time => ['--calendar_time'],
+    :smooth => ['--smooth'],
+  }
+
+  # items compared with baseline; key => true when larger is better
+  CHECK_ITEMS = {
+    'imu_samples_per_sec' => true,
+    'gps_updates_per_sec' => true,
+    'peak_rss_kb' => false,
+    'allocations' => false,
+  }
+
+  def initialize(opt = {})
+    @bin = opt[:bin]
+    @repeat = opt[:repeat] || 1
+    @extra_args = opt[:extra_args] || []
+  end
+
+  # Run a variant, and return the best (minimum CPU time) result
+  def run(log, name, args = VARIANTS[name])
+    (1..@repeat).collect{
+      Tempfile::open(['benchmark', '.json']){|f|
+        f.close
+        cmd = [@bin, *args, *@extra_args, "--out=#{File::NULL}", "--benchmark=#{f.path}", log]
+        $stderr.puts "Running #{name}: #{cmd.join(' ')}"
+        system(*cmd, :err => File::NULL) || raise("Failed: #{cmd.join(' ')}")
+        JSON::parse(File::read(f.path))
+      }
+    }.min_by{|res| res['cpu_time_sec']}.merge({'name' => name.to_s, 'args' => args})
+  end
+
+  # Compare results with baseline
+  # @return array of regression messages
+  def self.check(results, baseline, tolerance)
+    base = Hash[*(baseline.collect{|res| [res['name'], res]}.flatten(1))]
+    results.collect{|res|
+      next [] unless (ref = base[res['name']])
+      CHECK_ITEMS.collect{|k, larger_is_better|
+        next nil unless (res[k].kind_of?(Numeric) && ref[k].kind_of?(Numeric) && ref[k] > 0)
+        ratio = res[k].to_f / ref[k]
+        degraded = larger_is_better ? (ratio < (1.0 - tolerance)) : (ratio > (1.0 + tolerance))
+        degraded ? "#{res['name']}: #{k} #{ref[k]} => #{res[k]} (x#{'%.3f'%[ratio]})" : nil
+      }.compact
+    }.flatten
+  end
+end
+
+if $0 == __FILE__ then
+
+$stderr.puts <<-__STRING__
+INS_GPS benchmark
+  Usage: #{__FILE__} [options] [log.dat] > result.json
+  Options:
+    --bin=INS_GPS executable (default: build_GCC_benchmark/INS_GPS.out made by "make benchmark")
+    --variants=name1,name2,... (default: all of #{INS_GPS_Benchmark::VARIANTS.keys.join(',')})
+    --repeat=N, run each variant N times and take the fastest (default: 1)
+    --baseline=previous result.json, for regression check
+    --tolerance=allowed degradation ratio compared with baseline (default: 0.1)
+    --args=additional INS_GPS options separated by space
+  When log.dat is omitted, a synthetic log is generated by log_generator.
+__STRING__
+
+options = {}
+ARGV.reject!{|arg|
+  if arg =~ /--([^=]+)=?/ then
+    k, v = [$1.to_sym, $']
+    options[k] = v
+    true
+  else
+    false
+  end
+}
+
+tool_dir = File::dirname(__FILE__)
+exe = lambda{|name| File::join(tool_dir, 'build_GCC_benchmark', "#{name}.out")}
+variants = (options[:variants] || INS_GPS_Benchmark::VARIANTS.keys.join(',')).split(',').collect{|v|
+  v = v.to_sym
+  raise "Unknown variant: #{v}" unless INS_GPS_Benchmark::VARIANTS.include?(v)
+  v
+}
+bench = INS_GPS_Benchmark::new({
+  :bin => options[:bin] || exe.call('INS_GPS'),
+  :repeat => (options[:repeat] || 1).to_i,
+  :extra_args => (options[:args] || '').split(/\s+/).reject{|v| v.empty?},
+})
+
+log = ARGV.shift
+generated = nil
+unless log then
+  generated = Tempfile::open(['benchmark', '.dat'])
+  generated.close
+  cmd = [exe.call('log_generator'), '--profile=car', '--duration=600', '--seed=1', "--out=#{generated.path}"]
+  $stderr.puts "Generating: #{cmd.join(' ')}"
+  system(*cmd, :err => File::NULL) || raise("Failed: #{cmd.join(' ')}")
+  log = generated.path
+end
+
+results = variants.collect{|v| bench.run(log, v)}
+generated.unlink if generated
+
+$stdout.puts JSON::pretty_generate({
+  'log' => generated ? nil : log,
+  'host' => RbConfig::CONFIG['host'],
+  'results' => results,
+})
+
+if options[:baseline] then
+  baseline = JSON::parse(File::read(options[:baseline]))['results']
+  regressions = INS_GPS_Benchmark::check(results, baseline, (options[:tolerance] || 0.1).to_f)
+  unless regressions.empty? then
+    $stderr.puts "Regression detected!", regressions
+    exit(1)
+  end
+  $stderr.puts "No regression."
+end
+
+end
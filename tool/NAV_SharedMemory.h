@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __NAV_SHARED_MEMORY_H__
+#define __NAV_SHARED_MEMORY_H__
+
+/** @file
+ * @brief Navigation solutions on shared memory, which are published by INS_GPS with --out=shm:/name
+ *
+ * A consumer can read them without INS_GPS specific code, for example,
+ *   NAV_SharedMemory::Reader reader("/name");
+ *   NAV_SharedMemoryRecord rec;
+ *   NAV_SharedMemory::time_ns_t published;
+ *   while(reader.is_open()){
+ *     if(!reader.read(rec, &published)){
+ *       if(reader.closed()){break;}
+ *       continue; // or sleep
+ *     }
+ *     std::cout << rec.itow << ',' << rec.latitude << ',' << rec.longitude << std::endl;
+ *     // latency: NAV_SharedMemory::monotonic_ns() - published
+ *   }
+ * @see util/shm_ring.h
+ */
+
+#include "util/shm_ring.h"
+
+struct NAV_SharedMemoryRecord {
+  double itow; ///< time stamp [s]
+  double longitude, latitude; ///< [deg]
+  double height; ///< [m]
+  double v_north, v_east, v_down; ///< [m/s]
+  double heading, pitch, roll; ///< yaw, pitch, roll angles [deg]
+  double azimuth; ///< [deg]
+};
+
+typedef SharedMemoryRing<NAV_SharedMemoryRecord> NAV_SharedMemory;
+
+#endif /* __NAV_SHARED_MEMORY_H__ */
@@ -330,6 +330,13 @@ class G_Packet_Observer : public Packet_Observer<>{
     }
   protected:
     mutable bool validate_skippable;
+    mutable bool linearized;
+    mutable v8_t *linear_buffer;
+    /**
+     * Minimum readable length of message(), which covers the fixed offsets
+     * accessed by decode_* functions even if a packet is shorter than expected.
+     */
+    static const unsigned int linear_min_size = 128;
     bool valid_header() const {
       if(Packet_Observer<>::stored() < 2){
         return false;
@@ -356,10 +363,28 @@ class G_Packet_Observer : public Packet_Observer<>{
   public:
     G_Packet_Observer(const unsigned int &buffer_size) 
         : Packet_Observer<>(buffer_size),
-        validate_skippable(false){
+        validate_skippable(false),
+        linearized(false), linear_buffer(NULL){
+      
+    }
+    G_Packet_Observer(const G_Packet_Observer &orig)
+        : Packet_Observer<>(orig),
+        validate_skippable(false),
+        linearized(false), linear_buffer(NULL){
       
     }
-    ~G_Packet_Observer(){}
+    G_Packet_Observer &operator=(const G_Packet_Observer &another){
+      if(this != &another){
+        Packet_Observer<>::operator=(another);
+        validate_skippable = linearized = false;
+        delete [] linear_buffer;
+        linear_buffer = NULL;
+      }
+      return *this;
+    }
+    ~G_Packet_Observer(){
+      delete [] linear_buffer;
+    }
     bool ready() const {
       if(!valid_header()) return false;
       if(!valid_size()) return false;
@@ -377,7 +402,7 @@ class G_Packet_Observer : public Packet_Observer<>{
             validate() ? current_packet_size() : 1);
       }
       int _stored(Packet_Observer<>::stored());
-      validate_skippable = false;
+      validate_skippable = linearized = false;
       while(_stored > 0){
         if((u8_t)((*this)[0]) == 0xB5){
           if(_stored > 1){
@@ -403,18 +428,41 @@ class G_Packet_Observer : public Packet_Observer<>{
       return packet_type_t((unsigned char)((*this)[2]), (unsigned char)((*this)[3]));
     }
     
+    /**
+     * Linear image of the current packet, which starts with the header (0xB5, 0x62)
+     * and is readable for at least linear_min_size bytes.
+     * The packet is referred to in place when it is contiguous in the ring buffer;
+     * otherwise, it is copied only once until seek_next() is called.
+     * decode_* functions extract a whole structure from this image
+     * without further copies, and fetch_* functions are their shortcuts.
+     */
+    const v8_t *message() const {
+      if(linearized){return linear_buffer;}
+      unsigned int size(current_packet_size());
+      if(size < linear_min_size){size = linear_min_size;}
+      if((this->follower + size) <= (this->storage + this->capacity)){
+        return this->follower;
+      }
+      if(!linear_buffer){
+        linear_buffer = new v8_t[(this->capacity / 2) > linear_min_size
+            ? (this->capacity / 2) : linear_min_size];
+      }
+      this->inspect(linear_buffer, size);
+      linearized = true;
+      return linear_buffer;
+    }
+    
+    static unsigned int decode_ITOW_ms(const v8_t *msg, const unsigned int &offset = 0){
+      return le_char4_2_num<u32_t>(msg[6 + offset]);
+    }
     unsigned int fetch_ITOW_ms(const unsigned int &offset = 0) const {
-      v8_t buf[4];
-      this->inspect(buf, 4, 6 + offset);
-      return le_char4_2_num<u32_t>(*buf);
+      return decode_ITOW_ms(message(), offset);
     }
     FloatType fetch_ITOW(const unsigned int &offset = 0) const {
       return (FloatType)1E-3 * fetch_ITOW_ms(offset);
     }
     unsigned short fetch_WN() const {
-      v8_t buf[2];
-      this->inspect(buf, 2, 10);
-      return le_char2_2_num<s16_t>(*buf);
+      return le_char2_2_num<s16_t>(message()[10]);
     }
     
     struct position_t {
@@ -423,39 +471,39 @@ class G_Packet_Observer : public Packet_Observer<>{
       position_t(const FloatType &lng, const FloatType &lat, const FloatType &alt)
           : longitude(lng), latitude(lat), altitude(alt) {};
     };
-    position_t fetch_position() const {
+    static position_t decode_position(const v8_t *msg){
       //if(!packet_type().equals(0x01, 0x02)){}
       
-      v8_t buf[4];
+      const v8_t *buf(msg + 6 + 4);
       position_t pos;
-      this->inspect(buf, 4, 6 + 4);
       pos.longitude = (FloatType)1E-7 * le_char4_2_num<s32_t>(*buf);
-      this->inspect(buf, 4, 6 + 8);
-      pos.latitude = (FloatType)1E-7 * le_char4_2_num<s32_t>(*buf);
-      this->inspect(buf, 4, 6 + 12);
-      pos.altitude = (FloatType)1E-3 * le_char4_2_num<s32_t>(*buf);
+      pos.latitude = (FloatType)1E-7 * le_char4_2_num<s32_t>(*(buf + 4));
+      pos.altitude = (FloatType)1E-3 * le_char4_2_num<s32_t>(*(buf + 8));
       
       return pos;
     }
-    position_t fetch_position_hp() const {
+    position_t fetch_position() const {
+      return decode_position(message());
+    }
+    static position_t decode_position_hp(const v8_t *msg){
       //if(!packet_type().equals(0x01, 0x14)){}
 
-      v8_t buf[4];
+      const v8_t *buf(msg + 6 + 8);
       position_t pos;
-      this->inspect(buf, 4, 6 + 8);
       pos.longitude = (FloatType)1E-7 * le_char4_2_num<s32_t>(*buf);
-      this->inspect(buf, 4, 6 + 12);
-      pos.latitude = (FloatType)1E-7 * le_char4_2_num<s32_t>(*buf);
-      this->inspect(buf, 4, 6 + 16);
-      pos.altitude = (FloatType)1E-3 * le_char4_2_num<s32_t>(*buf);
+      pos.latitude = (FloatType)1E-7 * le_char4_2_num<s32_t>(*(buf + 4));
+      pos.altitude = (FloatType)1E-3 * le_char4_2_num<s32_t>(*(buf + 8));
 
-      this->inspect(buf, 3, 6 + 24);
+      buf = msg + 6 + 24;
       pos.longitude = (FloatType)1E-9 * ((s8_t)buf[0]);
       pos.latitude = (FloatType)1E-9 * ((s8_t)buf[1]);
       pos.altitude = (FloatType)1E-4 * ((s8_t)buf[2]);
 
       return pos;
     }
+    position_t fetch_position_hp() const {
+      return decode_position_hp(message());
+    }
     
     struct position_acc_t {
       FloatType horizontal, vertical;
@@ -463,30 +511,32 @@ class G_Packet_Observer : public Packet_Observer<>{
       position_acc_t(const FloatType &h_acc, const FloatType &v_acc)
           : horizontal(h_acc), vertical(v_acc) {};
     };
-    position_acc_t fetch_position_acc() const {
+    static position_acc_t decode_position_acc(const v8_t *msg){
       //if(!packet_type().equals(0x01, 0x02)){}
       
-      v8_t buf[4];
+      const v8_t *buf(msg + 6 + 20);
       position_acc_t pos_acc;
-      this->inspect(buf, 4, 6 + 20);
       pos_acc.horizontal = (FloatType)1E-3 * le_char4_2_num<u32_t>(*buf);
-      this->inspect(buf, 4, 6 + 24);
-      pos_acc.vertical = (FloatType)1E-3 * le_char4_2_num<u32_t>(*buf);
+      pos_acc.vertical = (FloatType)1E-3 * le_char4_2_num<u32_t>(*(buf + 4));
       
       return pos_acc;
     }
-    position_acc_t fetch_position_acc_hp() const {
+    position_acc_t fetch_position_acc() const {
+      return decode_position_acc(message());
+    }
+    static position_acc_t decode_position_acc_hp(const v8_t *msg){
       //if(!packet_type().equals(0x01, 0x14)){}
 
-      v8_t buf[4];
+      const v8_t *buf(msg + 6 + 28);
       position_acc_t pos_acc;
-      this->inspect(buf, 4, 6 + 28);
       pos_acc.horizontal = (FloatType)1E-4 * le_char4_2_num<u32_t>(*buf);
-      this->inspect(buf, 4, 6 + 32);
-      pos_acc.vertical = (FloatType)1E-4 * le_char4_2_num<u32_t>(*buf);
+      pos_acc.vertical = (FloatType)1E-4 * le_char4_2_num<u32_t>(*(buf + 4));
 
       return pos_acc;
     }
+    position_acc_t fetch_position_acc_hp() const {
+      return decode_position_acc_hp(message());
+    }
     
     struct velocity_t {
       FloatType north, east, down;
@@ -494,36 +544,37 @@ class G_Packet_Observer : public Packet_Observer<>{
       velocity_t(const FloatType &v_n, const FloatType &v_e, const FloatType &v_d)
           : north(v_n), east(v_e), down(v_d) {};
     };
-    velocity_t fetch_velocity() const {
+    static velocity_t decode_velocity(const v8_t *msg){
       //if(!packet_type().equals(0x01, 0x12)){}
       
-      v8_t buf[4];
+      const v8_t *buf(msg + 6 + 4);
       velocity_t vel;
-      this->inspect(buf, 4, 6 + 4);
       vel.north = (FloatType)1E-2 * le_char4_2_num<s32_t>(*buf);
-      this->inspect(buf, 4, 6 + 8);
-      vel.east = (FloatType)1E-2 * le_char4_2_num<s32_t>(*buf);
-      this->inspect(buf, 4, 6 + 12);
-      vel.down = (FloatType)1E-2 * le_char4_2_num<s32_t>(*buf);
+      vel.east = (FloatType)1E-2 * le_char4_2_num<s32_t>(*(buf + 4));
+      vel.down = (FloatType)1E-2 * le_char4_2_num<s32_t>(*(buf + 8));
       
       return vel;
     }
+    velocity_t fetch_velocity() const {
+      return decode_velocity(message());
+    }
     
     struct velocity_acc_t {
       FloatType acc;
       velocity_acc_t(){}
       velocity_acc_t(const FloatType &v_acc) : acc(v_acc) {};
     };
-    velocity_acc_t fetch_velocity_acc() const {
+    static velocity_acc_t decode_velocity_acc(const v8_t *msg){
       //if(!packet_type().equals(0x01, 0x12)){}
       
-      v8_t buf[4];
       velocity_acc_t vel_acc;
-      this->inspect(buf, 4, 6 + 28);
-      vel_acc.acc = (FloatType)1E-2 * le_char4_2_num<s32_t>(*buf);
+      vel_acc.acc = (FloatType)1E-2 * le_char4_2_num<s32_t>(msg[6 + 28]);
       
       return vel_acc;
     }
+    velocity_acc_t fetch_velocity_acc() const {
+      return decode_velocity_acc(message());
+    }
     
     struct status_t {
       unsigned int fix_type;
@@ -544,20 +595,20 @@ class G_Packet_Observer : public Packet_Observer<>{
           WN_VALID = 0x04,
           TOW_VALID = 0x08};
     };
-    status_t fetch_status() const {
+    static status_t decode_status(const v8_t *msg){
       //if(!packet_type().equals(0x01, 0x03)){}
-      v8_t buf[4];
+      const v8_t *buf(msg + 6 + 4);
       status_t status;
-      this->inspect(buf, sizeof(buf), 6 + 4);
       status.fix_type = (u8_t)buf[0];
       status.status_flags = (u8_t)buf[1];
       status.differential = (u8_t)buf[2];
-      this->inspect(buf, sizeof(buf), 6 + 8);
-      status.time_to_first_fix_ms = le_char4_2_num<u32_t>(*buf);
-      this->inspect(buf, sizeof(buf), 6 + 12);
-      status.time_to_reset_ms = le_char4_2_num<u32_t>(*buf);
+      status.time_to_first_fix_ms = le_char4_2_num<u32_t>(*(buf + 4));
+      status.time_to_reset_ms = le_char4_2_num<u32_t>(*(buf + 8));
       return status;
     }
+    status_t fetch_status() const {
+      return decode_status(message());
+    }
     
     struct svinfo_t {
       unsigned int channel_num;
@@ -569,11 +620,7 @@ class G_Packet_Observer : public Packet_Observer<>{
       int azimuth;
       int pseudo_residual;
     };
-    svinfo_t fetch_svinfo(unsigned int chn) const {
-      //if(!packet_type().equals(0x01, 0x30)){}
-      v8_t buf[12];
-      svinfo_t info;
-      this->inspect(buf, sizeof(buf), 6 + 8 + (chn * sizeof(buf)));
+    static void decode_svinfo(const v8_t *buf, svinfo_t &info){
       info.channel_num        = (u8_t)(*buf);
       info.svid               = (u8_t)(*(buf + 1));
       info.flags              = (u8_t)(*(buf + 2));
@@ -582,8 +629,34 @@ class G_Packet_Observer : public Packet_Observer<>{
       info.elevation          = (*(buf + 5));
       info.azimuth            = le_char2_2_num<s16_t>(*(buf + 6));
       info.pseudo_residual    = le_char4_2_num<s32_t>(*(buf + 8));
+    }
+    svinfo_t fetch_svinfo(unsigned int chn) const {
+      //if(!packet_type().equals(0x01, 0x30)){}
+      svinfo_t info;
+      decode_svinfo(message() + 6 + 8 + (chn * 12), info);
       return info;
     }
+    /**
+     * Decode all channels of NAV-SVINFO at once
+     *
+     * @param info array to be filled
+     * @param max_channels length of info
+     * @return number of decoded channels,
+     * which is limited by the packet size as well as max_channels
+     */
+    unsigned int fetch_svinfo(svinfo_t *info, const unsigned int &max_channels) const {
+      //if(!packet_type().equals(0x01, 0x30)){}
+      const v8_t *msg(message());
+      unsigned int channels((u8_t)msg[6 + 4]), packet_size(current_packet_size());
+      unsigned int stored(packet_size > (8 + 8) ? ((packet_size - (8 + 8)) / 12) : 0);
+      if(channels > stored){channels = stored;}
+      if(channels > max_channels){channels = max_channels;}
+      const v8_t *buf(msg + 6 + 8);
+      for(unsigned int i(0); i < channels; ++i, buf += 12){
+        decode_svinfo(buf, info[i]);
+      }
+      return channels;
+    }
     
     struct solution_t {
       short week;
@@ -607,28 +680,29 @@ class G_Packet_Observer : public Packet_Observer<>{
           WN_VALID = 0x04,
           TOW_VALID = 0x08};
     };
-    solution_t fetch_solution() const {
+    static solution_t decode_solution(const v8_t *msg){
       //if(!packet_type().equals(0x01, 0x06)){}
-      v8_t buf[16];
+      const v8_t *buf(msg + 6 + 8);
       solution_t solution;
-      this->inspect(buf, 4, 6 + 8);
       solution.week = le_char2_2_num<s16_t>(*buf);
       solution.fix_type = (u8_t)buf[2];
       solution.status_flags = (u8_t)buf[3];
-      this->inspect(buf, sizeof(buf), 6 + 12);
+      buf = msg + 6 + 12;
       solution.position_ecef_cm[0] = le_char4_2_num<s32_t>(*buf);
       solution.position_ecef_cm[1] = le_char4_2_num<s32_t>(*(buf + 4));
       solution.position_ecef_cm[2] = le_char4_2_num<s32_t>(*(buf + 8));
       solution.position_ecef_acc_cm = le_char4_2_num<u32_t>(*(buf + 12));
-      this->inspect(buf, sizeof(buf), 6 + 28);
+      buf = msg + 6 + 28;
       solution.velocity_ecef_cm_s[0] = le_char4_2_num<s32_t>(*buf);
       solution.velocity_ecef_cm_s[1] = le_char4_2_num<s32_t>(*(buf + 4));
       solution.velocity_ecef_cm_s[2] = le_char4_2_num<s32_t>(*(buf + 8));
       solution.velocity_ecef_acc_cm_s = le_char4_2_num<u32_t>(*(buf + 12));
-      this->inspect(buf, 1, 6 + 47);
-      solution.satellites_used = (u8_t)buf[0];
+      solution.satellites_used = (u8_t)msg[6 + 47];
       return solution;
     }
+    solution_t fetch_solution() const {
+      return decode_solution(message());
+    }
     
     struct utc_t {
       unsigned short year;
@@ -639,11 +713,10 @@ class G_Packet_Observer : public Packet_Observer<>{
       unsigned char seconds_of_minute;
       bool valid;
     };
-    utc_t fetch_utc() const {
+    static utc_t decode_utc(const v8_t *msg){
       //if(!packet_type().equals(0x01, 0x21)){}
-      v8_t buf[8];
+      const v8_t *buf(msg + 6 + 12);
       utc_t utc;
-      this->inspect(buf, sizeof(buf), 6 + 12);
       utc.year = le_char2_2_num<u16_t>(*buf);
       utc.month = (u8_t)buf[2];
       utc.day_of_month = (u8_t)buf[3];
@@ -653,6 +726,9 @@ class G_Packet_Observer : public Packet_Observer<>{
       utc.valid = ((u8_t)buf[7]) & 0x04;
       return utc;
     }
+    utc_t fetch_utc() const {
+      return decode_utc(message());
+    }
 
     struct gnss_svid_t {
       // @see UBX-18010854-R07 Appendix.A Satellite Numbering
@@ -818,12 +894,7 @@ class G_Packet_Observer : public Packet_Observer<>{
       int quarity, signal_strength;
       unsigned int lock_indicator;
     };
-    raw_measurement_t fetch_raw(unsigned int index) const {
-      //if(!packet_type().equals(0x02, 0x10)){}
-      
-      v8_t buf[24];
-      raw_measurement_t raw;
-      this->inspect(buf, 24, 6 + 8 + (index * 24));
+    static void decode_raw(const v8_t *buf, raw_measurement_t &raw){
       raw.carrier_phase   = le_char8_2_num<double>(*buf);
       raw.pseudo_range    = le_char8_2_num<double>(*(buf + 8));
       raw.doppler         = le_char4_2_num<float>(*(buf + 16));
@@ -831,8 +902,35 @@ class G_Packet_Observer : public Packet_Observer<>{
       raw.quarity         = (*(buf + 21));
       raw.signal_strength = (*(buf + 22));
       raw.lock_indicator  = (u8_t)(*(buf + 23));
+    }
+    raw_measurement_t fetch_raw(unsigned int index) const {
+      //if(!packet_type().equals(0x02, 0x10)){}
+      
+      raw_measurement_t raw;
+      decode_raw(message() + 6 + 8 + (index * 24), raw);
       return raw;
     }
+    /**
+     * Decode all measurements of RXM-RAW at once
+     *
+     * @param raw array to be filled
+     * @param max_measurements length of raw
+     * @return number of decoded measurements,
+     * which is limited by the packet size as well as max_measurements
+     */
+    unsigned int fetch_raw(raw_measurement_t *raw, const unsigned int &max_measurements) const {
+      //if(!packet_type().equals(0x02, 0x10)){}
+      const v8_t *msg(message());
+      unsigned int measurements((u8_t)msg[6 + 6]), packet_size(current_packet_size());
+      unsigned int stored(packet_size > (8 + 8) ? ((packet_size - (8 + 8)) / 24) : 0);
+      if(measurements > stored){measurements = stored;}
+      if(measurements > max_measurements){measurements = max_measurements;}
+      const v8_t *buf(msg + 6 + 8);
+      for(unsigned int i(0); i < measurements; ++i, buf += 24){
+        decode_raw(buf, raw[i]);
+      }
+      return measurements;
+    }
     
     struct subframe_t {
       unsigned int sv_number;
@@ -996,15 +1094,18 @@ class G_Packet_Observer : public Packet_Observer<>{
 #undef bits2s8
 #undef bits2uchar
     };
-    subframe_t &fetch_subframe(subframe_t &subframe) const {
+    static subframe_t &decode_subframe(const v8_t *msg, subframe_t &subframe){
       //if(!packet_type().equals(0x02, 0x11)){}
 
-      subframe.sv_number = (u8_t)((*this)[6 + 1]); // SVID
-      this->inspect(subframe.buffer, sizeof(subframe.buffer), 6 + 2); // buffer
+      subframe.sv_number = (u8_t)(msg[6 + 1]); // SVID
+      std::memcpy(subframe.buffer, msg + 6 + 2, sizeof(subframe.buffer)); // buffer
       subframe.update_properties();
 
       return subframe;
     }
+    subframe_t &fetch_subframe(subframe_t &subframe) const {
+      return decode_subframe(message(), subframe);
+    }
     subframe_t fetch_subframe() const {
       subframe_t subframe;
       fetch_subframe(subframe);
@@ -1067,17 +1168,14 @@ class G_Packet_Observer : public Packet_Observer<>{
     void fetch_ephemeris(EphemerisT &ephemeris) const {
       //if(!packet_type().equals(0x02, 0x31)){}
 
-      {
-        v8_t buf[8];
-        this->inspect(buf, sizeof(buf), 6); // SVID, HOW
-        ephemeris.sv_number = le_char4_2_num<s32_t>(buf[0]);
-        ephemeris.how = le_char4_2_num<s32_t>(buf[4]);
-      }
+      const v8_t *msg(message());
+      ephemeris.sv_number = le_char4_2_num<s32_t>(msg[6]); // SVID
+      ephemeris.how = le_char4_2_num<s32_t>(msg[6 + 4]); // HOW
       if((this->current_packet_size() > (8 + 8)) && ephemeris.how){
         ephemeris.valid = true;
         subframe_t subframe;
 
-#define get_subframe(n) (this->inspect(&(subframe.buffer[8]), 32, 6 + 8 + n * 32))
+#define get_subframe(n) (std::memcpy(&(subframe.buffer[8]), msg + 6 + 8 + n * 32, 32))
         get_subframe(0); // Subframe 1
         ephemeris.fetch_as_subframe1(subframe);
 
@@ -1114,30 +1212,26 @@ class G_Packet_Observer : public Packet_Observer<>{
         iono.valid = false;
       }
     };
-    health_utc_iono_t fetch_health_utc_iono() const {
+    static health_utc_iono_t decode_health_utc_iono(const v8_t *msg){
       //if(!packet_type().equals(0x0b, 0x02)){}
       health_utc_iono_t health_utc_iono;
       
       { // Valid flag
-        v8_t buf(0);
-        this->inspect(&buf, 1, 6 + 68);
-        health_utc_iono.health.valid = ((u8_t)buf & 0x01);
-        health_utc_iono.utc.valid = ((u8_t)buf & 0x02);
-        health_utc_iono.iono.valid = ((u8_t)buf & 0x04);
+        u8_t flags((u8_t)msg[6 + 68]);
+        health_utc_iono.health.valid = (flags & 0x01);
+        health_utc_iono.utc.valid = (flags & 0x02);
+        health_utc_iono.iono.valid = (flags & 0x04);
       }
       
       if(health_utc_iono.health.valid){ // Health
-        v8_t buf[4];
-        this->inspect(buf, 4, 6);
-        u32_t mask(le_char4_2_num<u32_t>(*(buf)));
+        u32_t mask(le_char4_2_num<u32_t>(msg[6]));
         for(int i(0), j(1); i < 32; i++, j<<=1){
           health_utc_iono.health.healthy[i] = (mask & j);
         }
       }
       
       if(health_utc_iono.utc.valid){ // UTC
-        v8_t buf[32];
-        this->inspect(buf, 32, 10);
+        const v8_t *buf(msg + 10);
         health_utc_iono.utc.a1    = (FloatType)le_char8_2_num<double>(*buf); 
         health_utc_iono.utc.a0    = (FloatType)le_char8_2_num<double>(*(buf + 8));
         health_utc_iono.utc.tot   = le_char4_2_num<s32_t>(*(buf + 16));
@@ -1150,8 +1244,7 @@ class G_Packet_Observer : public Packet_Observer<>{
       }
       
       if(health_utc_iono.iono.valid){ // iono
-        v8_t buf[32];
-        this->inspect(buf, 32, 42);
+        const v8_t *buf(msg + 42);
         health_utc_iono.iono.klob_a0 = (FloatType)le_char4_2_num<float>(*buf);
         health_utc_iono.iono.klob_a1 = (FloatType)le_char4_2_num<float>(*(buf + 4));
         health_utc_iono.iono.klob_a2 = (FloatType)le_char4_2_num<float>(*(buf + 8));
@@ -1164,6 +1257,9 @@ class G_Packet_Observer : public Packet_Observer<>{
       
       return health_utc_iono;
     }
+    health_utc_iono_t fetch_health_utc_iono() const {
+      return decode_health_utc_iono(message());
+    }
 };
 
 template <class FloatType = double>
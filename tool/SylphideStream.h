@@ -71,6 +71,14 @@ struct generic_SylphideProtocol {
       v_u16_t crc_u16 = 0){
     return CRC16::crc16((unsigned char *)&target[offset], size, crc_u16);
   }
+
+  static v_u16_t calc_crc16(
+      const KeyType *target,
+      const unsigned int &size,
+      const unsigned int &offset,
+      v_u16_t crc_u16 = 0){
+    return CRC16::crc16((const unsigned char *)&target[offset], size, crc_u16);
+  }
     
   /**
    * GR[hs֐
@@ -567,29 +575,87 @@ template<
 class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
   
   public:
-    class container_t : private std::deque<_Elem>{
+    /**
+     * Contiguous input buffer, which is filled in bulk
+     */
+    class container_t {
       protected:
-        typedef std::deque<_Elem> super_t;
         std::istream &in;
+        _Elem *buf;
+        unsigned int capacity, head, tail;
+        container_t(const container_t &);
+        container_t &operator=(const container_t &);
       public:
-        container_t(std::istream &_in) : super_t(), in(_in) {}
-        ~container_t(){}
+        container_t(std::istream &_in, const unsigned int &_capacity = 0x1000)
+            : in(_in), buf(new _Elem[_capacity]), capacity(_capacity), head(0), tail(0) {}
+        ~container_t(){delete [] buf;}
+        /**
+         * Read at least n elements from the input stream.
+         * Elements available without blocking are also read at once.
+         *
+         * @return (bool) true when success, otherwise false.
+         */
         bool pull(unsigned int n){
-          while(n--){
-            _Elem c;
-            in.get(c);
-            if(!in.good()){return false;}
-            super_t::push_back(c);
+          if(tail + n > capacity){
+            unsigned int size(stored());
+            if(size + n > capacity){
+              while(size + n > capacity){capacity *= 2;}
+              _Elem *buf_new(new _Elem[capacity]);
+              std::memcpy(buf_new, &buf[head], sizeof(_Elem) * size);
+              delete [] buf;
+              buf = buf_new;
+            }else{
+              std::memmove(buf, &buf[head], sizeof(_Elem) * size);
+            }
+            head = 0;
+            tail = size;
+          }
+          while(n > 0){
+            std::streamsize received(in.readsome(&buf[tail], capacity - tail));
+            if(received <= 0){ // Nothing is buffered, then wait for the required size.
+              in.read(&buf[tail], n);
+              tail += (unsigned int)in.gcount();
+              return in.good();
+            }
+            tail += (unsigned int)received;
+            n = ((unsigned int)received < n) ? (n - (unsigned int)received) : 0;
           }
           return true;
         }
         void skip(const unsigned int &n){
-          super_t::erase(super_t::begin(), super_t::begin() + n);
+          if((head += n) >= tail){head = tail = 0;}
         }
-        typename super_t::size_type stored() const {
-          return super_t::size();
+        /**
+         * Skip elements until the specified value is found.
+         *
+         * @param c value to be found
+         * @param offset search start point
+         * @return (bool) true when found, otherwise false, and all elements are skipped.
+         */
+        bool skip_until(const _Elem &c, const unsigned int &offset = 0){
+          if(offset < stored()){
+            const _Elem *found((const _Elem *)std::memchr(
+                &buf[head + offset], (unsigned char)c, sizeof(_Elem) * (stored() - offset)));
+            if(found){
+              skip(found - &buf[head]);
+              return true;
+            }
+          }
+          skip(stored());
+          return false;
+        }
+        unsigned int stored() const {
+          return tail - head;
+        }
+        _Elem *data() {
+          return &buf[head];
+        }
+        _Elem &operator[](const unsigned int &index){
+          return buf[head + index];
+        }
+        const _Elem &operator[](const unsigned int &index) const {
+          return buf[head + index];
         }
-        using super_t::operator[];
     };
   
   protected:
@@ -601,18 +667,9 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
     container_t buffer;
     bool mode_fixed_size; ///< ܂̃pPbgEȂ悤ɂ郂[h
     unsigned int payload_size;
-    _Elem *payload;
-    unsigned int payload_bufsize;
+    unsigned int packet_size; ///< Size of the packet whose payload is in the get area
     unsigned int sequence_num;
     
-    void regulate_payload(const unsigned int &min_size){
-      if(payload_bufsize < min_size){
-        delete [] payload;
-        payload_bufsize = min_size;
-        payload = new _Elem[payload_bufsize];
-      }
-    }
-    
     using super_t::eback;
     using super_t::gptr;
     using super_t::egptr;
@@ -623,6 +680,10 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
       // fR[hS
       //std::cerr << "underflow()" << std::endl;
       
+      // The get area points to the payload in the buffer, thus it is released here.
+      buffer.skip(packet_size);
+      packet_size = 0;
+
       unsigned int buffer_size_min(SylphideProtocol::capsule_size);
       bool header_checked(false);
       while(true){
@@ -633,7 +694,7 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
         }
         if(!header_checked){
           if(!SylphideProtocol::Decorder::valid_head(buffer)){
-            buffer.skip(1);
+            buffer.skip_until((_Elem)SylphideProtocol::header[0], 1);
           }else{
             header_checked = true;
             buffer_size_min = SylphideProtocol::Decorder::packet_size(buffer);
@@ -641,7 +702,8 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
           continue;
         }
         
-        if(SylphideProtocol::Decorder::validate(buffer)){
+        const unsigned char *packet((const unsigned char *)buffer.data());
+        if(SylphideProtocol::Decorder::validate(packet)){
           unsigned int new_payload_size(
               SylphideProtocol::Decorder::payload_size(buffer));
           if(new_payload_size){
@@ -654,7 +716,7 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
           }
           buffer.skip(buffer_size_min);
         }else{
-          buffer.skip(1);
+          buffer.skip_until((_Elem)SylphideProtocol::header[0], 1);
         }
         buffer_size_min = SylphideProtocol::capsule_size;
         header_checked = false;
@@ -662,13 +724,12 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
       
       sequence_num
           = SylphideProtocol::Decorder::sequence_num(buffer);
-      regulate_payload(payload_size);
-      
-      SylphideProtocol::Decorder::extract_payload(
-          buffer, payload, buffer_size_min, payload_size);
       
+      // The payload is passed without copy.
+      _Elem *payload(buffer.data()
+          + (buffer_size_min - payload_size - SylphideProtocol::capsule_tail_size));
       setg(payload, payload, payload + payload_size);
-      buffer.skip(buffer_size_min);
+      packet_size = buffer_size_min;
       
       return _Traits::to_int_type(*gptr());
     }
@@ -683,9 +744,9 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
      */
     basic_SylphideStreambuf_in(std::istream &_in)
         : buffer(_in), payload_size(0),
-        payload(NULL), payload_bufsize(0),
+        packet_size(0),
         sequence_num(0), mode_fixed_size(false) {
-      setg(payload, payload, payload);
+      setg(NULL, NULL, NULL);
     }
     /**
      * RXgN^
@@ -698,13 +759,11 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
     basic_SylphideStreambuf_in(
         std::istream &_in, const unsigned int &size)
         : buffer(_in), payload_size(size),
-        payload(NULL), payload_bufsize(0),
+        packet_size(0),
         sequence_num(0), mode_fixed_size(size > 0) {
-      setg(payload, payload, payload);
-    }
-    ~basic_SylphideStreambuf_in(){
-      delete [] payload;
+      setg(NULL, NULL, NULL);
     }
+    ~basic_SylphideStreambuf_in(){}
     
     const unsigned int &sequence_number() const {
       return sequence_num;
@@ -32,6 +32,8 @@
 #ifndef __KALMAN_H__
 #define __KALMAN_H__
 
+#include <vector>
+
 #include "param/matrix.h"
 
 /** @file
@@ -80,6 +82,9 @@ class KalmanFilter{
   protected:
     Matrix<FloatT> m_P; ///< J}tB^Ps(VXe덷Us)
     Matrix<FloatT> m_Q; ///< J}tB^Qs(͌덷Us)
+
+    typedef typename MatrixValue_Accumulator<FloatT>::res_t accum_t;
+    std::vector<accum_t> m_work; ///< work area of the structured time update
     
   public:
     /**
@@ -156,6 +161,143 @@ class KalmanFilter{
       
       predict(Phi, Gamma);
     }
+
+    /**
+     * Sparsity pattern of @f$ \Phi @f$ and @f$ \Gamma @f$ used by the structured time update.
+     * phi[i] (gamma[i]) lists the column indices of possibly non-zero elements
+     * in the i-th row of @f$ \Phi @f$ (@f$ \Gamma @f$),
+     * and the diagonal elements of @f$ \Phi @f$ must be listed.
+     * phi_offset[i] (gamma_offset[i]) is the position of the first element of the i-th row
+     * in the row-ordered list of the listed elements, and the last one is their total number.
+     * The offsets are generated once by update_offset() after phi and gamma are set.
+     */
+    struct sparsity_t {
+      std::vector<std::vector<unsigned int> > phi, gamma;
+      std::vector<unsigned int> phi_offset, gamma_offset;
+      sparsity_t &update_offset(){
+        phi_offset.assign(1, 0);
+        gamma_offset.assign(1, 0);
+        for(unsigned int i(0); i < phi.size(); ++i){
+          phi_offset.push_back(phi_offset.back() + phi[i].size());
+        }
+        for(unsigned int i(0); i < gamma.size(); ++i){
+          gamma_offset.push_back(gamma_offset.back() + gamma[i].size());
+        }
+        return *this;
+      }
+    };
+
+    /**
+     * Structured time update, which skips the elements known to be zero by the sparsity pattern.
+     * Its result is identical to predict(Phi, Gamma) except for rounding errors,
+     * and @f$ P @f$ is kept symmetric.
+     * The products are accumulated in MatrixValue_Accumulator<FloatT>::res_t.
+     * The pattern should have the offsets generated by sparsity_t::update_offset();
+     * otherwise, they are generated for every call.
+     *
+     * @param Phi @f$ \Phi @f$ matrix
+     * @param Gamma @f$ \Gamma @f$ matrix
+     * @param pattern sparsity pattern of Phi and Gamma
+     */
+    virtual void predict(
+        const Matrix<FloatT> &Phi, const Matrix<FloatT> &Gamma,
+        const sparsity_t &pattern){
+      const unsigned int n(m_P.rows()), q(m_Q.rows());
+      if(pattern.phi_offset.size() != n + 1){
+        sparsity_t pattern2(pattern);
+        predict(Phi, Gamma, pattern2.update_offset());
+        return;
+      }
+
+      // work area, which is allocated at the first call only
+      const unsigned int phi_size(pattern.phi_offset[n]), gamma_size(pattern.gamma_offset[n]);
+      m_work.resize(n * n * 2 + n * q + phi_size + gamma_size);
+      accum_t *P(&m_work[0]), *PhiP(&P[n * n]), *GammaQ(&PhiP[n * n]),
+          *phi_v(&GammaQ[n * q]), *gamma_v(&phi_v[phi_size]);
+
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int j(0); j < n; ++j){P[i * n + j] = m_P(i, j);}
+      }
+
+      // non-zero elements of Phi and Gamma in row order
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int e(pattern.phi_offset[i]), t(0); e < pattern.phi_offset[i + 1]; ++e, ++t){
+          phi_v[e] = Phi(i, pattern.phi[i][t]);
+        }
+        for(unsigned int e(pattern.gamma_offset[i]), t(0); e < pattern.gamma_offset[i + 1]; ++e, ++t){
+          gamma_v[e] = Gamma(i, pattern.gamma[i][t]);
+        }
+      }
+
+      // Phi * P, and Gamma * Q
+      for(unsigned int i(0); i < n; ++i){
+        accum_t *row(&PhiP[i * n]);
+        for(unsigned int k(0); k < n; ++k){row[k] = 0;}
+        for(unsigned int e(pattern.phi_offset[i]), t(0); e < pattern.phi_offset[i + 1]; ++e, ++t){
+          const accum_t *src(&P[pattern.phi[i][t] * n]);
+          for(unsigned int k(0); k < n; ++k){row[k] += phi_v[e] * src[k];}
+        }
+        for(unsigned int b(0); b < q; ++b){
+          accum_t sum(0);
+          for(unsigned int e(pattern.gamma_offset[i]), t(0); e < pattern.gamma_offset[i + 1]; ++e, ++t){
+            sum += gamma_v[e] * m_Q(pattern.gamma[i][t], b);
+          }
+          GammaQ[i * q + b] = sum;
+        }
+      }
+
+      // (Phi * P) * Phi^{T} + (Gamma * Q) * Gamma^{T}, upper triangle is mirrored
+      for(unsigned int l(0); l < n; ++l){
+        for(unsigned int i(0); i <= l; ++i){
+          accum_t sum(0);
+          const accum_t *row(&PhiP[i * n]);
+          for(unsigned int e(pattern.phi_offset[l]), t(0); e < pattern.phi_offset[l + 1]; ++e, ++t){
+            sum += row[pattern.phi[l][t]] * phi_v[e];
+          }
+          const accum_t *row2(&GammaQ[i * q]);
+          for(unsigned int e(pattern.gamma_offset[l]), t(0); e < pattern.gamma_offset[l + 1]; ++e, ++t){
+            sum += row2[pattern.gamma[l][t]] * gamma_v[e];
+          }
+          P[i * n + l] = P[l * n + i] = sum;
+        }
+      }
+
+      m_P = Matrix<FloatT>(n, n);
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int j(0); j < n; ++j){m_P(i, j) = P[i * n + j];}
+      }
+    }
+
+    /**
+     * Structured version of predict(A, B, delta)
+     *
+     * @param A @f$ A @f$ matrix
+     * @param B @f$ B @f$ matrix
+     * @param delta time interval
+     * @param pattern sparsity pattern of @f$ \Phi = I + A \Delta t @f$ and @f$ \Gamma = B \Delta t @f$
+     */
+    void predict(
+        const Matrix<FloatT> &A, const Matrix<FloatT> &B, const FloatT &delta,
+        const sparsity_t &pattern){
+      Matrix<FloatT> Phi = A * delta;
+      for(unsigned i = 0; i < Phi.rows(); i++) Phi(i, i) += 1;
+      predict(Phi, B * delta, pattern);
+    }
+
+    /**
+     * Time update with the discrete-time process noise covariance
+     * @f[
+     *   P_{k+1} = \Phi P_{k} \Phi^{T} + Q_{d}
+     * @f]
+     * which is used when the transition over several steps is aggregated,
+     * and @f$ Q_{d} @f$ is no longer represented by @f$ \Gamma Q \Gamma^{T} @f$.
+     *
+     * @param Phi @f$ \Phi @f$ matrix
+     * @param Q_d discrete-time process noise covariance
+     */
+    virtual void predict_with_noise(const Matrix<FloatT> &Phi, const Matrix<FloatT> &Q_d){
+      (m_P = Phi * m_P * Phi.transpose()) += Q_d;
+    }
     
     /**
      * tB^[ϑXV(C)A̍ۂ̃J}QC߂܂B
@@ -327,6 +469,27 @@ class InformationFilter : public KalmanFilter<FloatT>{
       std::cerr << "predict_IF_P:" << getP() << std::endl;
 #endif
     }
+
+    /**
+     * Structured time update, which is fallen back to the dense one
+     * because the information matrix is not sparse.
+     */
+    void predict(
+        const Matrix<FloatT> &Phi, const Matrix<FloatT> &Gamma,
+        const typename KalmanFilter<FloatT>::sparsity_t &pattern){
+      predict(Phi, Gamma);
+    }
+
+    /**
+     * Time update with the discrete-time process noise covariance,
+     * which is performed via the covariance form.
+     *
+     * @param Phi @f$ \Phi @f$ matrix
+     * @param Q_d discrete-time process noise covariance
+     */
+    void predict_with_noise(const Matrix<FloatT> &Phi, const Matrix<FloatT> &Q_d){
+      setP(Phi * getP() * Phi.transpose() + Q_d);
+    }
     
     /**
      * tB^[ϑXV(C)A̍ۂ̃J}QC߂܂B
@@ -542,6 +705,96 @@ class KalmanFilterUD : public KalmanFilter<FloatT>{
       std::cerr << "predict_UDKF_P:" << getP() << std::endl;
 #endif
     }
+
+    /**
+     * Structured time update.
+     * @f$ \Phi U @f$ is calculated with the non-zero elements of @f$ \Phi @f$ and
+     * the upper triangular structure of @f$ U @f$, and the following
+     * modified weighted Gram-Schmidt orthogonalization is performed on plain arrays
+     * of MatrixValue_Accumulator<FloatT>::res_t.
+     * As predict(Phi, Gamma), the diagonal elements of @f$ Q @f$ are only used.
+     *
+     * @param Phi @f$ \Phi @f$ matrix
+     * @param Gamma @f$ \Gamma @f$ matrix
+     * @param pattern sparsity pattern of Phi and Gamma
+     */
+    void predict(
+        const Matrix<FloatT> &Phi, const Matrix<FloatT> &Gamma,
+        const typename KalmanFilter<FloatT>::sparsity_t &pattern){
+      typedef typename KalmanFilter<FloatT>::accum_t accum_t;
+      const unsigned int n(m_U.rows()), q(Gamma.columns()), w(n + q);
+      std::vector<accum_t> &work(KalmanFilter<FloatT>::m_work);
+      work.resize(n * n + n * w + w * 2 + n); // allocated at the first call only
+      accum_t *U(&work[0]), *W(&U[n * n]), *weight(&W[n * w]), *Z(&weight[w]), *D(&Z[w]);
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int j(0); j < n; ++j){U[i * n + j] = m_U(i, j);}
+        weight[i] = m_D(i, i);
+      }
+      for(unsigned int i(0); i < q; ++i){
+        weight[n + i] = KalmanFilter<FloatT>::m_Q(i, i);
+      }
+
+      // W = [Phi * U, Gamma]
+      for(unsigned int i(0); i < n; ++i){
+        accum_t *row(&W[i * w]);
+        for(unsigned int k(0); k < w; ++k){row[k] = 0;}
+        for(std::vector<unsigned int>::const_iterator it(pattern.phi[i].begin());
+            it != pattern.phi[i].end(); ++it){
+          accum_t phi(Phi(i, *it));
+          const accum_t *src(&U[*it * n]);
+          for(unsigned int k(*it); k < n; ++k){row[k] += phi * src[k];}
+        }
+        for(std::vector<unsigned int>::const_iterator it(pattern.gamma[i].begin());
+            it != pattern.gamma[i].end(); ++it){
+          row[n + *it] = Gamma(i, *it);
+        }
+      }
+
+      for(int j = (int)n - 1; j > 0; j--){
+        const accum_t *V(&W[j * w]);
+        accum_t d(0);
+        for(unsigned int k(0); k < w; ++k){
+          Z[k] = V[k] * weight[k];
+          d += Z[k] * V[k];
+        }
+        D[j] = d;
+        for(int i = 0; i < j; i++){
+          accum_t *row(&W[i * w]);
+          accum_t u(0);
+          for(unsigned int k(0); k < w; ++k){u += row[k] * Z[k];}
+          u /= d;
+          U[i * n + j] = u;
+          for(unsigned int k(0); k < w; ++k){row[k] -= u * V[k];}
+        }
+      }
+      D[0] = 0;
+      for(unsigned int k(0); k < w; ++k){
+        D[0] += W[k] * W[k] * weight[k];
+      }
+
+      m_U = Matrix<FloatT>(n, n);
+      m_D = Matrix<FloatT>(n, n);
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int j(0); j < n; ++j){m_U(i, j) = U[i * n + j];}
+        m_D(i, i) = D[i];
+      }
+
+      // P should be recalculated
+      need_update_P = true;
+    }
+
+    /**
+     * Time update with the discrete-time process noise covariance.
+     * @f$ P @f$ is recovered, propagated, and then UD decomposed again.
+     *
+     * @param Phi @f$ \Phi @f$ matrix
+     * @param Q_d discrete-time process noise covariance
+     */
+    void predict_with_noise(const Matrix<FloatT> &Phi, const Matrix<FloatT> &Q_d){
+      updateP();
+      setP(Phi * KalmanFilter<FloatT>::m_P * Phi.transpose() + Q_d);
+      need_update_P = true;
+    }
     
     /**
      * tB^[ϑXV(C)A̍ۂ̃J}QC߂܂B
@@ -558,39 +811,54 @@ class KalmanFilterUD : public KalmanFilter<FloatT>{
 #endif
       
       // J}QC
-      Matrix<FloatT> K(KalmanFilter<FloatT>::m_P.rows(), R.rows());
+      // Bierman's update is performed on plain arrays of MatrixValue_Accumulator<FloatT>::res_t.
+      typedef typename MatrixValue_Accumulator<FloatT>::res_t accum_t;
+      const unsigned int n(m_U.rows()), m(R.rows());
+      std::vector<accum_t> U(n * n), D(n), K_(n * m), f(n), g(n);
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int j(0); j < n; ++j){U[i * n + j] = m_U(i, j);}
+        D[i] = m_D(i, i);
+      }
       
-      for(unsigned int k = 0; k < R.rows(); k++){
-        Matrix<FloatT> f(m_U.columns(), H.rows());
-        Matrix<FloatT> g(m_D.rows(), f.columns());
-        
+      for(unsigned int k = 0; k < m; k++){
         // f̐
-        for(unsigned int i = 0; i < f.rows(); i++){
+        for(unsigned int i = 0; i < n; i++){
+          f[i] = 0;
           for(unsigned int j = 0; j <= i; j++){
-            f(i, 0) += H(k, j) * m_U(j, i);
+            f[i] += H(k, j) * U[j * n + i];
           }
         }
         
         // g̐
-        for(unsigned int i = 0; i < g.rows(); i++){
-          g(i, 0) = m_D(i, i) * f(i, 0);
+        for(unsigned int i = 0; i < n; i++){
+          g[i] = D[i] * f[i];
         }
         
-        FloatT r(R(k, k));
-        FloatT alpha = r + f(0, 0) * g(0, 0);
-        K(0, k) = g(0, 0);
-        m_D(0, 0) *= (r / alpha);
+        accum_t r(R(k, k));
+        accum_t alpha = r + f[0] * g[0];
+        K_[k] = g[0];
+        D[0] *= (r / alpha);
         
-        for(unsigned int j = 1; j < f.rows(); j++){
-          FloatT _alpha(alpha + f(j, 0) * g(j, 0));
-          m_D(j, j) *= (alpha / _alpha);
-          FloatT lambda(f(j, 0) / alpha);
-          Matrix<FloatT> _u(m_U.columnVector(j).copy());
-          m_U.columnVector(j) -= lambda * K.columnVector(k);
-          K.columnVector(k) += g(j, 0) * _u;
+        for(unsigned int j = 1; j < n; j++){
+          accum_t _alpha(alpha + f[j] * g[j]);
+          D[j] *= (alpha / _alpha);
+          accum_t lambda(f[j] / alpha);
+          for(unsigned int i = 0; i < n; i++){
+            accum_t _u(U[i * n + j]);
+            U[i * n + j] = _u - K_[i * m + k] * lambda;
+            K_[i * m + k] += _u * g[j];
+          }
           alpha = _alpha;
         }
-        K.columnVector(k) /= alpha;
+        accum_t alpha_inv(accum_t(1) / alpha);
+        for(unsigned int i = 0; i < n; i++){K_[i * m + k] *= alpha_inv;}
+      }
+      
+      Matrix<FloatT> K(n, m);
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int j(0); j < n; ++j){m_U(i, j) = U[i * n + j];}
+        m_D(i, i) = D[i];
+        for(unsigned int k(0); k < m; ++k){K(i, k) = K_[i * m + k];}
       }
       
       //sP̍XV
@@ -617,6 +885,19 @@ class KalmanFilterUD : public KalmanFilter<FloatT>{
      * @return (Matrix<FloatT>) s@f$ D @f$
      */
     const Matrix<FloatT> &getD() const {return m_D;}
+
+    /**
+     * UDς݂̍s@f$ U @f$, @f$ D @f$𒼐ڐݒ肵܂B
+     * setP()ƈقȂ蕪𔺂Ȃ߁AۑԂ덷Ȃł܂B
+     *
+     * @param U s@f$ U @f$
+     * @param D s@f$ D @f$
+     */
+    void setUD(const Matrix<FloatT> &U, const Matrix<FloatT> &D){
+      m_U = U;
+      m_D = D;
+      need_update_P = true;
+    }
 };
 
 /**
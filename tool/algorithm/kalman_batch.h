@@ -0,0 +1,603 @@
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __KALMAN_BATCH_H__
+#define __KALMAN_BATCH_H__
+
+/** @file
+ * @brief Batched Kalman filter, which processes many filters of the same model in lockstep
+ *
+ * KalmanFilterBatch holds the covariance matrices of many filters
+ * in the structure-of-arrays layout; the same element of several filters (lanes)
+ * is stored contiguously, thus the time and measurement updates are performed
+ * for all filters at once with loops over lanes, which are vectorized by the compiler.
+ * KalmanFilterBatched is a filter to be passed to Filtered_INS2 as its Filter parameter,
+ * and it forwards the updates to KalmanFilterBatch after KalmanFilterBatched::attach().
+ * Therefore the system and observation models such as Filtered_INS2::getAB()
+ * and INS_GPS2::correct_info() are reused without any modification.
+ *
+ * @see INS_GPS_Batch
+ */
+
+#include <vector>
+#include <cmath>
+
+#include "param/matrix.h"
+#include "algorithm/kalman.h"
+
+/**
+ * @brief Covariance matrices of many Kalman filters in structure-of-arrays layout
+ *
+ * The time update is deferred; set_transition() stores @f$ \Phi @f$ and @f$ \Gamma @f$
+ * of a filter, and predict() propagates all the filters together.
+ * Filters without transition are kept unchanged by using @f$ \Phi = I @f$.
+ * The measurement update is also performed together by prepare_correct(),
+ * set_measurement(), and correct(), then the Kalman gain of each filter is picked up by gain().
+ * Filters without measurement are kept unchanged, because their observation matrix is zero.
+ * The computation is performed in MatrixValue_Accumulator<FloatT>::res_t.
+ *
+ * @param FloatT precision
+ */
+template <class FloatT>
+class KalmanFilterBatch {
+  public:
+    typedef typename MatrixValue_Accumulator<FloatT>::res_t value_t;
+    typedef typename KalmanFilter<FloatT>::sparsity_t sparsity_t;
+    typedef std::vector<value_t> buf_t;
+
+    static const unsigned int lanes = 8; ///< number of filters processed in an innermost loop
+
+  protected:
+    const unsigned int n; ///< size of P
+    const unsigned int q; ///< size of Q
+    const unsigned int filters;
+    const unsigned int blocks; ///< number of blocks each of which contains lanes filters
+    sparsity_t pattern;
+    /**
+     * Offset of each row in the compact storage of @f$ \Phi @f$ and @f$ \Gamma @f$,
+     * where only the elements listed in the sparsity pattern are stored.
+     * The last one is the number of the stored elements.
+     */
+    std::vector<unsigned int> phi_offset, gamma_offset;
+
+    buf_t m_P, m_Q, m_Phi, m_Gamma, m_Q_d;
+    std::vector<bool> pending;
+    bool any_pending, with_noise;
+
+    unsigned int m_max; ///< maximum number of observations
+    buf_t m_H, m_R, m_K;
+    std::vector<unsigned int> observations; ///< 0 means no measurement
+
+    buf_t PhiP, GammaQ, PHt, S; ///< work area for a block
+
+    /**
+     * Element of the i-th filter
+     *
+     * @param buf buffer
+     * @param size number of elements per filter
+     * @param element element index
+     * @param i filter index
+     */
+    static value_t &at(buf_t &buf, const unsigned int &size,
+        const unsigned int &element, const unsigned int &i){
+      return buf[((i / lanes) * size + element) * lanes + (i % lanes)];
+    }
+
+    static std::vector<unsigned int> offset(const std::vector<std::vector<unsigned int> > &rows){
+      std::vector<unsigned int> res(1, 0);
+      for(std::vector<std::vector<unsigned int> >::const_iterator it(rows.begin());
+          it != rows.end(); ++it){
+        res.push_back(res.back() + it->size());
+      }
+      return res;
+    }
+
+    /**
+     * Reset the transition of the filters in a block to @f$ \Phi = I @f$ without noise.
+     */
+    void reset_transition(const unsigned int &block){
+      const unsigned int phi_size(phi_offset.back()), gamma_size(gamma_offset.back());
+      value_t *Phi(&m_Phi[block * phi_size * lanes]);
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int e(phi_offset[i]), t(0); e < phi_offset[i + 1]; ++e, ++t){
+          const value_t v((pattern.phi[i][t] == i) ? 1 : 0);
+          for(unsigned int k(0); k < lanes; ++k){Phi[e * lanes + k] = v;}
+        }
+      }
+      value_t *Gamma(&m_Gamma[block * gamma_size * lanes]);
+      for(unsigned int e(0); e < gamma_size * lanes; ++e){Gamma[e] = 0;}
+      if(with_noise){
+        value_t *Q_d(&m_Q_d[block * n * n * lanes]);
+        for(unsigned int e(0); e < n * n * lanes; ++e){Q_d[e] = 0;}
+      }
+    }
+
+    static sparsity_t dense(const unsigned int &n, const unsigned int &q){
+      sparsity_t res;
+      res.phi.resize(n);
+      res.gamma.resize(n);
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int j(0); j < n; ++j){res.phi[i].push_back(j);}
+        for(unsigned int j(0); j < q; ++j){res.gamma[i].push_back(j);}
+      }
+      return res;
+    }
+
+  public:
+    /**
+     * Constructor, where P and Q of all filters are initialized with zero.
+     *
+     * @param P_size size of P
+     * @param Q_size size of Q
+     * @param size number of filters
+     * @param sparsity sparsity pattern of @f$ \Phi @f$ and @f$ \Gamma @f$ shared by all filters.
+     * NULL means dense, which is required for the aggregated time update
+     * with set_transition_with_noise().
+     */
+    KalmanFilterBatch(
+        const unsigned int &P_size, const unsigned int &Q_size, const unsigned int &size,
+        const sparsity_t *sparsity = NULL)
+        : n(P_size), q(Q_size), filters(size), blocks((size + lanes - 1) / lanes),
+        pattern(sparsity ? *sparsity : dense(P_size, Q_size)),
+        phi_offset(offset(pattern.phi)), gamma_offset(offset(pattern.gamma)),
+        m_P(blocks * n * n * lanes), m_Q(blocks * q * q * lanes),
+        m_Phi(blocks * phi_offset.back() * lanes), m_Gamma(blocks * gamma_offset.back() * lanes),
+        m_Q_d(blocks * n * n * lanes),
+        pending(size, false), any_pending(false), with_noise(false),
+        m_max(0), m_H(), m_R(), m_K(), observations(size, 0),
+        PhiP(n * n * lanes), GammaQ(n * q * lanes), PHt(), S() {
+      for(unsigned int i(0); i < blocks; ++i){reset_transition(i);}
+    }
+
+    unsigned int size() const {return filters;}
+    unsigned int P_size() const {return n;}
+    unsigned int Q_size() const {return q;}
+
+    /**
+     * Get P of the i-th filter, where the pending time update is performed in advance.
+     */
+    Matrix<FloatT> getP(const unsigned int &i){
+      predict();
+      Matrix<FloatT> res(n, n);
+      for(unsigned int j(0); j < n; ++j){
+        for(unsigned int k(0); k < n; ++k){res(j, k) = at(m_P, n * n, j * n + k, i);}
+      }
+      return res;
+    }
+    void setP(const unsigned int &i, const Matrix<FloatT> &P){
+      predict();
+      for(unsigned int j(0); j < n; ++j){
+        for(unsigned int k(0); k < n; ++k){at(m_P, n * n, j * n + k, i) = P(j, k);}
+      }
+    }
+    void setQ(const unsigned int &i, const Matrix<FloatT> &Q){
+      predict();
+      for(unsigned int j(0); j < q; ++j){
+        for(unsigned int k(0); k < q; ++k){at(m_Q, q * q, j * q + k, i) = Q(j, k);}
+      }
+    }
+
+    /**
+     * Store the transition of the i-th filter,
+     * where the pending one of the same filter is applied in advance.
+     * Elements outside of the sparsity pattern are ignored.
+     *
+     * @param i filter index
+     * @param Phi @f$ \Phi @f$ matrix
+     * @param Gamma @f$ \Gamma @f$ matrix
+     */
+    void set_transition(const unsigned int &i, const Matrix<FloatT> &Phi, const Matrix<FloatT> &Gamma){
+      if(pending[i]){predict();}
+      for(unsigned int j(0); j < n; ++j){
+        for(unsigned int e(phi_offset[j]), t(0); e < phi_offset[j + 1]; ++e, ++t){
+          at(m_Phi, phi_offset.back(), e, i) = Phi(j, pattern.phi[j][t]);
+        }
+        for(unsigned int e(gamma_offset[j]), t(0); e < gamma_offset[j + 1]; ++e, ++t){
+          at(m_Gamma, gamma_offset.back(), e, i) = Gamma(j, pattern.gamma[j][t]);
+        }
+      }
+      pending[i] = any_pending = true;
+    }
+
+    /**
+     * Store the transition of the i-th filter in the continuous-time form,
+     * @f$ \Phi = I + A \Delta t @f$ and @f$ \Gamma = B \Delta t @f$,
+     * without temporary matrices.
+     *
+     * @param i filter index
+     * @param A @f$ A @f$ matrix
+     * @param B @f$ B @f$ matrix
+     * @param delta time interval
+     */
+    void set_transition(const unsigned int &i,
+        const Matrix<FloatT> &A, const Matrix<FloatT> &B, const FloatT &delta){
+      if(pending[i]){predict();}
+      for(unsigned int j(0); j < n; ++j){
+        for(unsigned int e(phi_offset[j]), t(0); e < phi_offset[j + 1]; ++e, ++t){
+          FloatT v(A(j, pattern.phi[j][t]) * delta);
+          if(pattern.phi[j][t] == j){v += 1;}
+          at(m_Phi, phi_offset.back(), e, i) = v;
+        }
+        for(unsigned int e(gamma_offset[j]), t(0); e < gamma_offset[j + 1]; ++e, ++t){
+          at(m_Gamma, gamma_offset.back(), e, i) = B(j, pattern.gamma[j][t]) * delta;
+        }
+      }
+      pending[i] = any_pending = true;
+    }
+
+    /**
+     * Store the transition of the i-th filter with the discrete-time process noise covariance,
+     * @f$ P_{k+1} = \Phi P_{k} \Phi^{T} + Q_{d} @f$.
+     *
+     * @param i filter index
+     * @param Phi @f$ \Phi @f$ matrix
+     * @param Q_d discrete-time process noise covariance
+     */
+    void set_transition_with_noise(const unsigned int &i, const Matrix<FloatT> &Phi, const Matrix<FloatT> &Q_d){
+      if(pending[i]){predict();}
+      for(unsigned int j(0); j < n; ++j){
+        for(unsigned int e(phi_offset[j]), t(0); e < phi_offset[j + 1]; ++e, ++t){
+          at(m_Phi, phi_offset.back(), e, i) = Phi(j, pattern.phi[j][t]);
+        }
+        for(unsigned int k(0); k < n; ++k){
+          at(m_Q_d, n * n, j * n + k, i) = Q_d(j, k);
+        }
+      }
+      pending[i] = any_pending = with_noise = true;
+    }
+
+    /**
+     * Perform the pending time updates of all filters,
+     * @f$ P_{k+1} = \Phi P_{k} \Phi^{T} + \Gamma Q \Gamma^{T} (+ Q_{d}) @f$.
+     * The order of the products for each filter is same as KalmanFilter::predict()
+     * with the sparsity pattern.
+     */
+    void predict(){
+      if(!any_pending){return;}
+      const unsigned int phi_size(phi_offset.back()), gamma_size(gamma_offset.back());
+      for(unsigned int blk(0); blk < blocks; ++blk){
+        value_t *P(&m_P[blk * n * n * lanes]);
+        const value_t
+            *Phi(&m_Phi[blk * phi_size * lanes]), *Gamma(&m_Gamma[blk * gamma_size * lanes]),
+            *Q(&m_Q[blk * q * q * lanes]), *Q_d(&m_Q_d[blk * n * n * lanes]);
+
+        // Phi * P, and Gamma * Q
+        for(unsigned int i(0); i < n; ++i){
+          for(unsigned int j(0); j < n; ++j){
+            value_t sum[lanes];
+            for(unsigned int k(0); k < lanes; ++k){sum[k] = 0;}
+            for(unsigned int e(phi_offset[i]), t(0); e < phi_offset[i + 1]; ++e, ++t){
+              const value_t *a(&Phi[e * lanes]), *c(&P[(pattern.phi[i][t] * n + j) * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){sum[k] += a[k] * c[k];}
+            }
+            value_t *dst(&PhiP[(i * n + j) * lanes]);
+            for(unsigned int k(0); k < lanes; ++k){dst[k] = sum[k];}
+          }
+          for(unsigned int j(0); j < q; ++j){
+            value_t sum[lanes];
+            for(unsigned int k(0); k < lanes; ++k){sum[k] = 0;}
+            for(unsigned int e(gamma_offset[i]), t(0); e < gamma_offset[i + 1]; ++e, ++t){
+              const value_t *a(&Gamma[e * lanes]), *c(&Q[(pattern.gamma[i][t] * q + j) * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){sum[k] += a[k] * c[k];}
+            }
+            value_t *dst(&GammaQ[(i * q + j) * lanes]);
+            for(unsigned int k(0); k < lanes; ++k){dst[k] = sum[k];}
+          }
+        }
+
+        // (Phi * P) * Phi^{T} + (Gamma * Q) * Gamma^{T}, upper triangle is mirrored
+        for(unsigned int l(0); l < n; ++l){
+          for(unsigned int i(0); i <= l; ++i){
+            value_t sum[lanes];
+            for(unsigned int k(0); k < lanes; ++k){sum[k] = 0;}
+            for(unsigned int e(phi_offset[l]), t(0); e < phi_offset[l + 1]; ++e, ++t){
+              const value_t *a(&PhiP[(i * n + pattern.phi[l][t]) * lanes]), *c(&Phi[e * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){sum[k] += a[k] * c[k];}
+            }
+            for(unsigned int e(gamma_offset[l]), t(0); e < gamma_offset[l + 1]; ++e, ++t){
+              const value_t *a(&GammaQ[(i * q + pattern.gamma[l][t]) * lanes]), *c(&Gamma[e * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){sum[k] += a[k] * c[k];}
+            }
+            if(with_noise){
+              const value_t *a(&Q_d[(i * n + l) * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){sum[k] += a[k];}
+            }
+            value_t *dst(&P[(i * n + l) * lanes]), *dst2(&P[(l * n + i) * lanes]);
+            for(unsigned int k(0); k < lanes; ++k){dst[k] = dst2[k] = sum[k];}
+          }
+        }
+
+        reset_transition(blk); // while the block is in cache
+      }
+      pending.assign(filters, false);
+      any_pending = with_noise = false;
+    }
+
+    /**
+     * Prepare the measurement update, where all filters have no measurement.
+     *
+     * @param max_observations maximum number of observations of set_measurement()
+     */
+    void prepare_correct(const unsigned int &max_observations){
+      m_max = max_observations;
+      m_H.assign(blocks * m_max * n * lanes, 0);
+      m_R.assign(blocks * m_max * m_max * lanes, 0);
+      m_K.assign(blocks * n * m_max * lanes, 0);
+      for(unsigned int i(0); i < blocks * lanes; ++i){
+        for(unsigned int r(0); r < m_max; ++r){
+          m_R[((i / lanes) * m_max * m_max + r * m_max + r) * lanes + (i % lanes)] = 1;
+        }
+      }
+      observations.assign(filters, 0);
+      PHt.resize(n * m_max * lanes);
+      S.resize(m_max * m_max * lanes);
+    }
+
+    /**
+     * Set the measurement of the i-th filter, whose rows must not exceed
+     * the value specified with prepare_correct().
+     *
+     * @param i filter index
+     * @param H @f$ H @f$ matrix (observation matrix)
+     * @param R observation error covariance matrix @f$ R @f$
+     */
+    void set_measurement(const unsigned int &i, const Matrix<FloatT> &H, const Matrix<FloatT> &R){
+      const unsigned int m(H.rows());
+      for(unsigned int r(0); r < m; ++r){
+        for(unsigned int j(0); j < n; ++j){at(m_H, m_max * n, r * n + j, i) = H(r, j);}
+        for(unsigned int s(0); s < m; ++s){at(m_R, m_max * m_max, r * m_max + s, i) = R(r, s);}
+      }
+      observations[i] = m;
+    }
+
+    /**
+     * Perform the measurement updates of all filters,
+     * @f{gather*}
+     *   K = P H^{T} \left( H P H^{T} + R \right)^{-1}, \\
+     *   P \leftarrow P - K H P,
+     * @f}
+     * where the inverse is solved with Cholesky decomposition and @f$ P @f$ is kept symmetric.
+     */
+    void correct(){
+      predict();
+      const unsigned int m(m_max);
+      for(unsigned int b(0); b < blocks; ++b){
+        value_t *P(&m_P[b * n * n * lanes]), *K(&m_K[b * n * m * lanes]);
+        const value_t *H(&m_H[b * m * n * lanes]), *R(&m_R[b * m * m * lanes]);
+
+        // P * H^{T}
+        for(unsigned int i(0); i < n; ++i){
+          for(unsigned int r(0); r < m; ++r){
+            value_t *dst(&PHt[(i * m + r) * lanes]);
+            for(unsigned int k(0); k < lanes; ++k){dst[k] = 0;}
+            for(unsigned int j(0); j < n; ++j){
+              const value_t *a(&P[(i * n + j) * lanes]), *h(&H[(r * n + j) * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){dst[k] += a[k] * h[k];}
+            }
+          }
+        }
+
+        // H * P * H^{T} + R, and its Cholesky decomposition L (lower triangle of S)
+        for(unsigned int r(0); r < m; ++r){
+          for(unsigned int s(0); s <= r; ++s){
+            value_t *dst(&S[(r * m + s) * lanes]);
+            const value_t *a(&R[(r * m + s) * lanes]);
+            for(unsigned int k(0); k < lanes; ++k){dst[k] = a[k];}
+            for(unsigned int j(0); j < n; ++j){
+              const value_t *h(&H[(r * n + j) * lanes]), *ph(&PHt[(j * m + s) * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){dst[k] += h[k] * ph[k];}
+            }
+          }
+        }
+        for(unsigned int r(0); r < m; ++r){
+          for(unsigned int s(0); s <= r; ++s){
+            value_t *dst(&S[(r * m + s) * lanes]);
+            for(unsigned int t(0); t < s; ++t){
+              const value_t *a(&S[(r * m + t) * lanes]), *c(&S[(s * m + t) * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){dst[k] -= a[k] * c[k];}
+            }
+            if(r == s){
+              for(unsigned int k(0); k < lanes; ++k){dst[k] = std::sqrt(dst[k]);}
+            }else{
+              const value_t *d(&S[(s * m + s) * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){dst[k] /= d[k];}
+            }
+          }
+        }
+
+        // K = (P * H^{T}) * S^{-1}, i.e., S * K^{T} = (P * H^{T})^{T} solved with L and L^{T}
+        for(unsigned int i(0); i < n; ++i){
+          value_t *x(&K[i * m * lanes]);
+          for(unsigned int r(0); r < m; ++r){
+            value_t *dst(&x[r * lanes]);
+            const value_t *src(&PHt[(i * m + r) * lanes]);
+            for(unsigned int k(0); k < lanes; ++k){dst[k] = src[k];}
+            for(unsigned int t(0); t < r; ++t){
+              const value_t *l(&S[(r * m + t) * lanes]), *y(&x[t * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){dst[k] -= l[k] * y[k];}
+            }
+            const value_t *d(&S[(r * m + r) * lanes]);
+            for(unsigned int k(0); k < lanes; ++k){dst[k] /= d[k];}
+          }
+          for(unsigned int r(m); r-- > 0; ){
+            value_t *dst(&x[r * lanes]);
+            for(unsigned int t(r + 1); t < m; ++t){
+              const value_t *l(&S[(t * m + r) * lanes]), *y(&x[t * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){dst[k] -= l[k] * y[k];}
+            }
+            const value_t *d(&S[(r * m + r) * lanes]);
+            for(unsigned int k(0); k < lanes; ++k){dst[k] /= d[k];}
+          }
+        }
+
+        // P - K * (P * H^{T})^{T}, upper triangle is mirrored
+        for(unsigned int i(0); i < n; ++i){
+          for(unsigned int j(i); j < n; ++j){
+            value_t sum[lanes];
+            for(unsigned int k(0); k < lanes; ++k){sum[k] = 0;}
+            for(unsigned int r(0); r < m; ++r){
+              const value_t *a(&K[(i * m + r) * lanes]), *c(&PHt[(j * m + r) * lanes]);
+              for(unsigned int k(0); k < lanes; ++k){sum[k] += a[k] * c[k];}
+            }
+            value_t *dst(&P[(i * n + j) * lanes]), *dst2(&P[(j * n + i) * lanes]);
+            for(unsigned int k(0); k < lanes; ++k){dst[k] = dst2[k] = dst[k] - sum[k];}
+          }
+        }
+      }
+    }
+
+    /**
+     * @return (bool) true when the i-th filter has the gain of correct() not picked up yet
+     */
+    bool has_gain(const unsigned int &i) const {return observations[i] > 0;}
+
+    /**
+     * Pick up the Kalman gain of the i-th filter obtained with correct()
+     */
+    Matrix<FloatT> gain(const unsigned int &i){
+      const unsigned int m(observations[i]);
+      Matrix<FloatT> res(n, m);
+      for(unsigned int j(0); j < n; ++j){
+        for(unsigned int r(0); r < m; ++r){res(j, r) = at(m_K, n * m_max, j * m_max + r, i);}
+      }
+      observations[i] = 0;
+      return res;
+    }
+};
+
+/**
+ * @brief Kalman filter whose covariance is processed by KalmanFilterBatch
+ *
+ * It works as KalmanFilter until attach() is called.
+ * After that, the time update is deferred until KalmanFilterBatch::predict(),
+ * and the measurement update returns the gain obtained with KalmanFilterBatch::correct()
+ * if exists, otherwise the update is performed only for this filter.
+ * A copy is always detached from the batch.
+ *
+ * @param FloatT precision
+ */
+template <class FloatT>
+class KalmanFilterBatched : public KalmanFilter<FloatT> {
+  public:
+    typedef KalmanFilter<FloatT> super_t;
+    typedef KalmanFilterBatch<FloatT> batch_t;
+    typedef typename super_t::sparsity_t sparsity_t;
+  protected:
+    batch_t *m_batch;
+    unsigned int m_index;
+
+    void download() const {
+      if(m_batch){const_cast<KalmanFilterBatched *>(this)->m_P = m_batch->getP(m_index);}
+    }
+
+  public:
+    KalmanFilterBatched(const Matrix<FloatT> &P, const Matrix<FloatT> &Q)
+        : super_t(P, Q), m_batch(NULL), m_index(0) {}
+
+    KalmanFilterBatched(const KalmanFilterBatched &orig, const bool &deepcopy = false)
+        : super_t(
+            deepcopy ? orig.getP().copy() : orig.getP(),
+            deepcopy ? orig.getQ().copy() : orig.getQ()),
+        m_batch(NULL), m_index(0) {}
+
+    ~KalmanFilterBatched(){}
+
+    /**
+     * Let the batch process this filter as its index-th filter
+     */
+    void attach(batch_t &batch, const unsigned int &index){
+      m_batch = &batch;
+      m_index = index;
+      m_batch->setP(m_index, super_t::m_P);
+      m_batch->setQ(m_index, super_t::m_Q);
+    }
+
+    void detach(){
+      download();
+      m_batch = NULL;
+    }
+
+    using super_t::predict;
+
+    void predict(const Matrix<FloatT> &Phi, const Matrix<FloatT> &Gamma){
+      if(!m_batch){super_t::predict(Phi, Gamma); return;}
+      m_batch->set_transition(m_index, Phi, Gamma);
+    }
+
+    void predict(
+        const Matrix<FloatT> &Phi, const Matrix<FloatT> &Gamma,
+        const sparsity_t &pattern){
+      if(!m_batch){super_t::predict(Phi, Gamma, pattern); return;}
+      m_batch->set_transition(m_index, Phi, Gamma);
+    }
+
+    /**
+     * Structured version of predict(A, B, delta),
+     * which skips the temporary matrices of KalmanFilter::predict(A, B, delta, pattern) when attached
+     */
+    void predict(
+        const Matrix<FloatT> &A, const Matrix<FloatT> &B, const FloatT &delta,
+        const sparsity_t &pattern){
+      if(!m_batch){super_t::predict(A, B, delta, pattern); return;}
+      m_batch->set_transition(m_index, A, B, delta);
+    }
+
+    void predict_with_noise(const Matrix<FloatT> &Phi, const Matrix<FloatT> &Q_d){
+      if(!m_batch){super_t::predict_with_noise(Phi, Q_d); return;}
+      m_batch->set_transition_with_noise(m_index, Phi, Q_d);
+    }
+
+    Matrix<FloatT> correct(const Matrix<FloatT> &H, const Matrix<FloatT> &R){
+      if(!m_batch){return super_t::correct(H, R);}
+      if(m_batch->has_gain(m_index)){return m_batch->gain(m_index);}
+      download();
+      Matrix<FloatT> K(super_t::correct(H, R));
+      m_batch->setP(m_index, super_t::m_P);
+      return K;
+    }
+
+    const Matrix<FloatT> &getP() const {
+      download();
+      return super_t::m_P;
+    }
+
+    void setP(const Matrix<FloatT> &P){
+      super_t::setP(P);
+      if(m_batch){m_batch->setP(m_index, P);}
+    }
+
+    void setQ(const Matrix<FloatT> &Q){
+      super_t::setQ(Q);
+      if(m_batch){m_batch->setQ(m_index, Q);}
+    }
+};
+
+#endif /* __KALMAN_BATCH_H__ */
@@ -35,6 +35,7 @@
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <string>
 
 #include <cstdio>
 #include <cstring>
@@ -192,6 +193,27 @@ struct GlobalOptions {
 #else
 #define COMPORT_PREFIX "/dev/tty"
 #endif
+
+  /**
+   * Check whether spec points to a serial port.
+   * For *NIX, a pseudo terminal such as /dev/pts/x, which is provided by log_replay,
+   * and a symbolic link to a serial port are also accepted.
+   */
+  static bool is_comport(const char *spec){
+    if(std::strstr(spec, COMPORT_PREFIX) == spec){return true;}
+#ifndef _WIN32
+    // COM_name[:baudrate] format is acceptable, thus :baudrate is removed before resolving
+    const char *baudrate_spec(std::strchr(spec, ':'));
+    std::string name(spec, baudrate_spec ? (baudrate_spec - spec) : std::strlen(spec));
+    if(char *path = realpath(name.c_str(), NULL)){
+      bool res((std::strstr(path, COMPORT_PREFIX) == path)
+          || (std::strstr(path, "/dev/pts/") == path));
+      std::free(path);
+      return res;
+    }
+#endif
+    return false;
+  }
   
   std::istream &spec2istream(
       const char *spec, 
@@ -204,7 +226,7 @@ struct GlobalOptions {
         setmode(fileno(stdin), O_BINARY);
 #endif
         return std::cin;
-      }else if(strstr(spec, COMPORT_PREFIX) == spec){
+      }else if(is_comport(spec)){
         std::cerr << spec << std::endl;
         // COM ports
         // COM_name[:baudrate] format is acceptable.
@@ -246,7 +268,7 @@ struct GlobalOptions {
         setmode(fileno(stdout), O_BINARY);
 #endif
         return std::cout;
-      }else if(std::strstr(spec, COMPORT_PREFIX) == spec){
+      }else if(is_comport(spec)){
         std::cerr << spec << std::endl;
         // COM|[g
         // COM_name[:baudrate] format is acceptable.
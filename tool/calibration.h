@@ -34,6 +34,7 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <cmath>
 
 template <class FloatT>
 struct StandardCalibration {
@@ -47,26 +48,26 @@ struct StandardCalibration {
     FloatT alignment[N][N];
     FloatT sigma[N];
     static void set(char *spec, FloatT target[N]){
-      for(int i(0); i < N; i++){
+      for(std::size_t i(0); i < N; i++){
         target[i] = std::strtod(spec, &spec);
       }
     }
     static void set(char *spec, FloatT target[N][N]){
-      for(int i(0); i < N; i++){
-        for(int j(0); j < N; j++){
+      for(std::size_t i(0); i < N; i++){
+        for(std::size_t j(0); j < N; j++){
           target[i][j] = std::strtod(spec, &spec);
         }
       }
     }
     static std::ostream &dump(std::ostream &out, const FloatT target[N]){
-      for(int i(0); i < N; i++){
+      for(std::size_t i(0); i < N; i++){
         out << " " << target[i];
       }
       return out;
     }
     static std::ostream &dump(std::ostream &out, const FloatT target[N][N]){
-      for(int i(0); i < N; i++){
-        for(int j(0); j < N; j++){
+      for(std::size_t i(0); i < N; i++){
+        for(std::size_t j(0); j < N; j++){
           out << " " << target[i][j];
         }
       }
@@ -112,7 +113,7 @@ if(value = get_value(line, TO_STRING(name))){ \
 
   template <std::size_t N>
   bool check_specs(const char *(&lines)[N], const char *(*get_value)(const char *, const char *)){
-    for(int i(0); i < N; ++i){
+    for(std::size_t i(0); i < N; ++i){
       if(!check_spec(lines[i], get_value)){return false;}
     }
     return true;
@@ -150,25 +151,77 @@ if(value = get_value(line, TO_STRING(name))){ \
 
     // Temperature compensation
     FloatT bias[N];
-    for(int i(0); i < N; i++){
+    for(std::size_t i(0); i < N; i++){
       bias[i] = info.bias_base[i] + (info.bias_tc[i] * bias_mod);
     }
 
     // Convert raw values to physical quantity by using scale factor
     FloatT tmp[N];
-    for(int i(0); i < N; i++){
+    for(std::size_t i(0); i < N; i++){
       tmp[i] = (((FloatT)raw[i] - bias[i]) / info.sf[i]);
     }
 
     // Misalignment compensation
-    for(int i(0); i < N; i++){
+    for(std::size_t i(0); i < N; i++){
       res[i] = 0;
-      for(int j(0); j < N; j++){
+      for(std::size_t j(0); j < N; j++){
         res[i] += info.alignment[i][j] * tmp[j];
       }
     }
   }
 
+  /**
+   * Inverse of calibrate(), i.e., convert physical quantity to raw values.
+   * The misalignment matrix is inverted by Gauss-Jordan elimination.
+   *
+   * @return (bool) false when the misalignment matrix is singular
+   */
+  template <class NumType, std::size_t N>
+  static bool decalibrate(
+      const FloatT (&values)[N],
+      const NumType &bias_mod,
+      const calibration_info_t<N> &info,
+      NumType res[]) {
+
+    // Misalignment compensation (inverse), solving alignment * tmp = values
+    FloatT a[N][N], tmp[N];
+    for(std::size_t i(0); i < N; i++){
+      for(std::size_t j(0); j < N; j++){
+        a[i][j] = info.alignment[i][j];
+      }
+      tmp[i] = values[i];
+    }
+    for(std::size_t k(0); k < N; k++){
+      std::size_t pivot(k);
+      for(std::size_t i(k + 1); i < N; i++){
+        if(std::abs(a[i][k]) > std::abs(a[pivot][k])){pivot = i;}
+      }
+      if(a[pivot][k] == 0){return false;}
+      if(pivot != k){
+        for(std::size_t j(0); j < N; j++){
+          FloatT swap(a[k][j]); a[k][j] = a[pivot][j]; a[pivot][j] = swap;
+        }
+        FloatT swap(tmp[k]); tmp[k] = tmp[pivot]; tmp[pivot] = swap;
+      }
+      for(std::size_t i(0); i < N; i++){
+        if(i == k){continue;}
+        FloatT coef(a[i][k] / a[k][k]);
+        for(std::size_t j(k); j < N; j++){
+          a[i][j] -= coef * a[k][j];
+        }
+        tmp[i] -= coef * tmp[k];
+      }
+    }
+
+    // Convert physical quantity to raw values by using scale factor and bias
+    for(std::size_t i(0); i < N; i++){
+      FloatT raw((tmp[i] / a[i][i]) * info.sf[i]
+          + info.bias_base[i] + (info.bias_tc[i] * bias_mod));
+      res[i] = (NumType)std::floor(raw + 0.5);
+    }
+    return true;
+  }
+
   StandardCalibration()
       : index_base(0), index_temp_ch(0), accel(pass_through), gyro(pass_through) {}
   ~StandardCalibration() {}
@@ -199,6 +252,26 @@ if(value = get_value(line, TO_STRING(name))){ \
     return res;
   }
 
+  /**
+   * Set raw values corresponding to acceleration in m/s^2,
+   * raw_data[index_temp_ch] must be prepared in advance.
+   */
+  bool accel2raw(const FloatT (&accel)[3], int *raw_data) const{
+    return decalibrate(
+        accel, raw_data[index_temp_ch],
+        this->accel, &raw_data[index_base]);
+  }
+
+  /**
+   * Set raw values corresponding to angular speed in rad/sec,
+   * raw_data[index_temp_ch] must be prepared in advance.
+   */
+  bool omega2raw(const FloatT (&omega)[3], int *raw_data) const{
+    return decalibrate(
+        omega, raw_data[index_temp_ch],
+        gyro, &raw_data[index_base + 3]);
+  }
+
   /**
    * Accelerometer output variance in [m/s^2]^2
    */
@@ -39,13 +39,16 @@
 #include <iomanip>
 #include <string>
 #include <exception>
+#include <vector>
 #include <cstring>
+#include <cstdlib>
 
 #define DEBUG 1
 
 #define IS_LITTLE_ENDIAN 1
 #include "SylphideProcessor.h"
 #include "SylphideStream.h"
+#include "util/ubx_scanner.h"
 
 typedef double float_sylph_t;
 
@@ -53,12 +56,49 @@ typedef double float_sylph_t;
 
 struct Options : public GlobalOptions<float_sylph_t> {
   typedef GlobalOptions<float_sylph_t> super_t;
+  bool fast_extraction; ///< True when UBX frames are extracted by bulk read without SylphideProcessor
+  std::vector<bool> packet_filter; ///< Output {class, id} table indexed by (class << 8 | id), empty for all
   bool log_is_ubx; ///< ubx2ubx邽߂̃tO
   
   Options()
-      : super_t(), log_is_ubx(false) {}
+      : super_t(), fast_extraction(false), packet_filter(), log_is_ubx(false) {}
   ~Options(){}
   
+  /**
+   * Check whether a UBX message is selected by --packet_filter
+   */
+  bool is_packet_selected(const unsigned char &klass, const unsigned char &id) const {
+    return packet_filter.empty() || packet_filter[((unsigned int)klass << 8) | id];
+  }
+  
+  /**
+   * Parse packet filter in format of class[:id][,class[:id]...],
+   * where class and id are numbers (0x prefix is allowed), and omitted id means all ids.
+   * 
+   * @return (bool) true when successfully parsed
+   */
+  bool set_packet_filter(const char *spec){
+    packet_filter.assign(0x10000, false);
+    while(true){
+      char *spec_end;
+      long klass(std::strtol(spec, &spec_end, 0));
+      if((spec_end == spec) || (klass < 0) || (klass > 0xFF)){return false;}
+      spec = spec_end;
+      long id_min(0), id_max(0xFF);
+      if(*spec == ':'){
+        id_min = id_max = std::strtol(++spec, &spec_end, 0);
+        if((spec_end == spec) || (id_min < 0) || (id_min > 0xFF)){return false;}
+        spec = spec_end;
+      }
+      for(long id(id_min); id <= id_max; ++id){
+        packet_filter[(klass << 8) | id] = true;
+      }
+      if(*spec == '\0'){break;}
+      if(*(spec++) != ','){return false;}
+    }
+    return true;
+  }
+  
   /**
    * R}hɗ^ꂽݒǂ݉
    * 
@@ -81,6 +121,19 @@ struct Options : public GlobalOptions<float_sylph_t> {
       std::cerr << "log_is_ubx" << ": " << (log_is_ubx ? "true" : "false") << std::endl;
       return true;
     }
+    if(value = get_value(spec, "fast_extraction")){
+      fast_extraction = is_true(value);
+      std::cerr << "fast_extraction" << ": " << (fast_extraction ? "true" : "false") << std::endl;
+      return true;
+    }
+    if(value = get_value(spec, "packet_filter", false)){
+      if(!set_packet_filter(value)){
+        std::cerr << "(error!) Invalid packet_filter: " << value << std::endl;
+        std::exit(-1);
+      }
+      std::cerr << "packet_filter" << ": " << value << std::endl;
+      return true;
+    }
 
     for(int i(0); 
         i < sizeof(available_keys) / sizeof(available_keys[0]);
@@ -107,6 +160,24 @@ int bad_packet(0);
 Options::gps_time_t gps_time_0x0106(0);
 bool read_continue(true);
 
+/**
+ * Update the current GPS time with the contents of UBX-NAV-SOL {class, id} = {0x01, 0x06}
+ * 
+ * @return (bool) false when the time reaches the end
+ */
+bool update_time_0x0106(
+    const float_sylph_t &itow, const int &week, const unsigned int &status_flags){
+  if(status_flags & G_Observer_t::solution_t::TOW_VALID){
+    gps_time_0x0106.sec = itow;
+  }
+  if(status_flags & G_Observer_t::solution_t::WN_VALID){
+    gps_time_0x0106.wn = week;
+  }else{
+    gps_time_0x0106.wn = Options::gps_time_t::WN_INVALID;
+  }
+  return options.is_time_before_end(gps_time_0x0106.sec, gps_time_0x0106.wn);
+}
+
 /**
  * Gy[W(u-bloxGPS)̏p֐
  * Gy[W̓evalidateŊmFAsƁB
@@ -129,33 +200,104 @@ void g_packet_handler(const G_Observer_t &observer){
   G_Observer_t::packet_type_t packet_type(observer.packet_type());
   if((packet_type.mclass == 0x01) && (packet_type.mid == 0x06)){
     G_Observer_t::solution_t solution(observer.fetch_solution());
-    if(solution.status_flags & G_Observer_t::solution_t::TOW_VALID){
-      gps_time_0x0106.sec = observer.fetch_ITOW();
-    }
-    if(solution.status_flags & G_Observer_t::solution_t::WN_VALID){
-      gps_time_0x0106.wn = solution.week;
-    }else{
-      gps_time_0x0106.wn = Options::gps_time_t::WN_INVALID;
-    }
-    if(!options.is_time_before_end(gps_time_0x0106.sec, gps_time_0x0106.wn)){
+    if(!update_time_0x0106(observer.fetch_ITOW(), solution.week, solution.status_flags)){
       read_continue = false;
       return;
     }
   }
 
   if(!options.is_time_after_start(gps_time_0x0106.sec, gps_time_0x0106.wn)){return;}
+  if(!options.is_packet_selected(packet_type.mclass, packet_type.mid)){return;}
   good_packet++;
-  for(int i = 0; i < observer.current_packet_size(); i++){
-    options.out() << observer[i];
-  }
+  char buf[OBSERVER_SIZE];
+  options.out().write(buf, observer.inspect(buf, observer.current_packet_size()));
 }
 
+/**
+ * Bulk UBX extractor, which is equivalent to the combination of
+ * stream_processor and g_packet_handler, but gathers the payloads of G pages
+ * read in large blocks into a contiguous buffer, scans UBX frames on it directly with UBX_Scanner,
+ * and writes the validated frames to the output in large blocks.
+ * Only UBX-NAV-SOL is decoded, and only for --start_gpst/--end_gpst.
+ */
+struct FastExtractor : public UBX_Scanner {
+  static const unsigned int read_size = SYLPHIDE_PAGE_SIZE * 0x800; // 64KB
+  static const unsigned int write_size = 0x10000;
+  std::vector<char> in_buf, out_buf;
+  unsigned int out_stored;
+  
+  FastExtractor()
+      : UBX_Scanner(read_size + OBSERVER_SIZE, OBSERVER_SIZE / 2),
+      in_buf(read_size), out_buf(write_size + OBSERVER_SIZE),
+      out_stored(0) {}
+  ~FastExtractor(){}
+  
+  void flush(){
+    if(out_stored == 0){return;}
+    options.out().write(&out_buf[0], out_stored);
+    out_stored = 0;
+  }
+  
+  /**
+   * Process a validated UBX frame
+   */
+  bool frame(const unsigned char *packet, const unsigned int &size){
+    if((packet[2] == 0x01) && (packet[3] == 0x06) && (size >= (6 + 12 + 2))){
+      if(!update_time_0x0106(
+          (float_sylph_t)1E-3 * le_u32(packet + 6),
+          (short)le_u16(packet + 6 + 8),
+          packet[6 + 11])){
+        read_continue = false;
+        return false;
+      }
+    }
+    if(!options.is_time_after_start(gps_time_0x0106.sec, gps_time_0x0106.wn)){return true;}
+    if(!options.is_packet_selected(packet[2], packet[3])){return true;}
+    good_packet++;
+    std::memcpy(&out_buf[out_stored], packet, size);
+    if((out_stored += size) >= write_size){flush();}
+    return true;
+  }
+  
+  void bad_frame(){
+    bad_packet++;
+  }
+  
+  void process(std::istream &in){
+    unsigned int in_stored(0);
+    while(read_continue && (!in.eof())){
+      in.read(&in_buf[in_stored], in_buf.size() - in_stored);
+      in_stored += in.gcount();
+      if(options.log_is_ubx){
+        append(&in_buf[0], in_stored);
+        in_stored = 0;
+        continue;
+      }
+      // gather the payloads of G pages, and leave an incomplete page for the next read
+      char *gathered(&in_buf[0]), *page(&in_buf[0]);
+      for(; in_stored >= SYLPHIDE_PAGE_SIZE; in_stored -= SYLPHIDE_PAGE_SIZE, page += SYLPHIDE_PAGE_SIZE){
+        if(*page != 'G'){continue;}
+        std::memmove(gathered, page + 1, SYLPHIDE_PAGE_SIZE - 1);
+        gathered += (SYLPHIDE_PAGE_SIZE - 1);
+      }
+      append(&in_buf[0], gathered - &in_buf[0]);
+      std::memmove(&in_buf[0], page, in_stored);
+    }
+    flush();
+  }
+};
+
 /**
  * t@C̃Xg[y[WPʂŐ؂o֐
  * 
  * @param in Xg[
  */
 void stream_processor(istream &in){
+  if(options.fast_extraction){
+    FastExtractor().process(in);
+    return;
+  }
+  
   char buffer[SYLPHIDE_PAGE_SIZE];
   char *buffer_head(buffer);
   int read_count_max(sizeof(buffer));
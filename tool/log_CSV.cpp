@@ -314,8 +314,7 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
 
         // NAV-TIMEGPS
         float_sylph_t itow(observer.fetch_ITOW());
-        char buf[4];
-        observer.inspect(buf, sizeof(buf), 6 + 8);
+        const char *buf(observer.message() + 6 + 8);
         if((unsigned char)buf[3] & 0x02){ // valid week number
           int wn(le_char2_2_num<unsigned short>(*buf));
 
@@ -370,6 +369,7 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
             packet_type(observer.packet_type());
         switch(packet_type.mclass){
           case 0x01: {
+            const char *msg(observer.message());
             switch(packet_type.mid){
               case 0x02:   // NAV-POSLLH
               case 0x14: { // NAV-HPPOSLLH
@@ -377,25 +377,25 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
                 super_t::G_Observer_t::position_t pos;
                 super_t::G_Observer_t::position_acc_t pos_acc;
                 if(packet_type.mid == 0x14){
-                  itow_ms = observer.fetch_ITOW_ms(4);
+                  itow_ms = super_t::G_Observer_t::decode_ITOW_ms(msg, 4);
                   if(itow_ms == itow_ms_0x0102){ // when 0x0102 comes earlier
                     change_0x0102 = false; // accept overwrite with 0x0114
                   }
-                  pos = observer.fetch_position_hp();
-                  pos_acc = observer.fetch_position_acc_hp();
+                  pos = super_t::G_Observer_t::decode_position_hp(msg);
+                  pos_acc = super_t::G_Observer_t::decode_position_acc_hp(msg);
                 }else{
-                  itow_ms = observer.fetch_ITOW_ms();
+                  itow_ms = super_t::G_Observer_t::decode_ITOW_ms(msg);
                   if(itow_ms == itow_ms_0x0102){ // when 0x0114 comes earlier
                     break; // skip 0x0102.
                   }
-                  pos = observer.fetch_position();
-                  pos_acc = observer.fetch_position_acc();
+                  pos = super_t::G_Observer_t::decode_position(msg);
+                  pos_acc = super_t::G_Observer_t::decode_position_acc(msg);
                 }
 
                 if(change_0x0102){ // previous position is not dumped
                   dump(itow_ms_0x0102);
                 }
-                itow_ms_0x0102 = observer.fetch_ITOW_ms();
+                itow_ms_0x0102 = super_t::G_Observer_t::decode_ITOW_ms(msg);
                 position = pos;
                 position_acc = pos_acc;
                 change_0x0102 = true;
@@ -408,9 +408,9 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
                 if(change_0x0112){ // previous velocity is not dumped
                   dump(itow_ms_0x0112);
                 }
-                itow_ms_0x0112 = observer.fetch_ITOW_ms();
-                velocity = observer.fetch_velocity();
-                velocity_acc = observer.fetch_velocity_acc();
+                itow_ms_0x0112 = super_t::G_Observer_t::decode_ITOW_ms(msg);
+                velocity = super_t::G_Observer_t::decode_velocity(msg);
+                velocity_acc = super_t::G_Observer_t::decode_velocity_acc(msg);
                 change_0x0112 = true;
                 if(itow_ms_0x0102 == itow_ms_0x0112){ // position and velocity are acquired
                   dump(itow_ms_0x0112);
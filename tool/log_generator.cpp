@@ -0,0 +1,798 @@
+/**
+ * @file Synthetic log generator for NinjaScan
+ *
+ */
+
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * === Quick guide ===
+ *
+ * This program generates a synthetic NinjaScan log, which consists of
+ * A (inertial), G (u-blox GPS) and M (magnetic) pages, along a simulated trajectory.
+ * Its outputs can be processed with log_CSV, log2ubx and INS_GPS as a real log,
+ * therefore, logs of arbitrary length and sampling rate are available
+ * to examine and to benchmark those decoders and filters reproducibly.
+ *
+ * Its usage is
+ *   log_generator [option(s)] --out=<log.dat>,
+ * where the output is the standard output when --out is omitted.
+ *
+ * The representative options are the followings;
+ *
+ *   --profile=<static|car|aircraft>
+ *      specifies trajectory. Both car and aircraft profiles stay stationary
+ *      during the first 10 seconds for initial alignment. Its default is car.
+ *   --duration=(length [sec])
+ *      specifies length of the log. Its default is 600.
+ *   --imu_rate=(rate [Hz]), --gps_rate=(rate [Hz]), --mag_rate=(rate [Hz])
+ *      specify output rate of A, G and M pages, respectively.
+ *      Zero disables the corresponding page. Their default values are 100, 5, and 10.
+ *   --gps_latency=(delay [sec])
+ *      specifies output delay of G pages from the measurement time. Its default is 0.
+ *   --init_position_deg=(latitude [deg]),(longitude [deg]),(altitude [m])
+ *   --init_yaw_deg=(heading [deg])
+ *      specify initial position and true heading.
+ *   --start_gpst=(GPS week):(GPS time in week [sec])
+ *      specifies the time of the beginning of the log.
+ *
+ *   --sigma_accel=(sigma [m/s^2]), --sigma_gyro=(sigma [rad/s]),
+ *   --sigma_mag=(sigma [nT])
+ *      specify white noise added to sensor outputs.
+ *   --gps_sigma_2d=(sigma [m]), --gps_sigma_v=(sigma [m]), --gps_sigma_vel=(sigma [m/s])
+ *      specify GPS noise, which are also reported as the estimated accuracy.
+ *   --noise=<on|off>
+ *      specifies whether the above noises are added or not.
+ *      Even if off, GPS estimated accuracy is reported. Its default is on.
+ *   --seed=(number)
+ *      specifies seed of the random number generator.
+ *
+ *   --calib_file=(file)
+ *      specifies IMU calibration file, which is used to convert physical quantities
+ *      to raw values in the inverse way. The default is the typical NinjaScan one.
+ *   --mag_sf=(scale factor [count/nT])
+ *      specifies scale factor of the magnetic sensor. Its default is 0.01.
+ *   --out_sylphide=<off|on>
+ *      specifies whether the output follows Sylphide protocol or not.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <deque>
+
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+
+#define IS_LITTLE_ENDIAN 1
+#include "SylphideStream.h"
+#include "SylphideProcessor.h"
+
+typedef double float_sylph_t;
+
+#include "param/vector3.h"
+#include "param/quaternion.h"
+
+template <>
+struct Vector3Data_TypeMapper<float_sylph_t> {
+  typedef Vector3Data_NoFlyWeight<float_sylph_t> res_t;
+};
+template <>
+struct QuaternionData_TypeMapper<float_sylph_t> {
+  typedef QuaternionData_NoFlyWeight<float_sylph_t> res_t;
+};
+
+#include "navigation/INS.h"
+#include "navigation/WGS84.h"
+#include "navigation/MagneticField.h"
+
+#include "analyze_common.h"
+#include "calibration.h"
+
+struct Options : public GlobalOptions<float_sylph_t> {
+  typedef GlobalOptions<float_sylph_t> super_t;
+
+  // Trajectory
+  enum profile_t {
+    PROFILE_STATIC,
+    PROFILE_CAR,
+    PROFILE_AIRCRAFT,
+  } profile;
+  float_sylph_t duration; ///< Length of the log [sec]
+  float_sylph_t init_latitude_deg, init_longitude_deg, init_altitude; ///< Initial position
+  float_sylph_t init_yaw_deg; ///< Initial true heading [deg]
+
+  // Sensors
+  float_sylph_t imu_rate, gps_rate, mag_rate; ///< Output rate [Hz]
+  float_sylph_t gps_latency; ///< Output delay of GPS receiver [sec]
+  struct sigma_t {
+    float_sylph_t accel; ///< [m/s^2]
+    float_sylph_t gyro; ///< [rad/s]
+    float_sylph_t mag; ///< [nT]
+    float_sylph_t gps_2d, gps_v; ///< [m]
+    float_sylph_t gps_vel; ///< [m/s]
+    sigma_t()
+        : accel(0.05), gyro(5e-3), mag(100),
+        gps_2d(2), gps_v(4), gps_vel(0.2) {}
+  } sigma;
+  bool noise; ///< True when noises are added
+  unsigned long seed;
+  StandardCalibration<float_sylph_t> calibration;
+  float_sylph_t mag_sf; ///< Scale factor of magnetic sensor [count/nT]
+
+  Options()
+      : super_t(),
+      profile(PROFILE_CAR), duration(600),
+      init_latitude_deg(35.7), init_longitude_deg(139.5), init_altitude(100),
+      init_yaw_deg(0),
+      imu_rate(100), gps_rate(5), mag_rate(10),
+      gps_latency(0),
+      sigma(), noise(true), seed(1),
+      calibration(), mag_sf(0.01) {
+    set_typical_calibration_specs(calibration);
+    start_gpstime.wn = 2000;
+  }
+  ~Options(){}
+
+  static const char *profile_name(const profile_t &profile){
+    switch(profile){
+      case PROFILE_STATIC: return "static";
+      case PROFILE_CAR: return "car";
+      case PROFILE_AIRCRAFT: return "aircraft";
+    }
+    return "unknown";
+  }
+
+  /**
+   * Check spec
+   *
+   * @param spec command
+   * @return (bool) true when consumed, otherwise false
+   */
+  bool check_spec(const char *spec){
+
+    const char *key;
+    const unsigned int key_length(get_key(spec, &key));
+    if(key_length == 0){return super_t::check_spec(spec);}
+
+    bool key_checked(false);
+
+#define CHECK_KEY(name) \
+  (key_checked \
+    || (key_checked = ((key_length == std::strlen(#name)) \
+        && (std::strncmp(key, #name, key_length) == 0))))
+#define CHECK_ALIAS(name) CHECK_KEY(name)
+#define CHECK_OPTION(name, accept_no_value, operation, disp) { \
+  while(CHECK_KEY(name)){ \
+    key_checked = false; \
+    const char *value(get_value(spec, key_length, accept_no_value)); \
+    if((!accept_no_value) && (!value)){return false;} \
+    {operation;} \
+    std::cerr << #name << ": " << disp << std::endl; \
+    return true; \
+  } \
+}
+#define CHECK_OPTION_BOOL(target) \
+CHECK_OPTION(target, true, target = is_true(value), (target ? "on" : "off"));
+#define CHECK_OPTION_FLOAT(name, target, unit) \
+CHECK_OPTION(name, false, target = std::atof(value), target << unit);
+
+    CHECK_OPTION(profile, false,
+        if(std::strcmp(value, "static") == 0){profile = PROFILE_STATIC;}
+        else if(std::strcmp(value, "car") == 0){profile = PROFILE_CAR;}
+        else if(std::strcmp(value, "aircraft") == 0){profile = PROFILE_AIRCRAFT;}
+        else{break;},
+        profile_name(profile));
+    CHECK_OPTION_FLOAT(duration, duration, " [s]");
+    CHECK_ALIAS(init-position-deg);
+    if(CHECK_KEY(init_position_deg)){
+      const char *value(get_value(spec, key_length, false));
+      if(!value){return false;}
+      if(std::sscanf(value, "%lf,%lf,%lf",
+          &init_latitude_deg, &init_longitude_deg, &init_altitude) < 2){
+        return false;
+      }
+      std::cerr.write(key, key_length) << ": "
+          << init_latitude_deg << ", " << init_longitude_deg << ", " << init_altitude << std::endl;
+      return true;
+    }
+    CHECK_ALIAS(init-yaw-deg);
+    CHECK_OPTION_FLOAT(init_yaw_deg, init_yaw_deg, " [deg]");
+
+    CHECK_OPTION_FLOAT(imu_rate, imu_rate, " [Hz]");
+    CHECK_OPTION_FLOAT(gps_rate, gps_rate, " [Hz]");
+    CHECK_OPTION_FLOAT(mag_rate, mag_rate, " [Hz]");
+    CHECK_OPTION_FLOAT(gps_latency, gps_latency, " [s]");
+
+    CHECK_OPTION_FLOAT(sigma_accel, sigma.accel, " [m/s^2]");
+    CHECK_OPTION_FLOAT(sigma_gyro, sigma.gyro, " [rad/s]");
+    CHECK_OPTION_FLOAT(sigma_mag, sigma.mag, " [nT]");
+    CHECK_OPTION_FLOAT(gps_sigma_2d, sigma.gps_2d, " [m]");
+    CHECK_OPTION_FLOAT(gps_sigma_v, sigma.gps_v, " [m]");
+    CHECK_OPTION_FLOAT(gps_sigma_vel, sigma.gps_vel, " [m/s]");
+    CHECK_OPTION_BOOL(noise);
+    CHECK_OPTION(seed, false, seed = std::strtoul(value, NULL, 0), seed);
+
+    CHECK_OPTION(calib_file, false,
+        {
+          if(!load_calibration_file(calibration, value)){
+            std::cerr << "(error!) Invalid calibration file: " << value << std::endl;
+            std::exit(-1);
+          }
+        },
+        value);
+    CHECK_OPTION_FLOAT(mag_sf, mag_sf, " [count/nT]");
+#undef CHECK_OPTION_FLOAT
+#undef CHECK_OPTION
+
+    return super_t::check_spec(spec);
+  }
+} options;
+
+using namespace std;
+
+/**
+ * Gaussian random number generator, which is independent of platforms
+ * in order to reproduce the same log with the same seed.
+ */
+class NormalRandom {
+  protected:
+    Uint32 x; ///< state of xorshift32
+    bool has_next;
+    float_sylph_t next;
+    float_sylph_t uniform(){ // (0, 1)
+      x ^= (x << 13);
+      x ^= (x >> 17);
+      x ^= (x << 5);
+      return ((float_sylph_t)x + 0.5) / 4294967296.0;
+    }
+  public:
+    NormalRandom(const unsigned long &seed = 1)
+        : x((Uint32)(seed ? seed : 1)), has_next(false), next(0) {}
+    float_sylph_t operator()(const float_sylph_t &sigma = 1){
+      if(has_next){
+        has_next = false;
+        return next * sigma;
+      }
+      float_sylph_t r(std::sqrt(-2 * std::log(uniform()))), theta(uniform() * M_PI * 2);
+      next = r * std::sin(theta);
+      has_next = true;
+      return r * std::cos(theta) * sigma;
+    }
+};
+
+/**
+ * Simulated trajectory
+ *
+ * Motion is given with speed, heading and flight path angle as functions of time,
+ * and position is integrated along them. Sideslip and angle of attack are ignored,
+ * i.e., the body X axis always points to the direction of motion.
+ */
+struct Trajectory {
+  typedef float_sylph_t float_t;
+  typedef Vector3<float_t> vec3_t;
+  typedef Quaternion<float_t> quat_t;
+  typedef WGS84Generic<float_t> Earth;
+
+  static const float_t stationary_sec;
+
+  Options::profile_t profile;
+  float_t yaw0;
+
+  struct motion_t {
+    float_t speed; ///< [m/s]
+    float_t heading, pitch, roll; ///< Euler angles [rad]
+  };
+
+  /**
+   * Motion at the specified time
+   *
+   * @param t elapsed time from the beginning [sec]
+   */
+  motion_t motion(const float_t &t) const {
+    motion_t res = {0, yaw0, 0, 0};
+    if((profile == Options::PROFILE_STATIC) || (t <= stationary_sec)){return res;}
+    float_t t_m(t - stationary_sec);
+    switch(profile){
+      case Options::PROFILE_CAR: {
+        // accelerate at 1 [m/s^2] to 15 [m/s], then weaving with a 60 seconds period
+        static const float_t accel(1), speed_max(15), turn_rate(0.1), period(60);
+        res.speed = (t_m < (speed_max / accel)) ? (accel * t_m) : speed_max;
+        float_t omega(M_PI * 2 / period);
+        res.heading += turn_rate / omega * (1. - std::cos(omega * t_m));
+        break;
+      }
+      case Options::PROFILE_AIRCRAFT: {
+        // accelerate at 3 [m/s^2] to 50 [m/s], then climbing and coordinated turns
+        static const float_t accel(3), speed_max(50), turn_rate(0.05), period_turn(90),
+            climb_max(0.1), period_climb(120);
+        res.speed = (t_m < (speed_max / accel)) ? (accel * t_m) : speed_max;
+        float_t omega_turn(M_PI * 2 / period_turn), omega_climb(M_PI * 2 / period_climb);
+        res.heading += turn_rate / omega_turn * (1. - std::cos(omega_turn * t_m));
+        res.pitch = climb_max * std::sin(omega_climb * t_m) * (res.speed / speed_max);
+        float_t heading_rate(turn_rate * std::sin(omega_turn * t_m));
+        res.roll = std::atan(res.speed * heading_rate / Earth::gravity(0));
+        break;
+      }
+      default:
+        break;
+    }
+    return res;
+  }
+
+  /**
+   * Velocity in NED frame
+   */
+  static vec3_t velocity(const motion_t &m){
+    float_t v_h(m.speed * std::cos(m.pitch));
+    return vec3_t(
+        v_h * std::cos(m.heading), v_h * std::sin(m.heading),
+        -m.speed * std::sin(m.pitch));
+  }
+
+  // current state
+  float_t t; ///< elapsed time [sec]
+  float_t latitude, longitude, height; ///< [rad, rad, m]
+  vec3_t v_ned; ///< [m/s]
+
+  Trajectory(const Options &opt)
+      : profile(opt.profile), yaw0(deg2rad(opt.init_yaw_deg)),
+      t(0),
+      latitude(deg2rad(opt.init_latitude_deg)), longitude(deg2rad(opt.init_longitude_deg)),
+      height(opt.init_altitude),
+      v_ned(velocity(motion(0))) {}
+
+  /**
+   * Advance the position to the specified time by trapezoidal integration
+   *
+   * @param t_next time to which the state is advanced [sec]
+   */
+  void advance(const float_t &t_next){
+    static const float_t dt_max(0.01);
+    while(t < t_next){
+      float_t dt(t_next - t);
+      if(dt > dt_max){dt = dt_max;}
+      vec3_t v_next(velocity(motion(t + dt)));
+      vec3_t v_mean((v_ned + v_next) / 2);
+      latitude += v_mean[0] / (Earth::R_meridian(latitude) + height) * dt;
+      longitude += v_mean[1] / ((Earth::R_normal(latitude) + height) * std::cos(latitude)) * dt;
+      height -= v_mean[2] * dt;
+      v_ned = v_next;
+      t += dt;
+    }
+  }
+
+  quat_t attitude() const {
+    motion_t m(motion(t));
+    return INS<float_t>::euler2q(m.heading, m.pitch, m.roll);
+  }
+
+  struct inertial_t {
+    float_t accel[3]; ///< specific force in the body frame [m/s^2]
+    float_t omega[3]; ///< angular speed in the body frame [rad/s]
+  };
+
+  /**
+   * Ideal outputs of inertial sensors at the current time,
+   * which are consistent to the kinematic equations used in INS.
+   */
+  inertial_t inertial() const {
+    static const float_t h(1E-3); // for numerical differentiation
+
+    motion_t m(motion(t)), m_p(motion(t + h)), m_n(motion(t >= h ? t - h : t));
+    float_t h_total(t >= h ? (h * 2) : h);
+
+    // Earth rate and transport rate in the NED frame
+    float_t Rm(Earth::R_meridian(latitude) + height), Rn(Earth::R_normal(latitude) + height);
+    float_t clat(std::cos(latitude)), slat(std::sin(latitude));
+    vec3_t omega_ie(Earth::Omega_Earth * clat, 0, -Earth::Omega_Earth * slat);
+    vec3_t omega_en(v_ned[1] / Rn, -v_ned[0] / Rm, -v_ned[1] * slat / clat / Rn);
+
+    // specific force; f = dv/dt - g + (2 * omega_ie + omega_en) x v
+    vec3_t accel_n((velocity(m_p) - velocity(m_n)) / h_total);
+    accel_n[2] -= Earth::gravity(latitude, height);
+    accel_n += (omega_ie * 2 + omega_en) * v_ned;
+
+    // angular speed; omega_ib = omega_in + omega_nb
+    float_t d_heading((m_p.heading - m_n.heading) / h_total),
+        d_pitch((m_p.pitch - m_n.pitch) / h_total),
+        d_roll((m_p.roll - m_n.roll) / h_total);
+    float_t sr(std::sin(m.roll)), cr(std::cos(m.roll)),
+        sp(std::sin(m.pitch)), cp(std::cos(m.pitch));
+    vec3_t omega_nb(
+        d_roll - d_heading * sp,
+        d_pitch * cr + d_heading * sr * cp,
+        -d_pitch * sr + d_heading * cr * cp);
+
+    quat_t q_n2b(INS<float_t>::euler2q(m.heading, m.pitch, m.roll));
+    vec3_t accel_b((q_n2b.conj() * accel_n * q_n2b).vector());
+    vec3_t omega_b((q_n2b.conj() * (omega_ie + omega_en) * q_n2b).vector() + omega_nb);
+
+    inertial_t res;
+    for(int i(0); i < 3; ++i){
+      res.accel[i] = accel_b[i];
+      res.omega[i] = omega_b[i];
+    }
+    return res;
+  }
+
+  /**
+   * Magnetic field in the body frame [nT]
+   */
+  vec3_t magnetic_field() const {
+    MagneticField::field_components_res_t field(
+        MagneticField::field_components(IGRF12::IGRF2015,
+            latitude, longitude, height));
+    vec3_t field_n(field.north, field.east, field.down);
+    quat_t q_n2b(attitude());
+    return (q_n2b.conj() * field_n * q_n2b).vector();
+  }
+};
+
+const Trajectory::float_t Trajectory::stationary_sec = 10;
+
+/**
+ * Writer of Sylphide pages
+ */
+class PageWriter {
+  public:
+    typedef unsigned char u8_t;
+  protected:
+    ostream &out;
+    u8_t tick;
+    std::string g_stream; ///< UBX byte stream not yet written to G pages
+
+    template <class T>
+    static void set_le(u8_t *buf, const T &v, const int &bytes){
+      for(int i(0); i < bytes; ++i){buf[i] = (u8_t)(((Uint32)v >> (i * 8)) & 0xFF);}
+    }
+    template <class T>
+    static void set_be(u8_t *buf, const T &v, const int &bytes){
+      for(int i(0); i < bytes; ++i){buf[bytes - i - 1] = (u8_t)(((Uint32)v >> (i * 8)) & 0xFF);}
+    }
+    void write(const u8_t (&page)[SYLPHIDE_PAGE_SIZE]){
+      out.write((const char *)page, sizeof(page));
+      pages_total++;
+    }
+  public:
+    int pages_total, pages_a, pages_g, pages_m;
+
+    PageWriter(ostream &_out)
+        : out(_out), tick(0), g_stream(),
+        pages_total(0), pages_a(0), pages_g(0), pages_m(0) {}
+
+    /**
+     * Write A page
+     *
+     * @param itow_ms time stamp
+     * @param ch raw values, whose ch[0-7] are stored with 24 bits, and ch[8] is temperature.
+     */
+    void write_A(const Uint32 &itow_ms, const int (&ch)[9]){
+      u8_t page[SYLPHIDE_PAGE_SIZE] = {'A', tick++};
+      set_le(&page[2], itow_ms, 4);
+      for(int i(0); i < 8; ++i){
+        int v(ch[i]);
+        if(v < 0){v = 0;}else if(v > 0xFFFFFF){v = 0xFFFFFF;}
+        set_be(&page[6 + (3 * i)], v, 3);
+      }
+      set_le(&page[30], ch[8], 2);
+      write(page);
+      pages_a++;
+    }
+
+    /**
+     * Write M page in big endian mode
+     *
+     * @param itow_ms time stamp
+     * @param values magnetic sensor outputs, 4 samples of X, Y and Z.
+     */
+    void write_M(const Uint32 &itow_ms, const short (&values)[4][3]){
+      u8_t page[SYLPHIDE_PAGE_SIZE] = {'M', 0x80, 0, tick++};
+      set_le(&page[4], itow_ms, 4);
+      for(int i(0); i < 4; ++i){
+        for(int j(0); j < 3; ++j){
+          set_be(&page[8 + (6 * i) + (2 * j)], (Uint16)values[i][j], 2);
+        }
+      }
+      write(page);
+      pages_m++;
+    }
+
+    /**
+     * Append a UBX packet to the stream transferred by G pages
+     */
+    void append_ubx(const u8_t &klass, const u8_t &id, const u8_t *payload, const unsigned &size){
+      u8_t header[6] = {0xB5, 0x62, klass, id};
+      set_le(&header[4], size, 2);
+      u8_t ck_a(0), ck_b(0);
+      for(int i(2); i < 6; ++i){
+        ck_a += header[i];
+        ck_b += ck_a;
+      }
+      for(unsigned i(0); i < size; ++i){
+        ck_a += payload[i];
+        ck_b += ck_a;
+      }
+      g_stream.append((const char *)header, sizeof(header));
+      g_stream.append((const char *)payload, size);
+      g_stream += (char)ck_a;
+      g_stream += (char)ck_b;
+    }
+
+    /**
+     * Move the UBX stream appended so far, which will be written as G pages
+     */
+    void take_ubx(std::string &stream){
+      stream.swap(g_stream);
+      g_stream.clear();
+    }
+
+    /**
+     * Write G pages, whose last one is padded with zeros
+     */
+    void write_G(const std::string &stream){
+      static const std::string::size_type payload_size(SYLPHIDE_PAGE_SIZE - 1);
+      for(std::string::size_type i(0); i < stream.size(); i += payload_size){
+        u8_t page[SYLPHIDE_PAGE_SIZE] = {'G'};
+        std::string::size_type size(stream.size() - i);
+        if(size > payload_size){size = payload_size;}
+        std::memcpy(&page[1], stream.data() + i, size);
+        write(page);
+        pages_g++;
+      }
+    }
+
+    /**
+     * Append UBX NAV-SOL, NAV-STATUS, NAV-POSLLH, and NAV-VELNED
+     */
+    void append_nav(
+        const Options::gps_time_t &time,
+        const float_sylph_t &latitude, const float_sylph_t &longitude, const float_sylph_t &height,
+        const float_sylph_t (&v_ned)[3],
+        const Options::sigma_t &sigma,
+        const Uint32 &msss){
+
+      typedef WGS84Generic<float_sylph_t> Earth;
+      Uint32 itow_ms((Uint32)std::floor(time.sec * 1E3 + 0.5));
+
+      float_sylph_t clat(std::cos(latitude)), slat(std::sin(latitude));
+      float_sylph_t clng(std::cos(longitude)), slng(std::sin(longitude));
+      float_sylph_t acc_3d(std::sqrt(std::pow(sigma.gps_2d, 2) + std::pow(sigma.gps_v, 2)));
+      float_sylph_t speed_2d(std::sqrt(std::pow(v_ned[0], 2) + std::pow(v_ned[1], 2)));
+      float_sylph_t speed(std::sqrt(std::pow(speed_2d, 2) + std::pow(v_ned[2], 2)));
+
+      { // NAV-SOL
+        u8_t payload[52] = {0};
+        set_le(&payload[0], itow_ms, 4);
+        set_le(&payload[8], time.wn, 2);
+        payload[10] = 0x03; // 3D fix
+        payload[11] = 0x0D; // fix OK, WN valid, TOW valid
+        Earth::xz_t xz(Earth::xz(latitude, height));
+        float_sylph_t pos_ecef[3] = {xz.x * clng, xz.x * slng, xz.z};
+        float_sylph_t vel_ecef[3] = {
+          -slat * clng * v_ned[0] - slng * v_ned[1] - clat * clng * v_ned[2],
+          -slat * slng * v_ned[0] + clng * v_ned[1] - clat * slng * v_ned[2],
+          clat * v_ned[0] - slat * v_ned[2]};
+        for(int i(0); i < 3; ++i){
+          set_le(&payload[12 + (4 * i)], (Int32)std::floor(pos_ecef[i] * 1E2 + 0.5), 4);
+          set_le(&payload[28 + (4 * i)], (Int32)std::floor(vel_ecef[i] * 1E2 + 0.5), 4);
+        }
+        set_le(&payload[24], (Uint32)(acc_3d * 1E2), 4);
+        set_le(&payload[40], (Uint32)(sigma.gps_vel * 1E2), 4);
+        set_le(&payload[44], 150, 2); // PDOP 1.5
+        payload[47] = 8; // number of satellites
+        append_ubx(0x01, 0x06, payload, sizeof(payload));
+      }
+      { // NAV-STATUS
+        u8_t payload[16] = {0};
+        set_le(&payload[0], itow_ms, 4);
+        payload[4] = 0x03; // 3D fix
+        payload[5] = 0x0D;
+        set_le(&payload[12], msss, 4);
+        append_ubx(0x01, 0x03, payload, sizeof(payload));
+      }
+      { // NAV-POSLLH
+        u8_t payload[28] = {0};
+        set_le(&payload[0], itow_ms, 4);
+        set_le(&payload[4], (Int32)std::floor(rad2deg(longitude) * 1E7 + 0.5), 4);
+        set_le(&payload[8], (Int32)std::floor(rad2deg(latitude) * 1E7 + 0.5), 4);
+        set_le(&payload[12], (Int32)std::floor(height * 1E3 + 0.5), 4);
+        set_le(&payload[16], (Int32)std::floor(height * 1E3 + 0.5), 4); // geoid is ignored
+        set_le(&payload[20], (Uint32)(sigma.gps_2d * 1E3), 4);
+        set_le(&payload[24], (Uint32)(sigma.gps_v * 1E3), 4);
+        append_ubx(0x01, 0x02, payload, sizeof(payload));
+      }
+      { // NAV-VELNED
+        u8_t payload[36] = {0};
+        set_le(&payload[0], itow_ms, 4);
+        for(int i(0); i < 3; ++i){
+          set_le(&payload[4 + (4 * i)], (Int32)std::floor(v_ned[i] * 1E2 + 0.5), 4);
+        }
+        set_le(&payload[16], (Uint32)(speed * 1E2), 4);
+        set_le(&payload[20], (Uint32)(speed_2d * 1E2), 4);
+        float_sylph_t heading_deg(rad2deg(std::atan2(v_ned[1], v_ned[0])));
+        if(heading_deg < 0){heading_deg += 360;}
+        set_le(&payload[24], (Int32)(heading_deg * 1E5), 4);
+        set_le(&payload[28], (Uint32)(sigma.gps_vel * 1E2), 4);
+        float_sylph_t heading_acc_deg((speed_2d > sigma.gps_vel)
+            ? rad2deg(std::atan2(sigma.gps_vel, speed_2d)) : 180);
+        set_le(&payload[32], (Uint32)(heading_acc_deg * 1E5), 4);
+        append_ubx(0x01, 0x12, payload, sizeof(payload));
+      }
+    }
+};
+
+void generate(ostream &out){
+  typedef Trajectory::vec3_t vec3_t;
+  static const Uint32 week_ms(60U * 60 * 24 * 7 * 1000);
+
+  Trajectory trajectory(options);
+  PageWriter writer(out);
+  NormalRandom rand(options.seed);
+  float_sylph_t noise_scale(options.noise ? 1 : 0);
+
+  // GPS time at the beginning
+  Options::gps_time_t t0(options.start_gpstime);
+  if(t0.wn < 0){t0.wn = 0;}
+  Uint32 t0_ms((Uint32)std::floor(t0.sec * 1E3 + 0.5) % week_ms);
+  t0.wn += (int)std::floor(t0.sec / (60. * 60 * 24 * 7));
+
+  /*
+   * The time of each event is computed from the number of the preceding events,
+   * not accumulated, in order to avoid drift. Events at the same millisecond are
+   * issued in order of priority; an A page always precedes a G page having the same time stamp,
+   * because INS_GPS assumes that a GPS solution is received after the IMU data at its time.
+   */
+  struct schedule_t {
+    float_sylph_t rate;
+    int priority; ///< smaller is earlier for the same millisecond
+    unsigned long count;
+    float_sylph_t next;
+    Uint32 next_ms;
+    schedule_t(const float_sylph_t &_rate, const int &_priority)
+        : rate(_rate), priority(_priority), count(0), next(rate > 0 ? 0 : -1), next_ms(0) {}
+    bool active() const {return next >= 0;}
+    bool precedes(const schedule_t &another) const {
+      return (next_ms < another.next_ms)
+          || ((next_ms == another.next_ms) && (priority < another.priority));
+    }
+    void advance(const float_sylph_t &t_end){
+      next = (float_sylph_t)(++count) / rate;
+      next_ms = (Uint32)std::floor(next * 1E3 + 0.5);
+      if(next > t_end){next = -1;}
+    }
+  } imu(options.imu_rate, 0), mag(options.mag_rate, 1), gps(options.gps_rate, 2);
+  Uint32 gps_latency_ms((options.gps_latency > 0)
+      ? (Uint32)std::floor(options.gps_latency * 1E3 + 0.5) : 0);
+
+  // UBX streams waiting for their output time [ms], i.e., measurement time + latency
+  std::deque<std::pair<Uint32, std::string> > gps_pending;
+
+  while(true){
+    // Select the earliest event
+    schedule_t *target(NULL);
+    schedule_t *schedules[] = {&imu, &mag, &gps};
+    for(int i(0); i < (int)(sizeof(schedules) / sizeof(schedules[0])); ++i){
+      if(!schedules[i]->active()){continue;}
+      if((!target) || schedules[i]->precedes(*target)){target = schedules[i];}
+    }
+
+    // Write delayed G pages
+    while(!gps_pending.empty()){
+      if(target && (gps_pending.front().first > target->next_ms)){break;}
+      writer.write_G(gps_pending.front().second);
+      gps_pending.pop_front();
+    }
+
+    if(!target){break;}
+
+    float_sylph_t t_next(target->next);
+    trajectory.advance(t_next);
+    Uint32 t_ms(target->next_ms);
+    Uint32 itow_ms((t0_ms + t_ms) % week_ms);
+
+    if(target == &imu){
+      Trajectory::inertial_t inertial(trajectory.inertial());
+      for(int i(0); i < 3; ++i){
+        inertial.accel[i] += rand(options.sigma.accel * noise_scale);
+        inertial.omega[i] += rand(options.sigma.gyro * noise_scale);
+      }
+      int ch[9] = {0};
+      if(!options.calibration.accel2raw(inertial.accel, ch)
+          || !options.calibration.omega2raw(inertial.omega, ch)){
+        cerr << "(error!) Singular misalignment matrix in calibration." << endl;
+        exit(-1);
+      }
+      writer.write_A(itow_ms, ch);
+    }else if(target == &mag){
+      vec3_t field(trajectory.magnetic_field());
+      short values[4][3];
+      for(int i(0); i < 4; ++i){
+        for(int j(0); j < 3; ++j){
+          values[i][j] = (short)std::floor(
+              (field[j] + rand(options.sigma.mag * noise_scale)) * options.mag_sf + 0.5);
+        }
+      }
+      writer.write_M(itow_ms, values);
+    }else{ // GPS
+      typedef WGS84Generic<float_sylph_t> Earth;
+      float_sylph_t lat(trajectory.latitude), lng(trajectory.longitude), h(trajectory.height);
+      lat += rand(options.sigma.gps_2d * noise_scale) / (Earth::R_meridian(lat) + h);
+      lng += rand(options.sigma.gps_2d * noise_scale) / ((Earth::R_normal(lat) + h) * std::cos(lat));
+      h += rand(options.sigma.gps_v * noise_scale);
+      float_sylph_t v_ned[3];
+      for(int i(0); i < 3; ++i){
+        v_ned[i] = trajectory.v_ned[i] + rand(options.sigma.gps_vel * noise_scale);
+      }
+      Options::gps_time_t time(1E-3 * itow_ms, t0.wn + (int)((t0_ms + t_ms) / week_ms));
+      writer.append_nav(time, lat, lng, h, v_ned, options.sigma, t_ms);
+      gps_pending.push_back(std::make_pair(t_ms + gps_latency_ms, std::string()));
+      writer.take_ubx(gps_pending.back().second);
+    }
+
+    target->advance(options.duration);
+  }
+
+  cerr << "Pages (A, G, M) = ("
+      << writer.pages_a << ", " << writer.pages_g << ", " << writer.pages_m << ")" << endl;
+}
+
+int main(int argc, char *argv[]){
+
+  cerr << "NinjaScan synthetic log generator" << endl;
+  cerr << "Usage: (exe) [options] --out=log.dat" << endl;
+
+  for(int i(1); i < argc; i++){
+    if(options.check_spec(argv[i])){continue;}
+    cerr << "(error!) Unknown option!! : " << argv[i] << endl;
+    return -1;
+  }
+
+  if(options.duration <= 0){
+    cerr << "(error!) Invalid duration: " << options.duration << endl;
+    return -1;
+  }
+
+  cerr << options.calibration << endl;
+
+  if(options.out_sylphide){
+    SylphideOStream out(options.out(), SYLPHIDE_PAGE_SIZE);
+    generate(out);
+  }else{
+    generate(options.out());
+  }
+  options.out().flush();
+
+  return 0;
+}
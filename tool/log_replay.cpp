@@ -0,0 +1,437 @@
+/**
+ * @file Rate-accurate log replay for NinjaScan
+ *
+ */
+
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * === Quick guide ===
+ *
+ * This program replays an existing NinjaScan log at the original timing of its pages,
+ * or at a chosen speed, in order to test and benchmark --realtime mode of INS_GPS
+ * reproducibly without a logger. The timing is given by the time stamps of A pages,
+ * and the other pages follow the preceding A page immediately.
+ *
+ * Its usage is
+ *   log_replay [option(s)] <log.dat>,
+ * where the pages are written to the standard output by default, for example,
+ *   log_replay log.dat | INS_GPS --realtime -
+ * or to a pseudo terminal, which INS_GPS can open as a serial port,
+ *   log_replay --pty=/tmp/replay --wait=1 log.dat & INS_GPS --realtime --benchmark=- /tmp/replay
+ *
+ * The representative options are the followings;
+ *
+ *   --speed=(factor)
+ *      specifies speed-up factor. 1 (default) is the original rate,
+ *      and zero or negative means no wait.
+ *   --jitter=(max delay [sec])
+ *      adds a uniformly distributed random delay to each page.
+ *   --burst=(period [sec]),(length [sec])
+ *      holds output for the length in every period, and then writes the held pages at once,
+ *      which emulates a stalled USB serial converter or a busy logger.
+ *   --seed=(number)
+ *      specifies seed of the random number generator for --jitter.
+ *   --wait=(delay [sec])
+ *      specifies delay before the first page, for example, to wait for a consumer to open the pty.
+ *   --pty[=(link)]
+ *      writes to a newly created pseudo terminal instead of the standard output.
+ *      Its name is reported to the standard error, and a symbolic link is made when specified.
+ *      At the end, the program waits for the consumer to read the remaining data before closing it.
+ *   --overrun=<block|drop>
+ *      specifies the action when the consumer does not read the pty fast enough.
+ *      block (default) waits, which delays the following pages, and drop discards the data
+ *      like an overrun serial port, and counts it.
+ *   --in_sylphide=<off|on>
+ *      specifies whether the input follows Sylphide protocol or not. The output is always raw pages.
+ *
+ * At the end, the numbers of pages and bytes, the lateness of writes from the schedule,
+ * and the number of dropped bytes are reported to the standard error.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#define LOG_REPLAY_USE_PTY 1
+#endif
+
+#define IS_LITTLE_ENDIAN 1
+#include "SylphideStream.h"
+#include "SylphideProcessor.h"
+
+typedef double float_sylph_t;
+
+#include "analyze_common.h"
+#include "util/thread.h"
+
+struct Options : public GlobalOptions<float_sylph_t> {
+  typedef GlobalOptions<float_sylph_t> super_t;
+
+  float_sylph_t speed; ///< Speed-up factor, non-positive for no wait
+  float_sylph_t jitter; ///< Maximum random delay of each page [sec]
+  float_sylph_t burst_period, burst_length; ///< Output is held for burst_length in every burst_period [sec]
+  unsigned long seed;
+  float_sylph_t wait; ///< Delay before the first page [sec]
+  const char *pty; ///< Symbolic link to pseudo terminal, "" for no link, NULL when inactive
+  bool overrun_drop; ///< True when data is discarded if the consumer is slow
+
+  Options()
+      : super_t(),
+      speed(1), jitter(0), burst_period(0), burst_length(0), seed(1), wait(0),
+      pty(NULL), overrun_drop(false) {}
+  ~Options(){}
+
+  /**
+   * Check spec
+   *
+   * @param spec command
+   * @return (bool) true when consumed, otherwise false
+   */
+  bool check_spec(const char *spec){
+
+    const char *key;
+    const unsigned int key_length(get_key(spec, &key));
+    if(key_length == 0){return super_t::check_spec(spec);}
+
+    bool key_checked(false);
+
+#define CHECK_KEY(name) \
+  (key_checked \
+    || (key_checked = ((key_length == std::strlen(#name)) \
+        && (std::strncmp(key, #name, key_length) == 0))))
+#define CHECK_OPTION(name, accept_no_value, operation, disp) { \
+  while(CHECK_KEY(name)){ \
+    key_checked = false; \
+    const char *value(get_value(spec, key_length, accept_no_value)); \
+    if((!accept_no_value) && (!value)){return false;} \
+    {operation;} \
+    std::cerr << #name << ": " << disp << std::endl; \
+    return true; \
+  } \
+}
+#define CHECK_OPTION_FLOAT(name, target, unit) \
+CHECK_OPTION(name, false, target = std::atof(value), target << unit);
+
+    CHECK_OPTION_FLOAT(speed, speed, "");
+    CHECK_OPTION_FLOAT(jitter, jitter, " [s]");
+    CHECK_OPTION(burst, false,
+        if(std::sscanf(value, "%lf,%lf", &burst_period, &burst_length) != 2){return false;},
+        burst_period << " [s], " << burst_length << " [s]");
+    CHECK_OPTION(seed, false, seed = std::strtoul(value, NULL, 0), seed);
+    CHECK_OPTION_FLOAT(wait, wait, " [s]");
+    CHECK_OPTION(pty, true,
+        pty = ((std::strcmp(value, "on") == 0) || (std::strcmp(value, "true") == 0)) ? "" : value,
+        (*pty ? pty : "on"));
+    CHECK_OPTION(overrun, false,
+        if(std::strcmp(value, "drop") == 0){overrun_drop = true;}
+        else if(std::strcmp(value, "block") == 0){overrun_drop = false;}
+        else{break;},
+        (overrun_drop ? "drop" : "block"));
+#undef CHECK_OPTION_FLOAT
+#undef CHECK_OPTION
+
+    return super_t::check_spec(spec);
+  }
+} options;
+
+using namespace std;
+
+typedef ComportStream::buf_t::time_ns_t time_ns_t;
+
+/**
+ * Destination of pages
+ */
+struct Sink {
+  unsigned long long dropped; ///< in bytes
+  Sink() : dropped(0) {}
+  virtual ~Sink(){}
+  /**
+   * @return (bool) false when the destination is closed
+   */
+  virtual bool write(const char *buf, std::size_t size) = 0;
+  virtual void finish(){}
+};
+
+struct StreamSink : public Sink {
+  std::ostream &out;
+  StreamSink(std::ostream &_out) : Sink(), out(_out) {}
+  bool write(const char *buf, std::size_t size){
+    out.write(buf, size);
+    out.flush();
+    return out.good();
+  }
+};
+
+#if defined(LOG_REPLAY_USE_PTY)
+struct PTY_Sink : public Sink {
+  int master, slave;
+  std::string link;
+  PTY_Sink(const char *_link) : Sink(), master(-1), slave(-1), link(_link) {
+    if(((master = posix_openpt(O_RDWR | O_NOCTTY)) < 0)
+        || (grantpt(master) != 0) || (unlockpt(master) != 0)){
+      cerr << "(error!) Failed to open pseudo terminal." << endl;
+      exit(-1);
+    }
+    const char *name(ptsname(master));
+    // The slave is kept open so that the buffered data is not lost before a consumer opens it.
+    if((slave = open(name, O_RDWR | O_NOCTTY)) < 0){
+      cerr << "(error!) Failed to open " << name << endl;
+      exit(-1);
+    }
+    struct termios config;
+    tcgetattr(slave, &config);
+    cfmakeraw(&config);
+    tcsetattr(slave, TCSANOW, &config);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    cerr << "pty: " << name;
+    if(!link.empty()){
+      std::remove(link.c_str());
+      if(symlink(name, link.c_str()) != 0){
+        cerr << endl << "(error!) Failed to make a link: " << link << endl;
+        exit(-1);
+      }
+      cerr << " => " << link;
+    }
+    cerr << endl;
+  }
+  ~PTY_Sink(){
+    if(!link.empty()){std::remove(link.c_str());}
+    if(slave >= 0){close(slave);}
+    if(master >= 0){close(master);}
+  }
+  bool write(const char *buf, std::size_t size){
+    while(size > 0){
+      ssize_t written(::write(master, buf, size));
+      if(written > 0){
+        buf += written;
+        size -= written;
+        continue;
+      }
+      if((written < 0) && (errno != EAGAIN) && (errno != EINTR)){return false;}
+      if(options.overrun_drop){
+        dropped += size;
+        return true;
+      }
+      struct pollfd fds = {master, POLLOUT, 0};
+      poll(&fds, 1, 100);
+    }
+    return true;
+  }
+  /**
+   * Wait for the consumer to read the remaining data, and then hang up
+   */
+  void finish(){
+    for(int i(0); i < 1000; ++i){ // at most 10 seconds
+      int remaining(0);
+      if((ioctl(slave, FIONREAD, &remaining) != 0) || (remaining <= 0)){break;}
+      Thread::sleep_us(10000);
+    }
+    close(slave);
+    close(master);
+    slave = master = -1;
+  }
+};
+#endif
+
+/**
+ * Uniform random number generator (xorshift32), which is independent of platforms
+ */
+class UniformRandom {
+  protected:
+    Uint32 x;
+  public:
+    UniformRandom(const unsigned long &seed = 1) : x((Uint32)(seed ? seed : 1)) {}
+    float_sylph_t operator()(){ // [0, 1)
+      x ^= (x << 13);
+      x ^= (x >> 17);
+      x ^= (x << 5);
+      return (float_sylph_t)x / 4294967296.0;
+    }
+};
+
+/**
+ * Schedule of pages, which converts time stamps of A pages to the time to be written
+ */
+class Schedule {
+  protected:
+    static const Uint32 week_ms = 60u * 60 * 24 * 7 * 1000;
+    bool initialized;
+    Uint32 itow_ms_previous;
+    float_sylph_t t_log; ///< elapsed time in the log [sec]
+    float_sylph_t t_due; ///< [sec], which is monotonically increasing
+    UniformRandom rand;
+  public:
+    unsigned long skipped_jumps; ///< number of ignored time jumps
+
+    Schedule()
+        : initialized(false), itow_ms_previous(0), t_log(0), t_due(0),
+        rand(options.seed), skipped_jumps(0) {}
+
+    /**
+     * @return (float_sylph_t) time to be written in seconds from the beginning
+     */
+    float_sylph_t operator()(const char (&page)[SYLPHIDE_PAGE_SIZE]){
+      if(page[0] == 'A'){
+        Uint32 itow_ms(le_char4_2_num<Uint32>(page[2]));
+        if(initialized){
+          Uint32 step((itow_ms + week_ms - itow_ms_previous) % week_ms); // roll over
+          if(step > 60000){ // broken time stamp, longer than 1 minute
+            ++skipped_jumps;
+          }else{
+            t_log += 1E-3 * step;
+          }
+        }
+        initialized = true;
+        itow_ms_previous = itow_ms;
+      }
+      float_sylph_t t(options.speed > 0 ? (t_log / options.speed) : 0);
+      if(options.jitter > 0){t += options.jitter * rand();}
+      if((options.burst_period > 0) && (options.burst_length > 0)){
+        float_sylph_t phase(std::fmod(t, options.burst_period));
+        if(phase < options.burst_length){t += (options.burst_length - phase);}
+      }
+      if(t > t_due){t_due = t;} // keep the order of pages
+      return t_due;
+    }
+};
+
+int main(int argc, char *argv[]){
+
+  cerr << "NinjaScan log replay" << endl;
+  cerr << "Usage: (exe) [options] log.dat" << endl;
+
+  const char *log_spec(NULL);
+  for(int i(1); i < argc; i++){
+    if(options.check_spec(argv[i])){continue;}
+    if(!log_spec && (std::strncmp(argv[i], "--", 2) != 0)){
+      log_spec = argv[i];
+      continue;
+    }
+    cerr << "(error!) Unknown option!! : " << argv[i] << endl;
+    return -1;
+  }
+  if(!log_spec){
+    cerr << "(error!) No log file." << endl;
+    return -1;
+  }
+
+  cerr << "Log file: ";
+  istream &in_raw(options.spec2istream(log_spec));
+  istream &in(options.in_sylphide
+      ? *(new SylphideIStream(in_raw, SYLPHIDE_PAGE_SIZE))
+      : in_raw);
+
+  Sink *sink;
+  if(options.pty){
+#if defined(LOG_REPLAY_USE_PTY)
+    sink = new PTY_Sink(options.pty);
+#else
+    cerr << "(error!) pty is not supported on this platform." << endl;
+    return -1;
+#endif
+  }else{
+    sink = new StreamSink(options.out());
+  }
+
+  Schedule schedule;
+  std::vector<char> batch;
+  float_sylph_t batch_due(0);
+  unsigned long long pages(0), bytes(0), writes(0);
+  float_sylph_t lateness_total(0), lateness_max(0);
+  bool closed(false);
+
+  time_ns_t t_start(ComportStream::buf_t::monotonic_ns()
+      + (time_ns_t)((options.wait > 0 ? options.wait : 0) * 1E9));
+
+  // Write pages in batch at its scheduled time
+  struct {
+    float_sylph_t operator()(const time_ns_t &t_start, const float_sylph_t &due){
+      while(true){
+        time_ns_t now(ComportStream::buf_t::monotonic_ns());
+        float_sylph_t elapsed((now > t_start) ? (1E-9 * (now - t_start)) : -1E-9 * (t_start - now));
+        if(elapsed >= due){return elapsed - due;}
+        float_sylph_t remaining(due - elapsed);
+        Thread::sleep_us((remaining > 1) ? 1000000 : (unsigned int)(remaining * 1E6));
+      }
+    }
+  } wait_until;
+
+  char page[SYLPHIDE_PAGE_SIZE];
+  while(!closed){
+    in.read(page, sizeof(page));
+    std::streamsize read_count(in.gcount());
+    bool eof(in.fail() || (read_count < (std::streamsize)sizeof(page)));
+    float_sylph_t due(eof ? 0 : schedule(page));
+    if((!batch.empty()) && (eof || (due > batch_due) || (batch.size() >= 0x1000))){
+      float_sylph_t lateness(wait_until(t_start, batch_due));
+      lateness_total += lateness;
+      if(lateness > lateness_max){lateness_max = lateness;}
+      closed = !sink->write(&batch[0], batch.size());
+      ++writes;
+      batch.clear();
+    }
+    if(eof){break;}
+    if(batch.empty()){batch_due = due;}
+    batch.insert(batch.end(), page, page + sizeof(page));
+    ++pages;
+    bytes += sizeof(page);
+  }
+  sink->finish();
+
+  cerr << "pages: " << pages << ", bytes: " << bytes << ", writes: " << writes << endl;
+  cerr << "lateness [s]: mean " << (writes > 0 ? (lateness_total / writes) : 0)
+      << ", max " << lateness_max << endl;
+  cerr << "dropped [bytes]: " << sink->dropped << endl;
+  if(schedule.skipped_jumps > 0){
+    cerr << "(warning!) ignored time jumps: " << schedule.skipped_jumps << endl;
+  }
+  if(closed){
+    cerr << "(warning!) output is closed before the end of the log." << endl;
+  }
+  delete sink;
+
+  return 0;
+}
@@ -144,6 +144,32 @@ class Filtered_INS2_Property<INS_BiasEstimated<BaseINS> >
         = Q_SIZE_WITHOUT_BIAS + Q_SIZE_BIAS;
 #endif
         ;
+
+    /**
+     * Sparsity pattern of A matrix generated by Filtered_INS_BiasEstimated::getAB(),
+     * where the accelerometer and gyro columns of B are copied to the bias columns,
+     * and the bias rows have the diagonal elements only.
+     */
+    static bool is_nonzero_A(const unsigned &i, const unsigned &j){
+      if(i < P_SIZE_WITHOUT_BIAS){
+        return (j < P_SIZE_WITHOUT_BIAS)
+            ? Filtered_INS2_Property<BaseINS>::is_nonzero_A(i, j)
+            : ((j < P_SIZE_WITHOUT_BIAS + P_SIZE_BIAS)
+              && Filtered_INS2_Property<BaseINS>::is_nonzero_B(i, j - P_SIZE_WITHOUT_BIAS));
+      }
+      return (i == j) && (i < P_SIZE_WITHOUT_BIAS + P_SIZE_BIAS);
+    }
+    /**
+     * Sparsity pattern of B matrix generated by Filtered_INS_BiasEstimated::getAB()
+     */
+    static bool is_nonzero_B(const unsigned &i, const unsigned &j){
+      if(i < P_SIZE_WITHOUT_BIAS){
+        return (j < Q_SIZE_WITHOUT_BIAS)
+            && Filtered_INS2_Property<BaseINS>::is_nonzero_B(i, j);
+      }
+      return (i < P_SIZE_WITHOUT_BIAS + P_SIZE_BIAS)
+          && (j == Q_SIZE_WITHOUT_BIAS + (i - P_SIZE_WITHOUT_BIAS));
+    }
 };
 
 #if !defined(_MSC_VER)
@@ -266,6 +292,15 @@ class Filtered_INS_BiasEstimated : public BaseFINS {
 
     vec3_t &beta_accel(){return m_beta_accel;}
     vec3_t &beta_gyro(){return m_beta_gyro;}
+    float_t &deltaT_sum(){return m_deltaT_sum;}
+#if BIAS_EST_MODE == 1
+    vec3_t &modified_bias_accel(){return previous_modified_bias_accel;}
+    vec3_t &modified_bias_gyro(){return previous_modified_bias_gyro;}
+#elif BIAS_EST_MODE == 2
+    float_t &deltaT_sum_previous(){return previous_delteT_sum;}
+    vec3_t &drift_bias_accel_sum(){return drift_bias_accel;}
+    vec3_t &drift_bias_gyro_sum(){return drift_bias_gyro;}
+#endif
 
     void getAB(
         const vec3_t &accel,
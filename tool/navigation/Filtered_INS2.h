@@ -65,6 +65,36 @@ class Filtered_INS2_Property {
         = BaseINS::STATE_VALUES - 5
 #endif
         ; ///< Qs(͌덷Us)̑傫
+    /**
+     * Sparsity pattern of A matrix generated by Filtered_INS2::getAB()
+     *
+     * @return (bool) true when A(i, j) can be non-zero
+     */
+    static bool is_nonzero_A(const unsigned &i, const unsigned &j){
+      static const unsigned short pattern[] = { // j-th bit of i-th row
+        0x035F, 0x02DF, 0x01DB, // velocity
+        0x0043, 0x0043, 0x0043, // q_e2n
+        0x0004, // height
+        0x035A, 0x02D9, 0x0198, // q_n2b
+      };
+      return (i < (sizeof(pattern) / sizeof(pattern[0]))) && (j < 16)
+          && ((pattern[i] >> j) & 0x01);
+    }
+    /**
+     * Sparsity pattern of B matrix generated by Filtered_INS2::getAB()
+     *
+     * @return (bool) true when B(i, j) can be non-zero
+     */
+    static bool is_nonzero_B(const unsigned &i, const unsigned &j){
+      static const unsigned short pattern[] = { // j-th bit of i-th row
+        0x0007, 0x0007, 0x0047, // velocity
+        0x0000, 0x0000, 0x0000, // q_e2n
+        0x0000, // height
+        0x0038, 0x0038, 0x0038, // q_n2b
+      };
+      return (i < (sizeof(pattern) / sizeof(pattern[0]))) && (j < 16)
+          && ((pattern[i] >> j) & 0x01);
+    }
 };
 
 #if !defined(_MSC_VER)
@@ -121,12 +151,67 @@ class Filtered_INS2
 
     using property_t::P_SIZE;
     using property_t::Q_SIZE;
+
+    typedef typename filter_t::sparsity_t sparsity_t;
+
+    /**
+     * Sparsity pattern of @f$ \Phi = I + A \Delta t @f$ and @f$ \Gamma = B \Delta t @f$,
+     * which is derived from property_t and shared by all instances.
+     * The time update uses it to skip the products of zero blocks.
+     * Because the elements outside of it are ignored, a subclass overriding getAB()
+     * must also provide property_t whose is_nonzero_A() and is_nonzero_B() cover
+     * all the elements set by the override, as Filtered_INS_BiasEstimated does.
+     */
+    static const sparsity_t &sparsity(){
+      struct generator_t {
+        static sparsity_t generate(){
+          sparsity_t res;
+          res.phi.resize(P_SIZE);
+          res.gamma.resize(P_SIZE);
+          for(unsigned i(0); i < P_SIZE; ++i){
+            for(unsigned j(0); j < P_SIZE; ++j){
+              if((i == j) || property_t::is_nonzero_A(i, j)){res.phi[i].push_back(j);}
+            }
+            for(unsigned j(0); j < Q_SIZE; ++j){
+              if(property_t::is_nonzero_B(i, j)){res.gamma[i].push_back(j);}
+            }
+          }
+          res.update_offset();
+          return res;
+        }
+      };
+      static const sparsity_t res(generator_t::generate());
+      return res;
+    }
     
   protected:
     filter_t m_filter;  ///< J}tB^{
     
 #define R_STRICT ///< ȗaɌvZ邩̃XCb`ȀꍇvZ
     
+  public:
+    /**
+     * Accumulator of the time update deferred by setPropagationInterval()
+     */
+    struct propagation_t {
+      unsigned int interval; ///< number of samples per covariance propagation
+      unsigned int pending; ///< number of accumulated samples
+      float_t A_dt[P_SIZE][P_SIZE]; ///< @f$ \sum A \Delta t @f$
+      float_t Q_d[P_SIZE][P_SIZE]; ///< @f$ \sum \Gamma Q \Gamma^{T} @f$
+      propagation_t() : interval(1) {clear();}
+      void clear(){
+        pending = 0;
+        for(unsigned i(0); i < P_SIZE; ++i){
+          for(unsigned j(0); j < P_SIZE; ++j){
+            A_dt[i][j] = Q_d[i][j] = 0;
+          }
+        }
+      }
+    };
+
+  protected:
+    propagation_t m_propagation;
+
     using BaseINS::get;
     
     struct getAB_res {
@@ -173,6 +258,7 @@ class Filtered_INS2
      * @param gyro px
      * @param res vZli[Xy[X
      * @return (getAB_res) A,Bs
+     * @see sparsity(), which must cover the elements set by an override
      */
     virtual void getAB(
         const vec3_t &accel,
@@ -180,8 +266,8 @@ class Filtered_INS2
         getAB_res &res) const {
 
       // ]švZ
-      mat_t dcm_e2n((this->q_e2n).getDCM()); ///< @f$ \mathrm{DCM} \left( \Tilde{q}_{e}^{n} \right) @f$
-      mat_t dcm_n2b((this->q_n2b).getDCM()); ///< @f$ \mathrm{DCM} \left( \Tilde{q}_{n}^{b} \right) @f$
+      Matrix_Fixed<float_t, 3> dcm_e2n((this->q_e2n).getDCM()); ///< @f$ \mathrm{DCM} \left( \Tilde{q}_{e}^{n} \right) @f$
+      Matrix_Fixed<float_t, 3> dcm_n2b((this->q_n2b).getDCM()); ///< @f$ \mathrm{DCM} \left( \Tilde{q}_{n}^{b} \right) @f$
       
 #ifndef pow2
 #define pow2(x) ((x) * (x))
@@ -415,7 +501,8 @@ class Filtered_INS2
      */
     Filtered_INS2(const Filtered_INS2 &orig, const bool &deepcopy = false)
         : BaseINS(orig, deepcopy),
-          m_filter(orig.m_filter, deepcopy){
+          m_filter(orig.m_filter, deepcopy),
+          m_propagation(orig.m_propagation){
     }
     
     virtual ~Filtered_INS2(){}
@@ -434,6 +521,113 @@ class Filtered_INS2
         const float_t &deltaT
       ){}
       
+    /**
+     * Accumulate @f$ A \Delta t @f$ and @f$ \Gamma Q \Gamma^{T} @f$ of a sample
+     * instead of propagating @f$ P @f$.
+     *
+     * @param AB A and B matrices
+     * @param deltaT time interval
+     */
+    void accumulate_propagation(const getAB_res &AB, const float_t &deltaT){
+      const sparsity_t &pattern(sparsity());
+      const mat_t &Q(m_filter.getQ());
+      const float_t deltaT2(deltaT * deltaT);
+      for(unsigned i(0); i < P_SIZE; ++i){
+        for(std::vector<unsigned int>::const_iterator it(pattern.phi[i].begin());
+            it != pattern.phi[i].end(); ++it){
+          m_propagation.A_dt[i][*it] += AB.A[i][*it] * deltaT;
+        }
+        if(pattern.gamma[i].empty()){continue;}
+
+        float_t BQ[Q_SIZE]; // i-th row of B * Q
+        for(unsigned b(0); b < Q_SIZE; ++b){
+          BQ[b] = 0;
+          for(std::vector<unsigned int>::const_iterator it(pattern.gamma[i].begin());
+              it != pattern.gamma[i].end(); ++it){
+            BQ[b] += AB.B[i][*it] * Q(*it, b);
+          }
+        }
+        for(unsigned l(0); l <= i; ++l){
+          float_t sum(0);
+          for(std::vector<unsigned int>::const_iterator it(pattern.gamma[l].begin());
+              it != pattern.gamma[l].end(); ++it){
+            sum += BQ[*it] * AB.B[l][*it];
+          }
+          m_propagation.Q_d[i][l] += sum * deltaT2;
+          if(l != i){m_propagation.Q_d[l][i] = m_propagation.Q_d[i][l];}
+        }
+      }
+      ++m_propagation.pending;
+    }
+
+    /**
+     * Compute the transition matrix and the process noise of the N accumulated samples.
+     * With @f$ S = \sum A \Delta t @f$ and @f$ \bar{Q} = \sum \Gamma Q \Gamma^{T} @f$,
+     * the product of N transition matrices @f$ \prod (I + A \Delta t) @f$
+     * and the process noise propagated through them are expanded up to the second order
+     * under the assumption that @f$ A @f$ is constant in the interval, i.e.,
+     * @f{gather*}
+     *   \Phi = I + S + \frac{N - 1}{2N} S^{2}, \\
+     *   Q_{d} = \bar{Q} + \frac{N - 1}{2N} (S \bar{Q} + \bar{Q} S^{T})
+     *       + \frac{(N - 1)(2N - 1)}{6N^{2}} S \bar{Q} S^{T}.
+     * @f}
+     * They are identical to the ones of the ordinary time update when N = 1.
+     *
+     * @param Phi (output) transition matrix
+     * @param Q_d (output) process noise
+     */
+    void get_propagation(mat_t &Phi, mat_t &Q_d) const {
+      const float_t n(m_propagation.pending);
+      const float_t c1((n - 1) / (n * 2)), c2((n - 1) * (n * 2 - 1) / (n * n * 6));
+      mat_t S(P_SIZE, P_SIZE, (const float_t *)m_propagation.A_dt);
+      mat_t Q_sum(P_SIZE, P_SIZE, (const float_t *)m_propagation.Q_d);
+      mat_t SQ(S * Q_sum);
+      Phi = (S * S) * c1 + S + 1;
+      Q_d = (SQ + SQ.transpose()) * c1 + (SQ * S.transpose()) * c2 + Q_sum;
+    }
+
+  public:
+    /**
+     * Propagate @f$ P @f$ with the accumulated samples if exist.
+     * @see get_propagation()
+     */
+    void flush_propagation(){
+      if(m_propagation.pending == 0){return;}
+      mat_t Phi, Q_d;
+      get_propagation(Phi, Q_d);
+      m_filter.predict_with_noise(Phi, Q_d);
+      m_propagation.clear();
+    }
+
+    /**
+     * Set the number of samples per covariance propagation.
+     * While the mechanization is performed for every sample, @f$ P @f$ is propagated
+     * every interval samples, and is also flushed before the measurement update
+     * and the access through getFilter().
+     * The default is 1, which means that @f$ P @f$ is propagated for every sample.
+     *
+     * @param interval number of samples
+     */
+    void setPropagationInterval(const unsigned int &interval){
+      flush_propagation();
+      m_propagation.interval = ((interval > 0) ? interval : 1);
+    }
+
+    unsigned int getPropagationInterval() const {return m_propagation.interval;}
+
+    /**
+     * Get the accumulator of the deferred propagation.
+     * Together with getFilter_deferred(), it is used to save and restore the whole state
+     * without flushing the accumulated samples.
+     */
+    propagation_t &propagation(){return m_propagation;}
+
+    /**
+     * Get the filter without flushing the accumulated samples,
+     * i.e., its @f$ P @f$ may be behind the current time.
+     */
+    filter_t &getFilter_deferred(){return m_filter;}
+
   public:    
     /**
      * ԍXV(Time Update)
@@ -450,7 +644,12 @@ class Filtered_INS2
       //std::cerr << "A:" << A << std::endl;
       //std::cerr << "B:" << B << std::endl;
       //std::cerr << "P:" << m_filter.getP() << std::endl;
-      m_filter.predict(A, B, deltaT);
+      if(m_propagation.interval > 1){
+        accumulate_propagation(AB, deltaT);
+        if(m_propagation.pending >= m_propagation.interval){flush_propagation();}
+      }else{
+        m_filter.predict(A, B, deltaT, sparsity());
+      }
       before_update_INS(A, B, deltaT);
       BaseINS::update(accel, gyro, deltaT);
     }
@@ -491,7 +690,7 @@ class Filtered_INS2
 #define ALREADY_POW2_DEFINED
 #endif
       quat_t delta_q_e2n(1, -x_hat(3, 0), -x_hat(4, 0), -x_hat(5, 0));
-      (this->q_e2n) = delta_q_e2n * (this->q_e2n);
+      this->mod_q_e2n(delta_q_e2n);
       
       // zʒu
       (*this)[7] -= x_hat(6, 0);
@@ -517,7 +716,9 @@ class Filtered_INS2
      * @param R 덷Us
      */
     void correct_primitive(const mat_t &H, const mat_t &z, const mat_t &R){
-            
+
+      flush_propagation();
+
       // Cʂ̌vZ
       mat_t K(m_filter.correct(H, R)); //J}QC
       mat_t x_hat(K * z);
@@ -542,6 +743,8 @@ class Filtered_INS2
      */
     void correct_yaw(const float_t &delta_psi, const float_t &sigma2_delta_psi){
 
+      flush_propagation();
+
       //ϑz
       float_t z_serialized[1][1] = {{-delta_psi}};
 #define z_size (sizeof(z_serialized) / sizeof(z_serialized[0]))
@@ -578,7 +781,26 @@ class Filtered_INS2
      * 
      * @return (Filter &) tB^[
      */
-    filter_t &getFilter(){return m_filter;}
+    filter_t &getFilter(){
+      flush_propagation(); // P should be up to date
+      return m_filter;
+    }
+
+    /**
+     * Get the up-to-date @f$ P @f$ without flushing the accumulated samples.
+     * It is intended for read-only access, such as output of standard deviations;
+     * therefore, the deferred propagation does not change, and the results of
+     * the following time and measurement updates are not affected.
+     *
+     * @return (mat_t) @f$ P @f$
+     */
+    mat_t getP() const {
+      const mat_t &P(const_cast<filter_t &>(m_filter).getP());
+      if(m_propagation.pending == 0){return P;}
+      mat_t Phi, Q_d;
+      get_propagation(Phi, Q_d);
+      return Phi * P * Phi.transpose() + Q_d;
+    }
 
   protected:
     static mat_t delta_q_e2n_to_delta_latlng(const float_t &lng){
@@ -669,8 +891,7 @@ class Filtered_INS2
     StandardDeviations getSigma() const {
       StandardDeviations sigma;
 
-      const mat_t &P(
-          const_cast<Filtered_INS2 *>(this)->getFilter().getP());
+      const mat_t P(getP());
 
       { // x
         sigma.v_north_ms = std::sqrt(P(0, 0));
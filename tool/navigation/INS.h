@@ -26,6 +26,7 @@
  */
 
 #include <cmath>
+#include <limits>
 
 #ifndef M_PI
   #define M_PI 3.1415926535897932384626433832795
@@ -46,6 +47,73 @@ struct INS_Property {
   static const unsigned STATE_VALUES = 12; ///< ԗʂ̐
 };
 
+/**
+ * @brief Accumulator of the position quaternion
+ *
+ * One meter on the Earth surface corresponds to about 1E-7 of the elements of
+ * @f$ \Tilde{q}_{e}^{n} @f$, which is comparable with the resolution of float.
+ * Therefore, the integration and the correction of the quaternion are performed
+ * in the higher precision AccumT, and the results are rounded to FloatT.
+ * The accumulated value is discarded when the quaternion is changed by others,
+ * which is detected by comparing it with the last rounded value.
+ *
+ * @param FloatT precision of the quaternion
+ * @param AccumT precision of the accumulation
+ */
+template <class FloatT, class AccumT = typename MatrixValue_Accumulator<FloatT>::res_t>
+struct INS_PositionAccumulator {
+  AccumT value[4];
+  FloatT rounded[4];
+  INS_PositionAccumulator(){
+    for(int i(0); i < 4; ++i){rounded[i] = std::numeric_limits<FloatT>::quiet_NaN();}
+  }
+  void load(const FloatT (&q)[4]){
+    for(int i(0); i < 4; ++i){
+      if(q[i] == rounded[i]){continue;}
+      for(int j(0); j < 4; ++j){value[j] = rounded[j] = q[j];}
+      return;
+    }
+  }
+  void store(FloatT (&q)[4]){
+    for(int i(0); i < 4; ++i){q[i] = rounded[i] = (FloatT)value[i];}
+  }
+  /**
+   * q += dot_q * deltaT
+   */
+  void integrate(FloatT (&q)[4], const FloatT (&dot_q)[4], const FloatT &deltaT){
+    load(q);
+    for(int i(0); i < 4; ++i){value[i] += (AccumT)dot_q[i] * deltaT;}
+    store(q);
+  }
+  /**
+   * q = delta_q * q
+   */
+  void premultiply(FloatT (&q)[4], const FloatT (&delta_q)[4]){
+    load(q);
+    AccumT delta_q2[4] = {delta_q[0], delta_q[1], delta_q[2], delta_q[3]};
+    Quaternion<AccumT>::product(delta_q2, value, value);
+    store(q);
+  }
+  void regularize(FloatT (&q)[4]){
+    load(q);
+    Quaternion<AccumT>::regularize(value);
+    store(q);
+  }
+};
+
+template <class FloatT>
+struct INS_PositionAccumulator<FloatT, FloatT> {
+  void integrate(FloatT (&q)[4], const FloatT (&dot_q)[4], const FloatT &deltaT){
+    for(int i(0); i < 4; ++i){q[i] += dot_q[i] * deltaT;}
+  }
+  void premultiply(FloatT (&q)[4], const FloatT (&delta_q)[4]){
+    Quaternion<FloatT>::product(delta_q, q, q);
+  }
+  void regularize(FloatT (&q)[4]){
+    Quaternion<FloatT>::regularize(q);
+  }
+};
+
 /**
  * @brief Xgbv_Eq@u(INS)
  * 
@@ -66,6 +134,7 @@ class INS {
     float_t v_N,          ///< k̑x @f$ V_{N} @f$
            v_E;           ///< ̑x @f$ V_{E} @f$
     
+    INS_PositionAccumulator<float_t> q_e2n_accum; ///< accumulator of q_e2n
     quat_t q_e2n;         ///< @f$ \Tilde{q}_{e}^{n} @f$AȂ킿݂̌oxAܓxAAzimuthp
     float_t h;            ///< ݂̍x[m]
     float_t phi,          ///< ܓx @f$ \phi @f$
@@ -157,7 +226,16 @@ class INS {
      * @return (vec3_t &)
      */
     inline vec3_t &update_omega_e2i_4n(){
-      return omega_e2i_4n = (q_e2n.conj() * omega_e2i_4e * q_e2n).vector();
+      // (q_e2n.conj() * omega_e2i_4e * q_e2n).vector() without temporary objects
+      float_t q[4], q_conj[4], omega[3], buf[4];
+      q_e2n.get(q);
+      q_conj[0] = q[0];
+      for(int i(1); i < 4; ++i){q_conj[i] = -q[i];}
+      omega_e2i_4e.get(omega);
+      quat_t::product(q_conj, omega, buf);
+      quat_t::product(buf, q, buf);
+      for(int i(0); i < 3; ++i){omega_e2i_4n[i] = buf[i + 1];}
+      return omega_e2i_4n;
     }
     /**
      * ݈ʒuł@f$ \vec{\omega}_{n/e}^{n} @f$߂܂B
@@ -185,7 +263,7 @@ class INS {
     inline vec3_t &update_omega_n2e_4n(){
       return update_omega_n2e_4n(std::cos(alpha), std::sin(alpha));
     }
-  protected:
+  public:
     /**
      * tяČvZčŐV̏Ԃɕۂ܂B
      * 
@@ -194,8 +272,9 @@ class INS {
     inline void recalc(const bool &regularize = true){
       //K
       if(regularize){
-        q_e2n = q_e2n.regularize();
-        q_n2b = q_n2b.regularize();
+        float_t buf[4];
+        q_e2n.get(buf); q_e2n_accum.regularize(buf); q_e2n.set(buf);
+        q_n2b.get(buf); quat_t::regularize(buf); q_n2b.set(buf);
       }
       
       //ܓxAoxAAzimuthp̍XV
@@ -340,6 +419,7 @@ class INS {
     INS(const INS &orig, const bool &deepcopy = false) :
       v_2e_4n(deepcopy ? orig.v_2e_4n.copy() : orig.v_2e_4n), 
       v_N(orig.v_N), v_E(orig.v_E),
+      q_e2n_accum(orig.q_e2n_accum),
       q_e2n(deepcopy ? orig.q_e2n.copy() : orig.q_e2n), 
       h(orig.h), phi(orig.phi), lambda(orig.lambda), alpha(orig.alpha),
       q_n2b(deepcopy ? orig.q_n2b.copy() : orig.q_n2b), 
@@ -451,27 +531,67 @@ class INS {
      */
     virtual void update(const vec3_t &accel, const vec3_t &gyro, const float_t &deltaT){
       
+      /* The following equations are evaluated on plain arrays with the allocation-free kernels
+       * of quat_t and vec3_t, which keep the order of arithmetic of the operator expressions
+       * in the comments. Therefore, the results are identical to the expressions' ones.
+       */
+      float_t q_n2b_[4], q_e2n_[4], v_2e_4n_[3], omega_n2e_4n_[3], accel_[3], gyro_[3];
+      q_n2b.get(q_n2b_);
+      q_e2n.get(q_e2n_);
+      v_2e_4n.get(v_2e_4n_);
+      omega_n2e_4n.get(omega_n2e_4n_);
+      accel.get(accel_);
+      gyro.get(gyro_);
+
       // Kinematic Eq. of velocity x̉^
-      vec3_t dot_v_2e_4n((q_n2b * accel * q_n2b.conj()).vector());
-      dot_v_2e_4n += gravity_total();
-      dot_v_2e_4n -= (omega_e2i_4n * 2 + omega_n2e_4n) * v_2e_4n;
+      // (q_n2b * accel * q_n2b.conj()).vector() + gravity_total()
+      //     - (omega_e2i_4n * 2 + omega_n2e_4n) * v_2e_4n
+      float_t dot_v_2e_4n[3];
+      {
+        float_t buf[4], q_n2b_conj[4] = {q_n2b_[0], -q_n2b_[1], -q_n2b_[2], -q_n2b_[3]};
+        quat_t::product(q_n2b_, accel_, buf);
+        quat_t::product(buf, q_n2b_conj, buf);
+        float_t omega[3], coriolis[3];
+        for(int i(0); i < 3; ++i){omega[i] = omega_e2i_4n.get(i) * 2 + omega_n2e_4n_[i];}
+        vec3_t::cross(omega, v_2e_4n_, coriolis);
+        const vec3_t g(gravity_total());
+        for(int i(0); i < 3; ++i){
+          dot_v_2e_4n[i] = buf[i + 1];
+          dot_v_2e_4n[i] += g[i];
+          dot_v_2e_4n[i] -= coriolis[i];
+        }
+      }
       
       // Kinematic Eq. of position ʒủ^
-      quat_t dot_q_e2n(q_e2n * omega_n2e_4n);
-      dot_q_e2n /= 2;
-      float_t dot_h(v_2e_4n[2] * -1);
+      // q_e2n * omega_n2e_4n / 2
+      float_t dot_q_e2n[4];
+      quat_t::product(q_e2n_, omega_n2e_4n_, dot_q_e2n);
+      for(int i(0); i < 4; ++i){dot_q_e2n[i] *= (float_t(1) / 2);}
+      float_t dot_h(v_2e_4n_[2] * -1);
       
       // Kinematic Eq. of attitude p̉^
-      quat_t dot_q_n2b(0, omega_e2i_4n + omega_n2e_4n);
-      dot_q_n2b *= q_n2b;
-      dot_q_n2b -= q_n2b * gyro;
-      dot_q_n2b /= (-2);
+      // ((0, omega_e2i_4n + omega_n2e_4n) * q_n2b - q_n2b * gyro) / (-2)
+      float_t dot_q_n2b[4];
+      {
+        float_t buf[4];
+        dot_q_n2b[0] = 0;
+        for(int i(0); i < 3; ++i){dot_q_n2b[i + 1] = omega_e2i_4n.get(i) + omega_n2e_4n_[i];}
+        quat_t::product(dot_q_n2b, q_n2b_, dot_q_n2b);
+        quat_t::product(q_n2b_, gyro_, buf);
+        for(int i(0); i < 4; ++i){
+          dot_q_n2b[i] -= buf[i];
+          dot_q_n2b[i] *= (float_t(1) / (-2));
+        }
+      }
       
       // Update principal variables XV
-      v_2e_4n += dot_v_2e_4n * deltaT;
-      q_e2n += dot_q_e2n * deltaT;
+      for(int i(0); i < 3; ++i){v_2e_4n_[i] += dot_v_2e_4n[i] * deltaT;}
+      q_e2n_accum.integrate(q_e2n_, dot_q_e2n, deltaT);
       h += dot_h * deltaT;
-      q_n2b += dot_q_n2b * deltaT;
+      for(int i(0); i < 4; ++i){q_n2b_[i] += dot_q_n2b[i] * deltaT;}
+      v_2e_4n.set(v_2e_4n_);
+      q_e2n.set(q_e2n_);
+      q_n2b.set(q_n2b_);
       
       // Recalculation of additional properties tI̍ČvZ
       recalc();
@@ -586,6 +706,21 @@ class INS {
       q_n2b *= delta_q;
     }
 
+    /**
+     * Modify the position as @f$ \delta \Tilde{q} \Tilde{q}_{e}^{n} @f$,
+     * which is evaluated in the accumulation precision of the position quaternion.
+     * recalc() should be called after the modification.
+     *
+     * @param delta_q @f$ \delta \Tilde{q} @f$
+     */
+    void mod_q_e2n(const quat_t &delta_q){
+      float_t q[4], delta[4];
+      q_e2n.get(q);
+      delta_q.get(delta);
+      q_e2n_accum.premultiply(q, delta);
+      q_e2n.set(q);
+    }
+
     /**
      * [pƃAWXp𑫂킹wfBO(^ʊp)Ԃ܂B
      * @return (float_t) wfBO
@@ -0,0 +1,172 @@
+/*
+ *  INS_GPS_Batch.h, header file to run many INS/GPS instances of the same model
+ *  in lockstep with the batched Kalman filter.
+ *  Copyright (C) 2019 M.Naruoka (fenrir)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __INS_GPS_BATCH_H__
+#define __INS_GPS_BATCH_H__
+
+#include <vector>
+
+#include "algorithm/kalman_batch.h"
+#include "navigation/Filtered_INS2.h"
+#include "navigation/INS_GPS2.h"
+
+/**
+ * @brief Many INS/GPS instances whose covariance is processed together
+ *
+ * The members are deep copies of a prototype, and their filters are attached to
+ * a KalmanFilterBatch. Each member computes its own system and observation models
+ * with Filtered_INS2::getAB() and INS_GPS2::correct_info() respectively,
+ * and runs its own mechanization, while the covariance updates of all members
+ * are performed by a single call of KalmanFilterBatch::predict() or correct().
+ * This is suitable for Monte Carlo runs, where the members have different initial states
+ * or different sensor errors.
+ *
+ * The filter of INS_GPS must be KalmanFilterBatched, for example,
+ * INS_GPS2<Filtered_INS2<INS<>, KalmanFilterBatched> >.
+ * The covariance of a member must be changed with setP() of its filter;
+ * in-place modification of the matrix returned by getP() is not reflected.
+ *
+ * @param INS_GPS INS/GPS class
+ */
+template <class INS_GPS>
+class INS_GPS_Batch {
+  public:
+    typedef INS_GPS ins_gps_t;
+    typedef typename INS_GPS::float_t float_t;
+    typedef typename INS_GPS::vec3_t vec3_t;
+    typedef KalmanFilterBatch<float_t> batch_t;
+
+  protected:
+    std::vector<INS_GPS> members;
+    batch_t batch;
+
+  private:
+    INS_GPS_Batch(const INS_GPS_Batch &);
+    INS_GPS_Batch &operator=(const INS_GPS_Batch &);
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param prototype initial state of all members
+     * @param size number of members
+     */
+    INS_GPS_Batch(const INS_GPS &prototype, const unsigned int &size)
+        : members(), batch(
+          INS_GPS::P_SIZE, INS_GPS::Q_SIZE, size,
+          (prototype.getPropagationInterval() > 1) ? NULL : &INS_GPS::sparsity()) {
+      members.reserve(size); // addresses of filters must be kept for the batch
+      for(unsigned int i(0); i < size; ++i){
+        members.push_back(INS_GPS(prototype, true));
+      }
+      for(unsigned int i(0); i < size; ++i){
+        members[i].getFilter().attach(batch, i);
+      }
+    }
+    ~INS_GPS_Batch(){}
+
+    unsigned int size() const {return members.size();}
+    INS_GPS &operator[](const unsigned int &i){return members[i];}
+    const INS_GPS &operator[](const unsigned int &i) const {return members[i];}
+    batch_t &getBatch(){return batch;}
+
+    /**
+     * Time update of all members with their own inputs
+     *
+     * @param accel array of acceleration, whose length is size()
+     * @param gyro array of angular speed, whose length is size()
+     * @param deltaT time interval
+     */
+    void update(const vec3_t accel[], const vec3_t gyro[], const float_t &deltaT){
+      for(unsigned int i(0); i < members.size(); ++i){
+        members[i].update(accel[i], gyro[i], deltaT);
+      }
+      batch.predict();
+    }
+
+    /**
+     * Time update of all members with a common input
+     *
+     * @param accel acceleration
+     * @param gyro angular speed
+     * @param deltaT time interval
+     */
+    void update(const vec3_t &accel, const vec3_t &gyro, const float_t &deltaT){
+      for(unsigned int i(0); i < members.size(); ++i){
+        members[i].update(accel, gyro, deltaT);
+      }
+      batch.predict();
+    }
+
+    /**
+     * Measurement update of all members, which is equivalent to
+     * members[i].correct_primitive(info[i]) for each member.
+     *
+     * @param info array of measurements, whose length is size()
+     */
+    void correct(const CorrectInfo<float_t> info[]){
+      unsigned int m_max(0);
+      for(unsigned int i(0); i < members.size(); ++i){
+        if(info[i].H.rows() > m_max){m_max = info[i].H.rows();}
+      }
+      for(unsigned int i(0); i < members.size(); ++i){
+        // samples deferred by setPropagationInterval() are stored to the batch,
+        // and then propagated at the beginning of batch.correct()
+        members[i].flush_propagation();
+      }
+      batch.prepare_correct(m_max);
+      for(unsigned int i(0); i < members.size(); ++i){
+        batch.set_measurement(i, info[i].H, info[i].R);
+      }
+      batch.correct();
+      for(unsigned int i(0); i < members.size(); ++i){
+        members[i].correct_primitive(info[i]); // gain obtained by the batch is used
+      }
+    }
+
+    /**
+     * Measurement update of all members with their own GPS solutions
+     *
+     * @param gps array of GPS solutions, whose length is size()
+     */
+    void correct(const GPS_Solution<float_t> gps[]){
+      std::vector<CorrectInfo<float_t> > info;
+      info.reserve(members.size());
+      for(unsigned int i(0); i < members.size(); ++i){
+        info.push_back(members[i].correct_info(gps[i]));
+      }
+      correct(&info[0]);
+    }
+
+    /**
+     * Measurement update of all members with a common GPS solution
+     *
+     * @param gps GPS solution
+     */
+    void correct(const GPS_Solution<float_t> &gps){
+      std::vector<CorrectInfo<float_t> > info;
+      info.reserve(members.size());
+      for(unsigned int i(0); i < members.size(); ++i){
+        info.push_back(members[i].correct_info(gps));
+      }
+      correct(&info[0]);
+    }
+};
+
+#endif /* __INS_GPS_BATCH_H__ */
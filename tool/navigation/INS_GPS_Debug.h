@@ -157,10 +157,9 @@ class INS_GPS_Debug_Covariance : public INS_GPS_Debug<INS_GPS> {
       inspect_matrix(out, mat);
     }
     void inspect(std::ostream &out) const {
-      typedef INS_GPS_Debug_Covariance<INS_GPS> self_t;
       switch(super_t::debug_target){
         case super_t::DEBUG_KF_P:
-          inspect_matrix(out, const_cast<self_t *>(this)->getFilter().getP());
+          inspect_matrix(out, this->getP());
           break;
         case super_t::DEBUG_KF_FULL:
           switch(last_action){
@@ -177,7 +176,7 @@ class INS_GPS_Debug_Covariance : public INS_GPS_Debug<INS_GPS> {
               inspect_matrix2(out, snapshot.v, "v");
               break;
           }
-          inspect_matrix2(out, const_cast<self_t *>(this)->getFilter().getP(), "P");
+          inspect_matrix2(out, this->getP(), "P");
           break;
       }
     }
@@ -0,0 +1,624 @@
+/*
+ *  INS_GPS_Smoother.h, header file of fixed-interval smoother of INS and GPS integration,
+ *  which processes the whole log with forward and backward passes.
+ *  Copyright (C) 2019 M.Naruoka (fenrir)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __INS_GPS_SMOOTHER_H__
+#define __INS_GPS_SMOOTHER_H__
+
+#include <vector>
+#include <cstddef>
+#include <cmath>
+
+#include "param/matrix.h"
+#include "navigation/Filtered_INS2.h"
+
+#include "util/spill_file.h"
+#include "util/thread.h"
+
+template <class FloatT>
+struct INS_GPS_RTS_Smoother_Property {
+  const char *spill_fname; ///< File to keep the forward pass, NULL means an anonymous temporary file
+  unsigned int segments; ///< Number of segments of the backward pass, which are processed concurrently
+  bool smooth_covariance; ///< True when P is smoothed as well as the state
+  INS_GPS_RTS_Smoother_Property() : spill_fname(NULL), segments(1), smooth_covariance(false) {}
+};
+
+/**
+ * @brief Fixed-interval (Rauch-Tung-Striebel) smoother over the whole log
+ *
+ * The forward pass is the ordinary filter. At each time update, the state and @f$ P_{k|k} @f$
+ * of the previous epoch k, the sum of the corrections @f$ \hat{x}_{k} @f$ applied at the epoch,
+ * and @f$ \Phi_{k} @f$ and @f$ \Gamma_{k} @f$ of the transition to the next epoch are appended
+ * to a memory-mapped spill file as a fixed size record, in which the matrices are packed
+ * with their symmetry and the sparsity pattern of Filtered_INS2.
+ * Because the error state is reset by each correction, the smoothed error of epoch k,
+ * which is applied to the recorded state with correct_INS(), is obtained backward as
+ * @f{gather*}
+ *   P_{k+1|k} = \Phi_{k} P_{k|k} \Phi_{k}^{T} + \Gamma_{k} Q \Gamma_{k}^{T}, \quad
+ *   C_{k} = P_{k|k} \Phi_{k}^{T} P_{k+1|k}^{-1}, \\
+ *   e_{k} = C_{k} \left( e_{k+1} + \hat{x}_{k+1} \right), \quad
+ *   P_{k|N} = P_{k|k} + C_{k} \left( P_{k+1|N} - P_{k+1|k} \right) C_{k}^{T},
+ * @f}
+ * where @f$ e_{N} = 0 @f$ for the last epoch N.
+ *
+ * Each step is an affine map of @f$ (e_{k+1}, P_{k+1|N}) @f$, and the composition of
+ * the maps is associative. Therefore, smooth() divides the epochs into segments and
+ * 1) composes the maps of each segment concurrently,
+ * 2) obtains the values at the segment boundaries by applying the composed maps from the last one,
+ * and 3) performs the recursion of each segment from its boundary concurrently.
+ * The total amount of work is about three times of the sequential recursion,
+ * which is shared by the segments processed on threads.
+ *
+ * The epochs to be output are selected with mark() in the forward pass,
+ * and their smoothed results are obtained in time order with next() after smooth().
+ * Q is assumed to be constant after the first time update,
+ * and the propagation interval of Filtered_INS2 must be 1.
+ */
+template <class INS_GPS>
+class INS_GPS_RTS_Smoother
+    : public INS_GPS, protected INS_GPS_RTS_Smoother_Property<typename INS_GPS::float_t> {
+  public:
+#if defined(__GNUC__) && (__GNUC__ < 5)
+    typedef typename INS_GPS::float_t float_t;
+    typedef typename INS_GPS::vec3_t vec3_t;
+    typedef typename INS_GPS::mat_t mat_t;
+#else
+    using typename INS_GPS::float_t;
+    using typename INS_GPS::vec3_t;
+    using typename INS_GPS::mat_t;
+#endif
+    typedef INS_GPS_RTS_Smoother_Property<float_t> prop_t;
+    typedef typename MatrixValue_Accumulator<float_t>::res_t value_t;
+
+    /**
+     * Navigation data to which a smoothed result is applied
+     */
+    struct output_t : public INS_GPS {
+      output_t(const INS_GPS &orig) : INS_GPS(orig, true) {}
+      using INS_GPS::correct_INS;
+    };
+
+  protected:
+    struct record_header_t {
+      double t; ///< time given by mark()
+      unsigned int marks; ///< bit field of the tags given by mark()
+    };
+
+    /**
+     * Offsets of the items of a record in float_t from the end of its header.
+     * P is stored as its upper triangle, and Phi and Gamma as their non-zero elements in row order.
+     * P is overwritten by the smoothed one when prop_t::smooth_covariance is true.
+     */
+    struct layout_t {
+      unsigned int n, q, states;
+      std::size_t x_hat, P, Phi, Gamma, e;
+      std::size_t size; ///< size of a record in bytes
+      layout_t(const unsigned int &_states)
+          : n(INS_GPS::P_SIZE), q(INS_GPS::Q_SIZE), states(_states) {
+        std::size_t nnz_phi(0), nnz_gamma(0);
+        for(unsigned int i(0); i < n; ++i){
+          nnz_phi += INS_GPS::sparsity().phi[i].size();
+          nnz_gamma += INS_GPS::sparsity().gamma[i].size();
+        }
+        x_hat = states;
+        P = x_hat + n;
+        Phi = P + (n * (n + 1) / 2);
+        Gamma = Phi + nnz_phi;
+        e = Gamma + nnz_gamma;
+        size = sizeof(record_header_t) + sizeof(float_t) * (e + n);
+        size = ((size + sizeof(double) - 1) / sizeof(double)) * sizeof(double);
+      }
+    } layout;
+
+    enum {INACTIVE, RECORDING, SMOOTHED, FAILED} status;
+    SpillFile spill;
+    unsigned long epochs; ///< number of the records
+    double t_marked;
+    unsigned int marks;
+    std::vector<value_t> x_hat_sum; ///< corrections applied to the current epoch
+    std::vector<value_t> Q;
+    bool Q_captured;
+    output_t *output;
+    unsigned long cursor; ///< epoch to be output next
+    unsigned int cursor_tag;
+
+    record_header_t &header(const unsigned long &k){
+      return *reinterpret_cast<record_header_t *>(spill.data() + layout.size * k);
+    }
+    float_t *values(const unsigned long &k){
+      return reinterpret_cast<float_t *>(spill.data() + layout.size * k + sizeof(record_header_t));
+    }
+
+    /**
+     * Append the current epoch to the spill file
+     */
+    void commit(){
+      if(status != RECORDING){return;}
+      if(!spill.resize(layout.size * (epochs + 1))){
+        status = FAILED;
+        return;
+      }
+      record_header_t &h(header(epochs));
+      h.t = t_marked;
+      h.marks = marks;
+      float_t *v(values(epochs));
+      for(unsigned int i(0); i < layout.states; ++i){v[i] = (*this)[i];}
+      for(unsigned int i(0); i < layout.n; ++i){
+        v[layout.x_hat + i] = x_hat_sum[i];
+        x_hat_sum[i] = 0;
+      }
+      {
+        mat_t P(INS_GPS::getFilter().getP());
+        float_t *dst(v + layout.P);
+        for(unsigned int i(0); i < layout.n; ++i){
+          for(unsigned int j(i); j < layout.n; ++j){*(dst++) = P(i, j);}
+        }
+      }
+      marks = 0;
+      ++epochs;
+    }
+
+    /**
+     * Call-back function for time update, which stores Phi and Gamma to the last record
+     *
+     * @param A matrix A
+     * @param B matrix B
+     * @param elapsedT interval time
+     */
+    void before_update_INS(
+        const mat_t &A, const mat_t &B,
+        const float_t &elapsedT){
+      INS_GPS::before_update_INS(A, B, elapsedT);
+      if((status != RECORDING) || (epochs == 0)){return;}
+      if(!Q_captured){
+        mat_t Q_(INS_GPS::getFilter().getQ());
+        for(unsigned int i(0); i < layout.q; ++i){
+          for(unsigned int j(0); j < layout.q; ++j){Q[i * layout.q + j] = Q_(i, j);}
+        }
+        Q_captured = true;
+      }
+      float_t *v(values(epochs - 1));
+      float_t *phi(v + layout.Phi), *gamma(v + layout.Gamma);
+      for(unsigned int i(0); i < layout.n; ++i){
+        const std::vector<unsigned int> &cols_phi(INS_GPS::sparsity().phi[i]);
+        for(unsigned int c(0); c < cols_phi.size(); ++c){
+          *(phi++) = A(i, cols_phi[c]) * elapsedT + ((i == cols_phi[c]) ? 1 : 0);
+        }
+        const std::vector<unsigned int> &cols_gamma(INS_GPS::sparsity().gamma[i]);
+        for(unsigned int c(0); c < cols_gamma.size(); ++c){
+          *(gamma++) = B(i, cols_gamma[c]) * elapsedT;
+        }
+      }
+    }
+
+    /**
+     * Accumulate corrections of the current epoch, which include the ones without filter
+     * such as Filtered_INS2::correct_yaw()
+     *
+     * @param x_hat values to be corrected
+     */
+    void correct_INS(mat_t &x_hat){
+      for(unsigned int i(0); i < layout.n; ++i){x_hat_sum[i] += x_hat(i, 0);}
+      INS_GPS::correct_INS(x_hat);
+    }
+
+    /**
+     * Part of records processed on a thread in smooth()
+     */
+    struct segment_t : public Thread {
+      INS_GPS_RTS_Smoother &self;
+      const unsigned int n, q;
+      unsigned long begin, end; ///< epochs [begin, end), and the smoothed values at end are given
+      bool compose; ///< true for the phase 1), otherwise 3)
+      std::vector<value_t> E, g, L; ///< composed map, @f$ e_{begin} = E e_{end} + g @f$, and so on
+      std::vector<value_t> e_end, P_end; ///< smoothed values at end
+      std::vector<value_t> P, P_pred, PPhiT, L_chol, C, work, work2, y;
+
+      segment_t(INS_GPS_RTS_Smoother &_self, const unsigned long &_begin, const unsigned long &_end)
+          : Thread(), self(_self), n(_self.layout.n), q(_self.layout.q),
+          begin(_begin), end(_end), compose(false),
+          E(n * n), g(n), L(n * n), e_end(n), P_end(n * n),
+          P(n * n), P_pred(n * n), PPhiT(n * n), L_chol(n * n), C(n * n),
+          work(n * n), work2(n * n), y(n) {}
+      ~segment_t(){join();}
+
+      /**
+       * Load @f$ P_{k|k} @f$ to P, and calculate @f$ P_{k+1|k} @f$ and @f$ C_{k} @f$
+       */
+      void gain(const unsigned long &k){
+        const float_t *v(self.values(k));
+        const typename INS_GPS::sparsity_t &pattern(INS_GPS::sparsity());
+        {
+          const float_t *src(v + self.layout.P);
+          for(unsigned int i(0); i < n; ++i){
+            for(unsigned int j(i); j < n; ++j){P[i * n + j] = P[j * n + i] = *(src++);}
+          }
+        }
+        { // P Phi^T
+          const float_t *phi(v + self.layout.Phi);
+          for(unsigned int j(0); j < n; ++j){
+            const std::vector<unsigned int> &cols(pattern.phi[j]);
+            for(unsigned int i(0); i < n; ++i){
+              value_t sum(0);
+              for(unsigned int c(0); c < cols.size(); ++c){sum += P[i * n + cols[c]] * phi[c];}
+              PPhiT[i * n + j] = sum;
+            }
+            phi += cols.size();
+          }
+        }
+        { // Phi P Phi^T
+          const float_t *phi(v + self.layout.Phi);
+          for(unsigned int i(0); i < n; ++i){
+            const std::vector<unsigned int> &cols(pattern.phi[i]);
+            for(unsigned int j(i); j < n; ++j){
+              value_t sum(0);
+              for(unsigned int c(0); c < cols.size(); ++c){sum += phi[c] * PPhiT[cols[c] * n + j];}
+              P_pred[i * n + j] = sum;
+            }
+            phi += cols.size();
+          }
+        }
+        { // + Gamma Q Gamma^T
+          const float_t *gamma_i(v + self.layout.Gamma);
+          for(unsigned int i(0); i < n; ++i){
+            const std::vector<unsigned int> &cols_i(pattern.gamma[i]);
+            if(cols_i.empty()){continue;}
+            for(unsigned int b(0); b < q; ++b){ // i-th row of Gamma Q
+              value_t sum(0);
+              for(unsigned int c(0); c < cols_i.size(); ++c){sum += gamma_i[c] * self.Q[cols_i[c] * q + b];}
+              y[b] = sum;
+            }
+            const float_t *gamma_j(gamma_i);
+            for(unsigned int j(i); j < n; ++j){
+              const std::vector<unsigned int> &cols_j(pattern.gamma[j]);
+              value_t sum(0);
+              for(unsigned int c(0); c < cols_j.size(); ++c){sum += y[cols_j[c]] * gamma_j[c];}
+              P_pred[i * n + j] += sum;
+              gamma_j += cols_j.size();
+            }
+            gamma_i += cols_i.size();
+          }
+        }
+        for(unsigned int i(1); i < n; ++i){
+          for(unsigned int j(0); j < i; ++j){P_pred[i * n + j] = P_pred[j * n + i];}
+        }
+
+        // Cholesky decomposition of P_{k+1|k}, where the rank deficient part is ignored.
+        for(unsigned int j(0); j < n; ++j){
+          value_t d(P_pred[j * n + j]);
+          for(unsigned int k2(0); k2 < j; ++k2){d -= L_chol[j * n + k2] * L_chol[j * n + k2];}
+          value_t &l_jj(L_chol[j * n + j]);
+          l_jj = (d > 0) ? std::sqrt(d) : 0;
+          for(unsigned int i(j + 1); i < n; ++i){
+            value_t s(P_pred[i * n + j]);
+            for(unsigned int k2(0); k2 < j; ++k2){s -= L_chol[i * n + k2] * L_chol[j * n + k2];}
+            L_chol[i * n + j] = (l_jj > 0) ? (s / l_jj) : 0;
+          }
+        }
+
+        // Each row of C is the solution of P_{k+1|k} c^T = (Phi P)^{T}.
+        for(unsigned int r(0); r < n; ++r){
+          for(unsigned int i(0); i < n; ++i){
+            value_t s(PPhiT[r * n + i]);
+            for(unsigned int k2(0); k2 < i; ++k2){s -= L_chol[i * n + k2] * y[k2];}
+            y[i] = (L_chol[i * n + i] > 0) ? (s / L_chol[i * n + i]) : 0;
+          }
+          for(unsigned int i(n); i-- > 0; ){
+            value_t s(y[i]);
+            for(unsigned int k2(i + 1); k2 < n; ++k2){s -= L_chol[k2 * n + i] * C[r * n + k2];}
+            C[r * n + i] = (L_chol[i * n + i] > 0) ? (s / L_chol[i * n + i]) : 0;
+          }
+        }
+      }
+
+      /**
+       * res = P + C (M - P_pred) C^T, where res may be M
+       */
+      void covariance(const std::vector<value_t> &M, std::vector<value_t> &res){
+        for(unsigned int i(0); i < n * n; ++i){work2[i] = M[i] - P_pred[i];}
+        for(unsigned int i(0); i < n; ++i){
+          for(unsigned int j(0); j < n; ++j){
+            value_t sum(0);
+            for(unsigned int l(0); l < n; ++l){sum += C[i * n + l] * work2[l * n + j];}
+            work[i * n + j] = sum;
+          }
+        }
+        for(unsigned int i(0); i < n; ++i){
+          for(unsigned int j(i); j < n; ++j){
+            value_t sum(P[i * n + j]);
+            for(unsigned int l(0); l < n; ++l){sum += work[i * n + l] * C[j * n + l];}
+            res[i * n + j] = res[j * n + i] = sum;
+          }
+        }
+      }
+
+      /**
+       * Phase 1), compose the maps of [begin, end)
+       */
+      void run_compose(){
+        for(unsigned int i(0); i < n; ++i){
+          g[i] = 0;
+          for(unsigned int j(0); j < n; ++j){
+            E[i * n + j] = (i == j) ? 1 : 0;
+            L[i * n + j] = 0;
+          }
+        }
+        for(unsigned long k(end); k-- > begin; ){
+          gain(k);
+          const float_t *x_hat(self.values(k + 1) + self.layout.x_hat);
+          for(unsigned int i(0); i < n; ++i){y[i] = g[i] + x_hat[i];}
+          for(unsigned int i(0); i < n; ++i){
+            value_t sum(0);
+            for(unsigned int l(0); l < n; ++l){sum += C[i * n + l] * y[l];}
+            g[i] = sum;
+          }
+          for(unsigned int i(0); i < n; ++i){
+            for(unsigned int j(0); j < n; ++j){
+              value_t sum(0);
+              for(unsigned int l(0); l < n; ++l){sum += C[i * n + l] * E[l * n + j];}
+              work[i * n + j] = sum;
+            }
+          }
+          E.swap(work);
+          if(self.smooth_covariance){covariance(L, L);}
+        }
+      }
+
+      /**
+       * Phase 2), give the smoothed values at begin to the previous segment
+       */
+      void propagate(segment_t &previous) const {
+        for(unsigned int i(0); i < n; ++i){
+          value_t sum(g[i]);
+          for(unsigned int l(0); l < n; ++l){sum += E[i * n + l] * e_end[l];}
+          previous.e_end[i] = sum;
+        }
+        if(!self.smooth_covariance){return;}
+        std::vector<value_t> EP(n * n);
+        for(unsigned int i(0); i < n; ++i){
+          for(unsigned int j(0); j < n; ++j){
+            value_t sum(0);
+            for(unsigned int l(0); l < n; ++l){sum += E[i * n + l] * P_end[l * n + j];}
+            EP[i * n + j] = sum;
+          }
+        }
+        for(unsigned int i(0); i < n; ++i){
+          for(unsigned int j(i); j < n; ++j){
+            value_t sum(L[i * n + j]);
+            for(unsigned int l(0); l < n; ++l){sum += EP[i * n + l] * E[j * n + l];}
+            previous.P_end[i * n + j] = previous.P_end[j * n + i] = sum;
+          }
+        }
+      }
+
+      /**
+       * Phase 3), perform the recursion from end, and store the results
+       */
+      void run_smooth(){
+        for(unsigned long k(end); k-- > begin; ){
+          gain(k);
+          float_t *v(self.values(k));
+          const float_t *x_hat(self.values(k + 1) + self.layout.x_hat);
+          for(unsigned int i(0); i < n; ++i){y[i] = e_end[i] + x_hat[i];}
+          for(unsigned int i(0); i < n; ++i){
+            value_t sum(0);
+            for(unsigned int l(0); l < n; ++l){sum += C[i * n + l] * y[l];}
+            v[self.layout.e + i] = e_end[i] = sum;
+          }
+          if(!self.smooth_covariance){continue;}
+          covariance(P_end, P_end);
+          float_t *dst(v + self.layout.P);
+          for(unsigned int i(0); i < n; ++i){
+            for(unsigned int j(i); j < n; ++j){*(dst++) = P_end[i * n + j];}
+          }
+        }
+      }
+
+      void run(){
+        if(compose){
+          run_compose();
+        }else{
+          run_smooth();
+        }
+      }
+    };
+
+    /**
+     * Backward pass over the records
+     */
+    void backward(){
+      if(epochs == 0){return;}
+      const unsigned int n(layout.n);
+      const unsigned long transitions(epochs - 1);
+      {
+        float_t *v_last(values(transitions));
+        for(unsigned int i(0); i < n; ++i){v_last[layout.e + i] = 0;}
+      }
+      if(transitions == 0){return;}
+
+      unsigned int segments((prop_t::segments > 0) ? prop_t::segments : 1);
+      if(segments > transitions){segments = (unsigned int)transitions;}
+      std::vector<segment_t *> seg;
+      for(unsigned int i(0); i < segments; ++i){
+        seg.push_back(new segment_t(*this,
+            transitions * i / segments, transitions * (i + 1) / segments));
+      }
+      { // the last epoch
+        segment_t &last(*seg.back());
+        const float_t *src(values(transitions) + layout.P);
+        for(unsigned int i(0); i < n; ++i){
+          last.e_end[i] = 0;
+          for(unsigned int j(i); j < n; ++j){
+            last.P_end[i * n + j] = last.P_end[j * n + i] = *(src++);
+          }
+        }
+      }
+
+      // 1) The first segment is not required to be composed.
+      for(unsigned int i(1); i < segments; ++i){
+        seg[i]->compose = true;
+        if(!seg[i]->start()){seg[i]->run();} // without thread
+      }
+      for(unsigned int i(1); i < segments; ++i){seg[i]->join();}
+
+      // 2)
+      for(unsigned int i(segments - 1); i > 0; --i){seg[i]->propagate(*seg[i - 1]);}
+
+      // 3)
+      for(unsigned int i(0); i < segments; ++i){
+        seg[i]->compose = false;
+        if(!seg[i]->start()){seg[i]->run();} // without thread
+      }
+      for(unsigned int i(0); i < segments; ++i){
+        seg[i]->join();
+        delete seg[i];
+      }
+    }
+
+    /**
+     * Apply the smoothed result of an epoch to out
+     */
+    void apply(const unsigned long &k, output_t &out){
+      const float_t *v(values(k));
+      for(unsigned int i(0); i < layout.states; ++i){out[i] = v[i];}
+      out.recalc(false);
+      mat_t e(layout.n, 1);
+      for(unsigned int i(0); i < layout.n; ++i){e(i, 0) = v[layout.e + i];}
+      out.correct_INS(e);
+      if(prop_t::smooth_covariance){
+        mat_t P(layout.n, layout.n);
+        const float_t *src(v + layout.P);
+        for(unsigned int i(0); i < layout.n; ++i){
+          for(unsigned int j(i); j < layout.n; ++j){P(i, j) = P(j, i) = *(src++);}
+        }
+        out.getFilter().setP(P);
+      }
+    }
+
+  public:
+    INS_GPS_RTS_Smoother()
+        : INS_GPS(), prop_t(), layout(INS_GPS::state_values()),
+        status(INACTIVE), spill(), epochs(0), t_marked(0), marks(0),
+        x_hat_sum(layout.n, 0), Q(layout.q * layout.q, 0), Q_captured(false),
+        output(NULL), cursor(0), cursor_tag(0) {}
+    /**
+     * Copy constructor, where the records are not copied, and the copy is inactive
+     * until setup_smoother() is called.
+     */
+    INS_GPS_RTS_Smoother(
+        const INS_GPS_RTS_Smoother &orig,
+        const bool &deepcopy = false)
+        : INS_GPS(orig, deepcopy), prop_t(orig), layout(orig.layout),
+        status(INACTIVE), spill(), epochs(0), t_marked(0), marks(0),
+        x_hat_sum(layout.n, 0), Q(layout.q * layout.q, 0), Q_captured(false),
+        output(NULL), cursor(0), cursor_tag(0) {}
+    virtual ~INS_GPS_RTS_Smoother(){
+      delete output;
+    }
+
+    /**
+     * @return (bool) true when the spill file is ready, otherwise false.
+     */
+    bool setup_smoother(const prop_t &property){
+      prop_t::operator=(property);
+      status = spill.open(prop_t::spill_fname) ? RECORDING : FAILED;
+      return status == RECORDING;
+    }
+
+    /**
+     * @return (bool) false when the forward pass has not been recorded entirely
+     */
+    bool good() const {return status != FAILED;}
+
+    unsigned long recorded_epochs() const {return epochs;}
+
+    /**
+     * @return (const output_t *) the result of the last next(), or NULL before smooth()
+     */
+    const output_t *get_output() const {return output;}
+
+    using INS_GPS::update;
+
+    /**
+     * Time update, before which the current epoch is recorded
+     *
+     * @param accel acceleration
+     * @param gyro angular speed
+     * @param deltaT interval time
+     */
+    void update(const vec3_t &accel, const vec3_t &gyro, const float_t &deltaT){
+      commit();
+      INS_GPS::update(accel, gyro, deltaT);
+    }
+
+    /**
+     * Select the current epoch to be output after smoothing
+     *
+     * @param t time, which is returned by next()
+     * @param tag kind of output less than 32, which is returned by next() in ascending order
+     */
+    void mark(const double &t, const unsigned int &tag){
+      t_marked = t;
+      marks |= (1u << tag);
+    }
+
+    /**
+     * Finish the forward pass, and perform the backward pass.
+     *
+     * @return (bool) true when success, false when the records are not available.
+     */
+    bool smooth(){
+      if(status == RECORDING){
+        commit(); // the last epoch
+        if(status == RECORDING){
+          backward();
+          status = SMOOTHED;
+        }
+      }
+      if(status != SMOOTHED){return false;}
+      if(!output){
+        output = new output_t(*this);
+        cursor = 0;
+        cursor_tag = 0;
+      }
+      return true;
+    }
+
+    /**
+     * Advance to the next smoothed result of the marked epochs
+     *
+     * @param t time given by mark()
+     * @param tag tag given by mark()
+     * @return (const output_t *) result, which is valid until the next call, or NULL when no result remains
+     */
+    const output_t *next(double &t, unsigned int &tag){
+      if(!output){return NULL;}
+      for(; cursor < epochs; ++cursor, cursor_tag = 0){
+        const record_header_t &h(header(cursor));
+        while((cursor_tag < 32) && !((h.marks >> cursor_tag) & 0x01)){++cursor_tag;}
+        if(cursor_tag >= 32){continue;}
+        apply(cursor, *output);
+        t = h.t;
+        tag = cursor_tag++;
+        return output;
+      }
+      return NULL;
+    }
+};
+
+#endif /* __INS_GPS_SMOOTHER_H__ */
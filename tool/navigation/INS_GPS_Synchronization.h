@@ -26,6 +26,7 @@
 #include "navigation/Filtered_INS2.h"
 
 #include <list>
+#include <vector>
 
 template <class FloatT>
 struct INS_GPS_Back_Propagate_Property {
@@ -79,6 +80,7 @@ class INS_GPS_Back_Propagate : public INS_GPS, protected INS_GPS_Back_Propagate_
       prop_t::operator=(property);
     }
     const snapshots_t &get_snapshots() const {return snapshots;}
+    snapshots_t &get_snapshots() {return snapshots;}
 
   protected:
     /**
@@ -102,7 +104,7 @@ class INS_GPS_Back_Propagate : public INS_GPS, protected INS_GPS_Back_Propagate_
 
       snapshots.push_back(
           snapshot_content_t(*this,
-              Phi, Gamma * INS_GPS::getFilter().getQ() * Gamma.transpose(),
+              Phi, Gamma * INS_GPS::m_filter.getQ() * Gamma.transpose(), // without flush of deferred P
               elapsedT_from_last_correct));
     }
 
@@ -162,8 +164,15 @@ class INS_GPS_Back_Propagate : public INS_GPS, protected INS_GPS_Back_Propagate_
 
 template <class FloatT>
 struct INS_GPS_RealTime_Property {
-  enum rt_mode_t {RT_NORMAL, RT_LIGHT_WEIGHT} rt_mode; ///< Algorithm selection for realtime mode
-  INS_GPS_RealTime_Property() : rt_mode(RT_NORMAL) {}
+  /**
+   * Algorithm selection for realtime mode
+   * RT_NORMAL: exact inverse of the transition matrix Phi is calculated at every time update.
+   * RT_LIGHT_WEIGHT: Phi^{-1} is approximated with the averaged A, Eq. (4.2.41) of the report.
+   * RT_FIRST_ORDER: Phi^{-1} of each time update is approximated with (I - A dt).
+   */
+  enum rt_mode_t {RT_NORMAL, RT_LIGHT_WEIGHT, RT_FIRST_ORDER} rt_mode;
+  unsigned int snapshots_max; ///< Capacity of snapshots, which determines the acceptable GPS delay
+  INS_GPS_RealTime_Property() : rt_mode(RT_NORMAL), snapshots_max(0x200) {}
 };
 
 template <class INS_GPS>
@@ -179,25 +188,103 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
     using typename INS_GPS::mat_t;
 #endif
     typedef INS_GPS_RealTime_Property<float_t> prop_t;
-  protected:
     struct snapshot_content_t {
-      INS_GPS ins_gps;
+      INS_GPS ins_gps; ///< Only navigation states are copied, the filter is left as it is.
       mat_t A;
-      mat_t Phi_inv;
-      mat_t GQGt;
+      mat_t Gamma; ///< Owned by the snapshot, and overwritten at each time update
+      mat_t Phi_inv; ///< Only for RT_NORMAL
+      mat_t GQGt; ///< Lazily calculated with Gamma
       float_t elapsedT_from_last_update;
-      snapshot_content_t(
-          const INS_GPS &_ins_gps,
-          const mat_t &_A,
-          const mat_t &_Phi_inv,
-          const mat_t &_GQGt,
-          const float_t &_elapsedT)
-          : ins_gps(_ins_gps, true),
-          A(_A), Phi_inv(_Phi_inv), GQGt(_GQGt),
-          elapsedT_from_last_update(_elapsedT){
+      snapshot_content_t()
+          : ins_gps(), A(), Gamma(), Phi_inv(), GQGt(), elapsedT_from_last_update(0) {}
+      snapshot_content_t(const snapshot_content_t &orig)
+          : ins_gps(orig.ins_gps, true),
+          A(orig.A), Gamma(orig.Gamma.copy()), Phi_inv(orig.Phi_inv), GQGt(orig.GQGt),
+          elapsedT_from_last_update(orig.elapsedT_from_last_update) {}
+      void set_state(const INS_GPS &src){
+        for(unsigned int i(0), i_end(src.state_values()); i < i_end; ++i){
+          ins_gps[i] = src[i];
+        }
+        ins_gps.recalc(false);
+      }
+      const mat_t &get_GQGt(const mat_t &Q){
+        if(GQGt.rows() == 0){GQGt = Gamma * Q * Gamma.transpose();}
+        return GQGt;
       }
     };
-    typedef std::list<snapshot_content_t> snapshots_t;
+    /**
+     * Bounded ring buffer of snapshots, whose elements are allocated in advance
+     * and reused in order to avoid memory allocation at each time update.
+     * When the buffer is full, the oldest snapshot is dropped.
+     */
+    class snapshots_t {
+      protected:
+        std::vector<snapshot_content_t *> buf;
+        unsigned int head, count;
+        void release(){
+          for(typename std::vector<snapshot_content_t *>::iterator it(buf.begin()), it_end(buf.end());
+              it != it_end; ++it){
+            delete *it;
+          }
+          buf.clear();
+        }
+        snapshots_t &operator=(const snapshots_t &);
+      public:
+        snapshots_t(const unsigned int &capacity = prop_t().snapshots_max)
+            : buf(), head(0), count(0) {
+          resize(capacity);
+        }
+        snapshots_t(const snapshots_t &orig)
+            : buf(), head(0), count(orig.count) {
+          for(typename std::vector<snapshot_content_t *>::const_iterator it(orig.buf.begin()), it_end(orig.buf.end());
+              it != it_end; ++it){
+            buf.push_back(new snapshot_content_t(**it));
+          }
+          head = orig.head;
+        }
+        ~snapshots_t(){release();}
+        void resize(const unsigned int &capacity){
+          release();
+          head = count = 0;
+          for(unsigned int i(0); i < (capacity > 0 ? capacity : 1); ++i){
+            buf.push_back(new snapshot_content_t());
+          }
+        }
+        unsigned int capacity() const {return buf.size();}
+        unsigned int size() const {return count;}
+        bool empty() const {return count == 0;}
+        /**
+         * @param i index, where 0 is the oldest
+         */
+        snapshot_content_t &operator[](const unsigned int &i){
+          return *buf[(head + i) % buf.size()];
+        }
+        const snapshot_content_t &operator[](const unsigned int &i) const {
+          return *buf[(head + i) % buf.size()];
+        }
+        snapshot_content_t &front(){return (*this)[0];}
+        snapshot_content_t &back(){return (*this)[count - 1];}
+        /**
+         * Append a snapshot
+         *
+         * @return the appended one, whose content is the one previously used
+         */
+        snapshot_content_t &push_back(){
+          if(count < buf.size()){
+            ++count;
+          }else{
+            head = (head + 1) % buf.size();
+          }
+          return back();
+        }
+        void pop_front(unsigned int n = 1){
+          if(n > count){n = count;}
+          head = (head + n) % buf.size();
+          count -= n;
+        }
+        void clear(){head = count = 0;}
+    };
+  protected:
     snapshots_t snapshots;
   public:
     INS_GPS_RealTime()
@@ -209,7 +296,10 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
     virtual ~INS_GPS_RealTime(){}
     void setup_realtime(const prop_t &property){
       prop_t::operator=(property);
+      snapshots.resize(prop_t::snapshots_max);
     }
+    const snapshots_t &get_snapshots() const {return snapshots;}
+    snapshots_t &get_snapshots() {return snapshots;}
 
   protected:
     /**
@@ -222,14 +312,24 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
     void before_update_INS(
         const mat_t &A, const mat_t &B,
         const float_t &elapsedT){
-      mat_t Phi(A * elapsedT);
-      for(unsigned i(0), i_end(A.rows()); i < i_end; i++){Phi(i, i) += 1;}
-      mat_t Gamma(B * elapsedT);
-
-      snapshots.push_back(
-          snapshot_content_t(*this,
-              A, Phi.inverse(), Gamma * INS_GPS::getFilter().getQ() * Gamma.transpose(),
-              elapsedT));
+      snapshot_content_t &snapshot(snapshots.push_back());
+      snapshot.set_state(*this);
+      snapshot.A = A; // A and B are newly generated at each time update, thus sharing is safe.
+      if((snapshot.Gamma.rows() != B.rows()) || (snapshot.Gamma.columns() != B.columns())){
+        snapshot.Gamma = mat_t(B.rows(), B.columns()); // first use of the storage
+      }
+      for(unsigned i(0), i_end(B.rows()); i < i_end; i++){
+        for(unsigned j(0), j_end(B.columns()); j < j_end; j++){
+          snapshot.Gamma(i, j) = B(i, j) * elapsedT;
+        }
+      }
+      snapshot.GQGt = mat_t();
+      if(prop_t::rt_mode == prop_t::RT_NORMAL){
+        mat_t Phi(A * elapsedT);
+        for(unsigned i(0), i_end(A.rows()); i < i_end; i++){Phi(i, i) += 1;}
+        snapshot.Phi_inv = Phi.inverse();
+      }
+      snapshot.elapsedT_from_last_update = elapsedT;
     }
 
   public:
@@ -243,16 +343,11 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
     bool setup_correct(float_t advanceT){
       if(advanceT > 0){return false;} // positive value (future) is odd
 
-      for(typename snapshots_t::reverse_iterator it(snapshots.rbegin()), it_end(snapshots.rend());
-          it != it_end;
-          ++it){
-        advanceT += it->elapsedT_from_last_update;
+      for(unsigned int i(snapshots.size()); i > 0; --i){
+        advanceT += snapshots[i - 1].elapsedT_from_last_update;
         if(advanceT > -0.005){ // Find the closest
-          if(it == snapshots.rbegin()){
-            // Keep at least one snapshot
-            it++;
-          }
-          snapshots.erase(snapshots.begin(), it.base());
+          snapshots.pop_front(
+              (i == snapshots.size()) ? (i - 1) : i); // Keep at least one snapshot
           return true;
         }
       }
@@ -268,19 +363,19 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
      */
     void correct_with_info(CorrectInfo<float_t> &info){
       mat_t &H(info.H), &R(info.R);
+      const mat_t &Q(INS_GPS::getFilter().getQ());
       switch(prop_t::rt_mode){
         case prop_t::RT_LIGHT_WEIGHT:
           if(!snapshots.empty()){
             mat_t sum_A(H.columns(), H.columns());
             mat_t sum_GQGt(sum_A.rows(), sum_A.rows());
             float_t bar_delteT(0);
-            int n(0);
-            for(typename snapshots_t::iterator it(snapshots.begin()), it_end(snapshots.end());
-                it != it_end;
-                ++it, ++n){
-              sum_A += it->A;
-              sum_GQGt += it->GQGt;
-              bar_delteT += it->elapsedT_from_last_update;
+            int n(snapshots.size());
+            for(int i(0); i < n; ++i){
+              snapshot_content_t &snapshot(snapshots[i]);
+              sum_A += snapshot.A;
+              sum_GQGt += snapshot.get_GQGt(Q);
+              bar_delteT += snapshot.elapsedT_from_last_update;
             }
             bar_delteT /= n;
             mat_t sum_A_GQGt(sum_A * sum_GQGt);
@@ -290,13 +385,19 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
             H *= (mat_t::getI(sum_A.rows()) - sum_A * bar_delteT);  // Eq. (4.2.41)
           }
           break;
+        case prop_t::RT_FIRST_ORDER:
+          for(unsigned int i(0), i_end(snapshots.size()); i < i_end; ++i){
+            snapshot_content_t &snapshot(snapshots[i]);
+            H -= (H * snapshot.A) * snapshot.elapsedT_from_last_update; // H * (I - A dt)
+            R += H * snapshot.get_GQGt(Q) * H.transpose();
+          }
+          break;
         case prop_t::RT_NORMAL:
         default:
-          for(typename snapshots_t::iterator it(snapshots.begin()), it_end(snapshots.end());
-              it != it_end;
-              ++it){
-            H *= it->Phi_inv;
-            R += H * it->GQGt * H.transpose();
+          for(unsigned int i(0), i_end(snapshots.size()); i < i_end; ++i){
+            snapshot_content_t &snapshot(snapshots[i]);
+            H *= snapshot.Phi_inv;
+            R += H * snapshot.get_GQGt(Q) * H.transpose();
           }
       }
       INS_GPS::correct_primitive(info);
@@ -0,0 +1,119 @@
+/*
+ *  INS_Preintegration.h, header file to combine high rate IMU samples
+ *  into a delta-velocity and delta-angle increment with coning and sculling compensation.
+ *  Copyright (C) 2019 M.Naruoka (fenrir)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __INS_PREINTEGRATION_H__
+#define __INS_PREINTEGRATION_H__
+
+#include "param/vector3.h"
+
+/**
+ * @brief Preintegration of IMU samples
+ *
+ * Samples of acceleration and angular speed are combined into a single increment
+ * whose rotation vector and velocity change are compensated for coning and sculling motion
+ * with the recursive algorithm of Savage; for each sample k,
+ * @f{gather*}
+ *   \alpha_{k} = \alpha_{k-1} + \Delta \theta_{k}, \quad
+ *   \beta_{k} = \beta_{k-1} + \frac{1}{2} \alpha_{k-1} \times \Delta \theta_{k}, \\
+ *   \upsilon_{k} = \upsilon_{k-1} + \Delta v_{k}, \quad
+ *   \gamma_{k} = \gamma_{k-1}
+ *       + \frac{1}{2} \left( \alpha_{k-1} \times \Delta v_{k} + \upsilon_{k-1} \times \Delta \theta_{k} \right),
+ * @f}
+ * where @f$ \Delta \theta_{k} = \omega_{k} \Delta t_{k} @f$ and @f$ \Delta v_{k} = a_{k} \Delta t_{k} @f$.
+ * Then, the rotation vector and the velocity change in the body frame at the beginning
+ * of the interval are @f$ \alpha + \beta @f$ and
+ * @f$ \upsilon + \frac{1}{2} \alpha \times \upsilon + \gamma @f$, respectively.
+ *
+ * Because INS::update() accepts rates, accel() and gyro() return the increments divided by
+ * interval(), which are used for a single update step instead of the samples.
+ *
+ * @param FloatT precision
+ */
+template <class FloatT>
+struct INS_Preintegration {
+  typedef Vector3<FloatT> vec3_t;
+
+  vec3_t alpha; ///< sum of delta angles
+  vec3_t beta; ///< coning compensation
+  vec3_t upsilon; ///< sum of delta velocities
+  vec3_t gamma; ///< sculling compensation
+  FloatT deltaT; ///< length of the interval
+  unsigned int samples; ///< number of combined samples
+
+  INS_Preintegration()
+      : alpha(), beta(), upsilon(), gamma(), deltaT(0), samples(0) {}
+
+  void clear(){
+    alpha = beta = upsilon = gamma = vec3_t();
+    deltaT = 0;
+    samples = 0;
+  }
+
+  bool empty() const {return samples == 0;}
+  unsigned int size() const {return samples;}
+  const FloatT &interval() const {return deltaT;}
+
+  /**
+   * Add a sample
+   *
+   * @param accel acceleration in the body frame
+   * @param gyro angular speed in the body frame
+   * @param dt interval from the previous sample
+   */
+  void add(const vec3_t &accel, const vec3_t &gyro, const FloatT &dt){
+    vec3_t delta_theta(gyro * dt), delta_v(accel * dt);
+    beta += (alpha * delta_theta) / 2;
+    gamma += (alpha * delta_v + upsilon * delta_theta) / 2;
+    alpha += delta_theta;
+    upsilon += delta_v;
+    deltaT += dt;
+    ++samples;
+  }
+
+  /**
+   * Rotation vector over the interval with coning compensation
+   */
+  vec3_t delta_angle() const {
+    return alpha + beta;
+  }
+
+  /**
+   * Velocity change over the interval in the body frame at the beginning of the interval,
+   * with rotation and sculling compensation
+   */
+  vec3_t delta_velocity() const {
+    return upsilon + (alpha * upsilon) / 2 + gamma;
+  }
+
+  /**
+   * Equivalent acceleration to be used for a single update step
+   */
+  vec3_t accel() const {
+    return delta_velocity() / deltaT;
+  }
+
+  /**
+   * Equivalent angular speed to be used for a single update step
+   */
+  vec3_t gyro() const {
+    return delta_angle() / deltaT;
+  }
+};
+
+#endif /* __INS_PREINTEGRATION_H__ */
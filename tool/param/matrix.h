@@ -63,6 +63,7 @@
 #include <ostream>
 #include <limits>
 #include "param/complex.h"
+#include "param/ref_counter.h"
 
 #include <iterator>
 
@@ -217,36 +218,40 @@ class Array2D : public Array2D_Frozen<T> {
 /**
  * @brief Array2D whose elements are dense, and are stored in sequential 1D array.
  * In other words, (i, j) element is mapped to [i * rows + j].
+ * The buffer is shared by shallow copies, whose reference counter is managed by RefCounterT.
  *
  * @param T precision, for example, double
+ * @param RefCounterT reference counter policy, see ref_counter.h
  */
-template <class T>
-class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
+template <class T, class RefCounterT = RefCounter_Default>
+class Array2D_Dense : public Array2D<T, Array2D_Dense<T, RefCounterT> > {
   public:
-    typedef Array2D_Dense<T> self_t;
+    typedef Array2D_Dense<T, RefCounterT> self_t;
     typedef Array2D<T, self_t> super_t;
+    typedef RefCounterT ref_counter_t;
     
     template <class T2>
     struct cast_t {
-      typedef Array2D_Dense<T2> res_t;
+      typedef Array2D_Dense<T2, RefCounterT> res_t;
     };
 
     using super_t::rows;
     using super_t::columns;
 
   protected:
-    static const int offset = (sizeof(T) >= sizeof(int)) ? 1 : ((sizeof(int) + sizeof(T) - 1) / sizeof(T));
-    int *ref;  ///< reference counter TODO alignment?
+    typedef typename RefCounterT::count_t count_t;
+    static const int offset = (sizeof(T) >= sizeof(count_t)) ? 1 : ((sizeof(count_t) + sizeof(T) - 1) / sizeof(T));
+    count_t *ref;  ///< reference counter TODO alignment?
     T *values; ///< array for values
 
     template <class T2, bool do_memory_op = std::numeric_limits<T2>::is_specialized>
     struct setup_t {
-      static void copy(Array2D_Dense<T2> &dest, const T2 *src){
+      static void copy(Array2D_Dense<T2, RefCounterT> &dest, const T2 *src){
         for(int i(dest.rows() * dest.columns() - 1); i >= 0; --i){
           dest.values[i] = src[i];
         }
       }
-      static void clear(Array2D_Dense<T2> &target){
+      static void clear(Array2D_Dense<T2, RefCounterT> &target){
         for(int i(target.rows() * target.columns() - 1); i >= 0; --i){
           target.values[i] = T2();
         }
@@ -254,10 +259,10 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
     };
     template <class T2>
     struct setup_t<T2, true> {
-      static void copy(Array2D_Dense<T2> &dest, const T2 *src){
+      static void copy(Array2D_Dense<T2, RefCounterT> &dest, const T2 *src){
         std::memcpy(dest.values, src, sizeof(T2) * dest.rows() * dest.columns());
       }
-      static void clear(Array2D_Dense<T2> &target){
+      static void clear(Array2D_Dense<T2, RefCounterT> &target){
         std::memset(target.values, 0, sizeof(T2) * target.rows() * target.columns());
       }
     };
@@ -276,7 +281,7 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
         const unsigned int &rows,
         const unsigned int &columns)
         : super_t(rows, columns),
-        ref(reinterpret_cast<int *>(new T[offset + (rows * columns)])),
+        ref(reinterpret_cast<count_t *>(new T[offset + (rows * columns)])),
         values(reinterpret_cast<T *>(ref) + offset) {
       *ref = 1;
     }
@@ -292,7 +297,7 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
         const unsigned int &columns,
         const T *serialized)
         : super_t(rows, columns),
-        ref(reinterpret_cast<int *>(new T[offset + (rows * columns)])),
+        ref(reinterpret_cast<count_t *>(new T[offset + (rows * columns)])),
         values(reinterpret_cast<T *>(ref) + offset) {
       *ref = 1;
       setup_t<T>::copy(*this, serialized);
@@ -305,7 +310,7 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
     Array2D_Dense(const self_t &array)
         : super_t(array.m_rows, array.m_columns),
           ref(array.ref), values(array.values){
-      if(ref){++(*ref);}
+      if(ref){RefCounterT::increment(*ref);}
     }
     /**
      * Constructor based on another type array, which performs deep copy.
@@ -315,7 +320,7 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
     template <class T2>
     Array2D_Dense(const Array2D_Frozen<T2> &array)
         : super_t(array.rows(), array.columns()),
-        ref(reinterpret_cast<int *>(new T[offset + (array.rows() * array.columns())])),
+        ref(reinterpret_cast<count_t *>(new T[offset + (array.rows() * array.columns())])),
         values(reinterpret_cast<T *>(ref) + offset) {
       *ref = 1;
       T *buf(values);
@@ -333,7 +338,7 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
      * allocated memory for elements will be deleted.
      */
     ~Array2D_Dense(){
-      if(ref && ((--(*ref)) <= 0)){
+      if(ref && RefCounterT::decrement(*ref)){
         delete [] reinterpret_cast<T *>(ref);
       }
     }
@@ -346,10 +351,10 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
      */
     self_t &operator=(const self_t &array){
       if(this != &array){
-        if(ref && ((--(*ref)) <= 0)){delete [] reinterpret_cast<T *>(ref);}
+        if(ref && RefCounterT::decrement(*ref)){delete [] reinterpret_cast<T *>(ref);}
         super_t::m_rows = array.m_rows;
         super_t::m_columns = array.m_columns;
-        if((ref = array.ref)){++(*ref);}
+        if((ref = array.ref)){RefCounterT::increment(*ref);}
         values = array.values;
       }
       return *this;
@@ -617,6 +622,16 @@ template <>
 struct MatrixValue_Special<double> {typedef double zero_t;};
 #endif
 
+/**
+ * Type to accumulate sums of T.
+ * It is extended to double for float in order not to lose small terms added to large sums,
+ * which enables mixed precision computation with single precision storage.
+ */
+template <class T>
+struct MatrixValue_Accumulator {typedef T res_t;};
+template <>
+struct MatrixValue_Accumulator<float> {typedef double res_t;};
+
 template <class BaseView = void>
 struct MatrixViewBase {
   typedef MatrixViewBase self_t;
@@ -41,6 +41,7 @@
 #include <cmath>
 #include <stdexcept>
 #include "param/matrix.h"
+#include "param/matrix_fixed.h"
 
 #include "param/vector3.h"
 
@@ -73,7 +74,7 @@ class QuaternionData : public QuaternionDataProperty<FloatT> {
     struct storage_t{
       FloatT scalar;  ///< XJ[vf
       Vector3<FloatT> vector; ///< xNgvf
-      int ref;  ///< QƃJE^
+      RefCounter_Default::count_t ref;  ///< QƃJE^
       storage_t() : ref(1) {}
       storage_t(const FloatT &q0, const Vector3<FloatT> &v)
           : scalar(q0), vector(v), ref(1) {}
@@ -130,7 +131,7 @@ class QuaternionData : public QuaternionDataProperty<FloatT> {
      * @param q Rs[
      */
     QuaternionData(const self_t &q){
-      if((storage = q.storage)){(storage->ref)++;}
+      if((storage = q.storage)){RefCounter_Default::increment(storage->ref);}
     }
     
     /**
@@ -142,8 +143,8 @@ class QuaternionData : public QuaternionDataProperty<FloatT> {
      */
     self_t &operator=(const self_t &q){
       if(this == &q){return *this;}
-      if(storage && ((--(storage->ref)) <= 0)){delete storage;}
-      if((storage = q.storage)){(storage->ref)++;}
+      if(storage && RefCounter_Default::decrement(storage->ref)){delete storage;}
+      if((storage = q.storage)){RefCounter_Default::increment(storage->ref);}
       return *this;
     }
     
@@ -166,7 +167,7 @@ class QuaternionData : public QuaternionDataProperty<FloatT> {
      * QƃJE^0̏ꍇAgpĂ܂B
      */
     ~QuaternionData(){
-      if(storage && ((--(storage->ref)) <= 0)){
+      if(storage && RefCounter_Default::decrement(storage->ref)){
         delete storage;
       }
     }
@@ -558,6 +559,67 @@ class Quaternion : public QuaternionData_TypeMapper<FloatT>::res_t {
      * @see operator*=(const Vector3<FloatT> &)
      */
     self_t operator*(const Vector3<FloatT> &v) const{return copy() *= v;}
+
+    /**
+     * Allocation-free kernels working on plain arrays, whose element order is
+     * {scalar, vector[0], vector[1], vector[2]}.
+     * They perform the same arithmetic in the same order as the corresponding operators,
+     * therefore their results are identical to the operators' ones.
+     * The output array is allowed to be the same as the input.
+     */
+
+    /**
+     * Product of quaternions, @f$ \Tilde{q}_{a} \Tilde{q}_{b} @f$
+     * @see operator*(const self_t &) const
+     */
+    static void product(
+        const FloatT (&q_a)[4], const FloatT (&q_b)[4], FloatT (&res)[4]) noexcept {
+      FloatT
+          s((q_a[0] * q_b[0]) - (((q_a[1] * q_b[1]) + (q_a[2] * q_b[2])) + (q_a[3] * q_b[3]))),
+          v0((q_b[1] * q_a[0]) + ((q_a[1] * q_b[0]) + (q_a[2] * q_b[3] - q_a[3] * q_b[2]))),
+          v1((q_b[2] * q_a[0]) + ((q_a[2] * q_b[0]) + (q_a[3] * q_b[1] - q_a[1] * q_b[3]))),
+          v2((q_b[3] * q_a[0]) + ((q_a[3] * q_b[0]) + (q_a[1] * q_b[2] - q_a[2] * q_b[1])));
+      res[0] = s; res[1] = v0; res[2] = v1; res[3] = v2;
+    }
+
+    /**
+     * Product of a quaternion and a vector, @f$ \Tilde{q} \vec{v} @f$
+     * @see operator*(const Vector3<FloatT> &) const
+     */
+    static void product(
+        const FloatT (&q)[4], const FloatT (&v)[3], FloatT (&res)[4]) noexcept {
+      FloatT
+          s(-(((q[1] * v[0]) + (q[2] * v[1])) + (q[3] * v[2]))),
+          v0((q[2] * v[2] - q[3] * v[1]) + (v[0] * q[0])),
+          v1((q[3] * v[0] - q[1] * v[2]) + (v[1] * q[0])),
+          v2((q[1] * v[1] - q[2] * v[0]) + (v[2] * q[0]));
+      res[0] = s; res[1] = v0; res[2] = v1; res[3] = v2;
+    }
+
+    /**
+     * Normalization in place
+     * @see regularize() const
+     */
+    static void regularize(FloatT (&q)[4]) {
+      FloatT k(FloatT(1) / std::sqrt(
+          (q[0] * q[0]) + (((q[1] * q[1]) + (q[2] * q[2])) + (q[3] * q[3]))));
+      for(unsigned int i(0); i < 4; i++){q[i] *= k;}
+    }
+
+    /**
+     * Copy elements to a plain array
+     */
+    void get(FloatT (&res)[4]) const noexcept {
+      for(unsigned int i(0); i < OUT_OF_INDEX; i++){res[i] = (*this)[i];}
+    }
+
+    /**
+     * Copy elements from a plain array
+     */
+    self_t &set(const FloatT (&values)[4]) noexcept {
+      for(unsigned int i(0); i < OUT_OF_INDEX; i++){(*this)[i] = values[i];}
+      return *this;
+    }
     
     /**
      * ]p̔߂܂B
@@ -595,11 +657,15 @@ class Quaternion : public QuaternionData_TypeMapper<FloatT>::res_t {
     /**
      * @f$ 3 \times 3 @f$ Direction Cosine Matrix(DCM)ɕϊ܂B
      * 
-     * @return (Matrix<FloatT>) DCM
+     * @return (Matrix_Fixed<FloatT, 3>) DCM, whose buffer is not allocated on heap
      */
-    Matrix<FloatT> getDCM() const{
-      self_t r = regularize();
-      Matrix<FloatT> dcm = Matrix<FloatT>(3, 3);
+    Matrix_Fixed<FloatT, 3> getDCM() const{
+      FloatT r[OUT_OF_INDEX];
+      {
+        FloatT k(FloatT(1) / abs()); // same as regularize() without a temporary
+        for(unsigned int i(0); i < OUT_OF_INDEX; i++){r[i] = (*this)[i] * k;}
+      }
+      Matrix_Fixed<FloatT, 3> dcm;
       {
         //dcm(0, 0) = pow2(r[0]) + pow2(r[1]) - pow2(r[2]) - pow2(r[3]);
         dcm(0, 0) = FloatT(1) - (pow2(r[2]) + pow2(r[3])) * 2;
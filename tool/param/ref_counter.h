@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __REF_COUNTER_H__
+#define __REF_COUNTER_H__
+
+/** @file
+ * @brief Reference counter policies for storages shared by shallow copies
+ *
+ * Matrix (Array2D_Dense), Vector3Data, and QuaternionData share their storage
+ * among shallow copies, whose lifetime is managed by a reference counter.
+ * - RefCounter_ThreadConfined uses a plain counter. A storage and all of its shallow copies
+ *   must be confined to a single thread. To pass an object to another thread,
+ *   make a deep copy (for example, Matrix::copy()) and hand its ownership over to the receiver
+ *   without keeping any shallow copy in the sender.
+ * - RefCounter_Atomic updates the counter with atomic operations, therefore shallow copies
+ *   can be made and released in different threads. Please note that the contents
+ *   of the shared storage are still not protected.
+ *
+ * RefCounter_Default, which is used by default, is RefCounter_Atomic when atomic operations
+ * are available, unless REF_COUNTER_THREAD_CONFINED is defined as non-zero.
+ */
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+struct RefCounter_ThreadConfined {
+  typedef int count_t;
+  static const bool thread_safe = false;
+  static void increment(count_t &ref){++ref;}
+  /**
+   * @return (bool) true when the counter reaches zero, i.e., the storage should be released.
+   */
+  static bool decrement(count_t &ref){return (--ref) <= 0;}
+  static count_t get(const count_t &ref){return ref;}
+};
+
+#if defined(__GNUC__) && (((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)) || (__GNUC__ > 4))
+#define REF_COUNTER_ATOMIC_AVAILABLE 1
+struct RefCounter_Atomic { // GCC atomic builtins, which are also available for C++98
+  typedef int count_t;
+  static const bool thread_safe = true;
+  static void increment(count_t &ref){__atomic_add_fetch(&ref, 1, __ATOMIC_RELAXED);}
+  static bool decrement(count_t &ref){
+    // acquire-release to make previous accesses from other threads visible to the releaser
+    return __atomic_sub_fetch(&ref, 1, __ATOMIC_ACQ_REL) <= 0;
+  }
+  static count_t get(const count_t &ref){return __atomic_load_n(&ref, __ATOMIC_ACQUIRE);}
+};
+#elif defined(_MSC_VER)
+#define REF_COUNTER_ATOMIC_AVAILABLE 1
+struct RefCounter_Atomic {
+  typedef long count_t;
+  static const bool thread_safe = true;
+  static void increment(count_t &ref){_InterlockedIncrement(&ref);}
+  static bool decrement(count_t &ref){return _InterlockedDecrement(&ref) <= 0;}
+  static count_t get(const count_t &ref){return _InterlockedCompareExchange(const_cast<count_t *>(&ref), 0, 0);}
+};
+#endif
+
+#if defined(REF_COUNTER_ATOMIC_AVAILABLE) \
+    && !(defined(REF_COUNTER_THREAD_CONFINED) && REF_COUNTER_THREAD_CONFINED)
+typedef RefCounter_Atomic RefCounter_Default;
+#else
+typedef RefCounter_ThreadConfined RefCounter_Default;
+#endif
+
+#endif /* __REF_COUNTER_H__ */
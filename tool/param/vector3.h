@@ -79,7 +79,7 @@ class Vector3Data : public Vector3DataProperty<FloatT> {
   private:
     struct storage_t{
       FloatT values[property_t::OUT_OF_INDEX];  ///<vfۑp
-      int ref;                      ///<QƃJE^
+      RefCounter_Default::count_t ref;          ///<QƃJE^
       storage_t() : ref(1) {}
       storage_t(const FloatT &x, const FloatT &y, const FloatT &z)
           : ref(1) {
@@ -133,7 +133,7 @@ class Vector3Data : public Vector3DataProperty<FloatT> {
      * @param v Rs[
      */
     Vector3Data(const self_t &v){
-      if((storage = v.storage)){(storage->ref)++;}
+      if((storage = v.storage)){RefCounter_Default::increment(storage->ref);}
     }
     
     /**
@@ -145,8 +145,8 @@ class Vector3Data : public Vector3DataProperty<FloatT> {
      */
     self_t &operator=(const self_t &v){
       if(this == &v){return *this;}
-      if(storage && ((--(storage->ref)) <= 0)){delete storage;}
-      if((storage = v.storage)){(storage->ref)++;}
+      if(storage && RefCounter_Default::decrement(storage->ref)){delete storage;}
+      if((storage = v.storage)){RefCounter_Default::increment(storage->ref);}
       return *this;
     }
     
@@ -166,7 +166,7 @@ class Vector3Data : public Vector3DataProperty<FloatT> {
      * QƃJE^0̏ꍇAgpĂ܂B
      */
     ~Vector3Data(){
-      if(storage && ((--(storage->ref)) <= 0)){
+      if(storage && RefCounter_Default::decrement(storage->ref)){
         delete storage;
       }
     }
@@ -470,6 +470,34 @@ class Vector3 : public Vector3Data_TypeMapper<FloatT>::res_t {
       result[2] = (*this)[0] * v[1] - (*this)[1] * v[0];
       return result;
     }
+
+    /**
+     * Allocation-free outer product on plain arrays, which gives the identical result
+     * to operator*(const self_t &) const. The output array is allowed to be the same as the input.
+     */
+    static void cross(
+        const FloatT (&a)[3], const FloatT (&b)[3], FloatT (&res)[3]) noexcept {
+      FloatT
+          v0(a[1] * b[2] - a[2] * b[1]),
+          v1(a[2] * b[0] - a[0] * b[2]),
+          v2(a[0] * b[1] - a[1] * b[0]);
+      res[0] = v0; res[1] = v1; res[2] = v2;
+    }
+
+    /**
+     * Copy elements to a plain array
+     */
+    void get(FloatT (&res)[3]) const noexcept {
+      for(unsigned int i(0); i < OUT_OF_INDEX; i++){res[i] = (*this)[i];}
+    }
+
+    /**
+     * Copy elements from a plain array
+     */
+    self_t &set(const FloatT (&values)[3]) noexcept {
+      for(unsigned int i(0); i < OUT_OF_INDEX; i++){(*this)[i] = values[i];}
+      return *this;
+    }
     
     /**
      * ς܂B
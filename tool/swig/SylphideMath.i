@@ -9,6 +9,7 @@
 
 %{
 #include <string>
+#include <cstring>
 #include <sstream>
 #include <vector>
 #include <exception>
@@ -25,6 +26,14 @@
 #undef isfinite_
 #define isfinite(x) finite(x)
 #endif
+
+#if defined(SWIGRUBY)
+#include <ruby/version.h>
+#if RUBY_API_VERSION_CODE >= 20000
+#include <ruby/thread.h>
+#define MATRIX_UTIL_WITHOUT_GVL
+#endif
+#endif
 %}
 
 %include std_common.i
@@ -603,7 +612,18 @@ struct MatrixUtil {
     const VALUE *value(static_cast<const VALUE *>(src));
     unsigned int i(0), j(0), i_elm(0);
     VALUE v_elm;
-    if(value && RB_TYPE_P(*value, T_ARRAY)){
+    if(value && RB_TYPE_P(*value, T_STRING)){ // packed [r0c0, r0c1, ...], ex) Array#pack("d*")
+      if((std::size_t)RSTRING_LEN(*value) < (sizeof(T) * len)){
+        throw std::invalid_argument("Length is too short");
+      }
+      const char *buf(RSTRING_PTR(*value));
+      for(; i < r; ++i){
+        for(j = 0; j < c; ++j, buf += sizeof(T)){
+          std::memcpy(&dst(i, j), buf, sizeof(T));
+        }
+      }
+      return true;
+    }else if(value && RB_TYPE_P(*value, T_ARRAY)){
       if(RB_TYPE_P(RARRAY_AREF(*value, 0), T_ARRAY)){ // [[r0c0, r0c1, ...], ...]
         if((unsigned int)RARRAY_LEN(*value) < r){
           throw std::invalid_argument("Length is too short");
@@ -668,7 +688,182 @@ struct MatrixUtil {
     }
     return true;
   }
+
+  /**
+   * Task run without Ruby's GVL, which makes other Ruby threads runnable
+   * during heavy linear algebra. run() must not touch any Ruby object,
+   * and must use only matrices unlinked to the others (deep copies),
+   * because the reference counter of Array2D_Dense is not thread-safe.
+   * An exception thrown in run() is re-thrown by invoke() with the GVL.
+   */
+  struct gvl_free_task_t {
+    enum {
+      THROWN_NOTHING,
+      THROWN_INVALID_ARGUMENT,
+      THROWN_OUT_OF_RANGE,
+      THROWN_LOGIC_ERROR,
+      THROWN_RUNTIME_ERROR,
+    } thrown;
+    std::string message;
+    gvl_free_task_t() : thrown(THROWN_NOTHING), message() {}
+    virtual ~gvl_free_task_t(){}
+    virtual void run() = 0;
+    static void *run_no_throw(void *task_p){
+      gvl_free_task_t *task(static_cast<gvl_free_task_t *>(task_p));
+      try{
+        task->run();
+      }catch(const std::invalid_argument &e){
+        task->thrown = THROWN_INVALID_ARGUMENT;
+        task->message = e.what();
+      }catch(const std::out_of_range &e){
+        task->thrown = THROWN_OUT_OF_RANGE;
+        task->message = e.what();
+      }catch(const std::logic_error &e){
+        task->thrown = THROWN_LOGIC_ERROR;
+        task->message = e.what();
+      }catch(const std::exception &e){
+        task->thrown = THROWN_RUNTIME_ERROR;
+        task->message = e.what();
+      }
+      return NULL;
+    }
+    /**
+     * Only used when gvl_releasable() is true; otherwise, the operation is performed
+     * directly on the operands without deep copies.
+     */
+    void invoke(){
+#if defined(MATRIX_UTIL_WITHOUT_GVL)
+      rb_thread_call_without_gvl(run_no_throw, this, NULL, NULL);
+#else
+      run_no_throw(this);
+#endif
+      switch(thrown){
+        case THROWN_INVALID_ARGUMENT: throw std::invalid_argument(message);
+        case THROWN_OUT_OF_RANGE: throw std::out_of_range(message);
+        case THROWN_LOGIC_ERROR: throw std::logic_error(message);
+        case THROWN_RUNTIME_ERROR: throw std::runtime_error(message);
+        default: break;
+      }
+    }
+  };
+  static unsigned int gvl_release_size; ///< GVL is released when rows or columns >= this value
+  template <class T, class Array2D_Type, class ViewType>
+  static bool gvl_releasable(const Matrix_Frozen<T, Array2D_Type, ViewType> &mat){
+#if defined(MATRIX_UTIL_WITHOUT_GVL)
+    return (mat.rows() >= gvl_release_size) || (mat.columns() >= gvl_release_size);
+#else
+    return false;
+#endif
+  }
+
+  template <class T, class Array2D_Type, class ViewType>
+  static Matrix<T, Array2D_Dense<T> > inverse(
+      const Matrix_Frozen<T, Array2D_Type, ViewType> &src){
+    typedef Matrix<T, Array2D_Dense<T> > mat_t;
+    if(!gvl_releasable(src)){return (mat_t)(src.inverse());}
+    struct task_t : public gvl_free_task_t {
+      mat_t src, res;
+      task_t(const mat_t &src_) : gvl_free_task_t(), src(src_), res() {}
+      void run(){res = (mat_t)(src.inverse());}
+    } task(src.operator mat_t());
+    task.invoke();
+    return task.res;
+  }
+  template <class T, class Array2D_Type, class ViewType,
+      class T2, class Array2D_Type2, class ViewType2>
+  static Matrix<T, Array2D_Dense<T> > multiply(
+      const Matrix_Frozen<T, Array2D_Type, ViewType> &lhs,
+      const Matrix_Frozen<T2, Array2D_Type2, ViewType2> &rhs){
+    typedef Matrix<T, Array2D_Dense<T> > mat_t;
+    typedef Matrix<T2, Array2D_Dense<T2> > mat2_t;
+    if(!(gvl_releasable(lhs) || gvl_releasable(rhs))){return (mat_t)(lhs * rhs);}
+    struct task_t : public gvl_free_task_t {
+      mat_t lhs, res;
+      mat2_t rhs;
+      task_t(const mat_t &lhs_, const mat2_t &rhs_)
+          : gvl_free_task_t(), lhs(lhs_), res(), rhs(rhs_) {}
+      void run(){res = (mat_t)(lhs * rhs);}
+    } task(lhs.operator mat_t(), rhs.operator mat2_t());
+    task.invoke();
+    return task.res;
+  }
+  template <class T, class Array2D_Type, class ViewType,
+      class T2, class Array2D_Type2, class ViewType2>
+  static Matrix<T, Array2D_Dense<T> > divide(
+      const Matrix_Frozen<T, Array2D_Type, ViewType> &lhs,
+      const Matrix_Frozen<T2, Array2D_Type2, ViewType2> &rhs){
+    typedef Matrix<T, Array2D_Dense<T> > mat_t;
+    typedef Matrix<T2, Array2D_Dense<T2> > mat2_t;
+    if(!(gvl_releasable(lhs) || gvl_releasable(rhs))){return (mat_t)(lhs / rhs);}
+    struct task_t : public gvl_free_task_t {
+      mat_t lhs, res;
+      mat2_t rhs;
+      task_t(const mat_t &lhs_, const mat2_t &rhs_)
+          : gvl_free_task_t(), lhs(lhs_), res(), rhs(rhs_) {}
+      void run(){res = (mat_t)(lhs / rhs);}
+    } task(lhs.operator mat_t(), rhs.operator mat2_t());
+    task.invoke();
+    return task.res;
+  }
+  template <class T, class Array2D_Type, class ViewType>
+  static Matrix<T, Array2D_Dense<T> > decomposeLUP(
+      const Matrix_Frozen<T, Array2D_Type, ViewType> &src,
+      unsigned int &pivot_num, unsigned int *pivot){
+    typedef Matrix<T, Array2D_Dense<T> > mat_t;
+    if(!gvl_releasable(src)){return (mat_t)(src.decomposeLUP(pivot_num, pivot));}
+    struct task_t : public gvl_free_task_t {
+      mat_t src, res;
+      unsigned int &pivot_num;
+      unsigned int *pivot;
+      task_t(const mat_t &src_, unsigned int &pivot_num_, unsigned int *pivot_)
+          : gvl_free_task_t(), src(src_), res(), pivot_num(pivot_num_), pivot(pivot_) {}
+      void run(){res = (mat_t)(src.decomposeLUP(pivot_num, pivot));}
+    } task(src.operator mat_t(), pivot_num, pivot);
+    task.invoke();
+    return task.res;
+  }
+  template <class T, class Array2D_Type, class ViewType>
+  static Matrix<T, Array2D_Dense<T> > decomposeUD(
+      const Matrix_Frozen<T, Array2D_Type, ViewType> &src){
+    typedef Matrix<T, Array2D_Dense<T> > mat_t;
+    if(!gvl_releasable(src)){return (mat_t)(src.decomposeUD());}
+    struct task_t : public gvl_free_task_t {
+      mat_t src, res;
+      task_t(const mat_t &src_) : gvl_free_task_t(), src(src_), res() {}
+      void run(){res = (mat_t)(src.decomposeUD());}
+    } task(src.operator mat_t());
+    task.invoke();
+    return task.res;
+  }
+  template <class T, class Array2D_Type, class ViewType>
+  static Matrix<T, Array2D_Dense<T> > decomposeQR(
+      const Matrix_Frozen<T, Array2D_Type, ViewType> &src){
+    typedef Matrix<T, Array2D_Dense<T> > mat_t;
+    if(!gvl_releasable(src)){return (mat_t)(src.decomposeQR());}
+    struct task_t : public gvl_free_task_t {
+      mat_t src, res;
+      task_t(const mat_t &src_) : gvl_free_task_t(), src(src_), res() {}
+      void run(){res = (mat_t)(src.decomposeQR());}
+    } task(src.operator mat_t());
+    task.invoke();
+    return task.res;
+  }
+  template <class ResultT, class T, class Array2D_Type, class ViewType>
+  static ResultT eigen(
+      const Matrix_Frozen<T, Array2D_Type, ViewType> &src){
+    if(!gvl_releasable(src)){return (ResultT)(src.eigen());}
+    typedef Matrix<T, Array2D_Dense<T> > mat_t;
+    struct task_t : public gvl_free_task_t {
+      mat_t src;
+      ResultT res;
+      task_t(const mat_t &src_) : gvl_free_task_t(), src(src_), res() {}
+      void run(){res = (ResultT)(src.eigen());}
+    } task(src.operator mat_t());
+    task.invoke();
+    return task.res;
+  }
 };
+unsigned int MatrixUtil::gvl_release_size(0x20);
 %}
 
 %extend Matrix_Frozen {
@@ -754,7 +949,7 @@ struct MatrixUtil {
   Matrix<T, Array2D_Dense<T> > operator*(
       const Matrix_Frozen<T2, Array2D_Type2, ViewType2> &matrix)
       const throw(std::invalid_argument) {
-    return (Matrix<T, Array2D_Dense<T> >)(($self)->operator*(matrix));
+    return MatrixUtil::multiply(*$self, matrix);
   }
   INSTANTIATE_MATRIX_FUNC(operator*, __mul__);
   
@@ -809,7 +1004,7 @@ struct MatrixUtil {
         return res;
       }
     } buf($self->rows());
-    Matrix<T, Array2D_Dense<T> > LU($self->decomposeLUP(buf.pivot_num, buf.pivot));
+    Matrix<T, Array2D_Dense<T> > LU(MatrixUtil::decomposeLUP(*$self, buf.pivot_num, buf.pivot));
     output_L = LU.partial($self->rows(), $self->columns()).copy();
     output_U = LU.partial($self->rows(), $self->columns(), 0, $self->rows()).copy();
     output_P = buf.P();
@@ -818,27 +1013,28 @@ struct MatrixUtil {
   void ud(
       Matrix<T, Array2D_Dense<T> > &output_U, 
       Matrix<T, Array2D_Dense<T> > &output_D) const {
-    Matrix<T, Array2D_Dense<T> > UD($self->decomposeUD());
+    Matrix<T, Array2D_Dense<T> > UD(MatrixUtil::decomposeUD(*$self));
     output_U = UD.partial($self->rows(), $self->columns()).copy();
     output_D = UD.partial($self->rows(), $self->columns(), 0, $self->rows()).copy();
   }
+  %catches(std::logic_error, std::runtime_error) qr;
   void qr(
       Matrix<T, Array2D_Dense<T> > &output_Q, 
       Matrix<T, Array2D_Dense<T> > &output_R) const {
-    Matrix<T, Array2D_Dense<T> > QR($self->decomposeQR());
+    Matrix<T, Array2D_Dense<T> > QR(MatrixUtil::decomposeQR(*$self));
     output_Q = QR.partial($self->rows(), $self->rows()).copy();
     output_R = QR.partial($self->rows(), $self->columns(), 0, $self->rows()).copy();
   }
 
   %catches(std::logic_error, std::runtime_error) inverse;
   Matrix<T, Array2D_Dense<T> > inverse() const {
-    return (Matrix<T, Array2D_Dense<T> >)(($self)->inverse());
+    return MatrixUtil::inverse(*$self);
   }
   template <class T2, class Array2D_Type2, class ViewType2>
   Matrix<T, Array2D_Dense<T> > operator/(
       const Matrix_Frozen<T2, Array2D_Type2, ViewType2> &matrix)
       const throw(std::logic_error, std::runtime_error) {
-    return (Matrix<T, Array2D_Dense<T> >)(($self)->operator/(matrix));
+    return MatrixUtil::divide(*$self, matrix);
   }
   INSTANTIATE_MATRIX_FUNC(operator/, __div__);
   
@@ -1019,6 +1215,19 @@ struct MatrixUtil {
     }
     return res;
   }
+  
+  SWIG_Object pack() const {
+    unsigned int i_max($self->rows()), j_max($self->columns());
+    SWIG_Object res = rb_str_new(NULL, sizeof(T) * i_max * j_max);
+    char *buf(RSTRING_PTR(res));
+    for(unsigned int i(0); i < i_max; ++i){
+      for(unsigned int j(0); j < j_max; ++j, buf += sizeof(T)){
+        T v((*($self))(i, j));
+        std::memcpy(buf, &v, sizeof(T));
+      }
+    }
+    return res;
+  }
 #endif
 };
 
@@ -1243,7 +1452,7 @@ MAKE_TO_S(Matrix_Frozen)
       Matrix<ctype, Array2D_Dense<ctype > > &output_V, 
       Matrix<ctype, Array2D_Dense<ctype > > &output_D) const {
     typedef Matrix<ctype, Array2D_Dense<ctype > > cmat_t;
-    cmat_t VD($self->eigen());
+    cmat_t VD(MatrixUtil::eigen<cmat_t>(*$self));
     output_V = VD.partial($self->rows(), $self->rows()).copy();
     cmat_t D($self->rows(), $self->rows());
     for(unsigned int i(0); i < $self->rows(); ++i){
@@ -1411,6 +1620,17 @@ double get_tolerance(){
 }
 %}
 
+%rename("gvl_release_size=") set_gvl_release_size;
+%rename("gvl_release_size") get_gvl_release_size;
+%inline %{
+unsigned int set_gvl_release_size(const unsigned int &size){
+  return (MatrixUtil::gvl_release_size = size);
+}
+unsigned int get_gvl_release_size(){
+  return MatrixUtil::gvl_release_size;
+}
+%}
+
 #undef INSTANTIATE_MATRIX_FUNC
 #undef INSTANTIATE_MATRIX_TRANSPOSE
 #undef INSTANTIATE_MATRIX_PARTIAL
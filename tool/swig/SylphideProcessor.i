@@ -265,6 +265,21 @@ struct G_health_utc_iono_t {
 %}
 %extend G_Packet_Observer{
   %ignore packet_type;
+  %ignore message;
+  %ignore decode_ITOW_ms;
+  %ignore decode_position;
+  %ignore decode_position_hp;
+  %ignore decode_position_acc;
+  %ignore decode_position_acc_hp;
+  %ignore decode_velocity;
+  %ignore decode_velocity_acc;
+  %ignore decode_status;
+  %ignore decode_svinfo;
+  %ignore decode_solution;
+  %ignore decode_utc;
+  %ignore decode_raw;
+  %ignore decode_subframe;
+  %ignore decode_health_utc_iono;
   %ignore fetch_position;
   %ignore fetch_position_hp;
   %ignore fetch_position_acc;
@@ -293,6 +308,375 @@ struct N_navdata_t {
   %ignore fetch_navdata;
 }
 
+%{
+#include <fstream>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <cstdio>
+
+/**
+ * Whole-file loader, which parses pages and UBX messages in C++,
+ * and stores their fields in column-oriented tables.
+ * A column is a packed array of double in native byte order,
+ * i.e., String#unpack("d*") in Ruby, having one or more values per record.
+ */
+template <class FloatType>
+struct SylphideLogLoader : public AbstractSylphideProcessor<FloatType> {
+  typedef AbstractSylphideProcessor<FloatType> super_t;
+  
+  struct table_t {
+    std::string name;
+    unsigned int records;
+    std::vector<std::string> column_names, columns;
+    unsigned int cursor;
+    table_t(const std::string &name_ = std::string())
+        : name(name_), records(0), column_names(), columns(), cursor(0) {}
+    table_t &begin(){
+      cursor = 0;
+      return *this;
+    }
+    template <class T>
+    table_t &add(const char *column_name, const T *values, const unsigned int &n = 1){
+      if(cursor >= columns.size()){ // columns are defined by the first record
+        column_names.push_back(column_name);
+        columns.push_back(std::string());
+      }
+      std::string &column(columns[cursor++]);
+      for(unsigned int i(0); i < n; ++i){
+        double v(values[i]);
+        column.append(reinterpret_cast<const char *>(&v), sizeof(v));
+      }
+      return *this;
+    }
+    template <class T>
+    table_t &add(const char *column_name, const T &value){
+      return add(column_name, &value, 1);
+    }
+    void end(){++records;}
+    void clear(){
+      records = 0;
+      for(std::vector<std::string>::iterator it(columns.begin()); it != columns.end(); ++it){
+        it->clear();
+      }
+    }
+  };
+  
+  unsigned int batch; ///< when positive, flush() is called every batch records of a table
+  bool page_selected[0x100];
+  std::vector<bool> ubx_selected; ///< indexed by (class << 8 | id), empty for all
+  table_t table_A, table_F, table_P, table_M, table_N;
+  typedef std::map<unsigned int, table_t> table_G_t;
+  table_G_t table_G;
+  unsigned int bad_packets;
+  bool stop;
+  
+  typedef A_Packet_Observer<FloatType> A_Observer_t;
+  typedef F_Packet_Observer<FloatType> F_Observer_t;
+  typedef P_Packet_Observer<FloatType> P_Observer_t;
+  typedef M_Packet_Observer<FloatType> M_Observer_t;
+  typedef N_Packet_Observer<FloatType> N_Observer_t;
+  typedef G_Packet_Observer<FloatType> G_Observer_t;
+  
+  /**
+   * @param filter comma separated page types, and UBX messages in format of G:class[:id],
+   * for example, "A,N,G:0x01:0x02,G:0x02". Empty means all.
+   */
+  SylphideLogLoader(const std::string &filter = std::string(), const unsigned int &batch_ = 0,
+      const unsigned int &buffer_size = SYLPHIDE_PAGE_SIZE * 32)
+      : super_t(), batch(batch_), ubx_selected(),
+      table_A("A"), table_F("F"), table_P("P"), table_M("M"), table_N("N"), table_G(),
+      bad_packets(0), stop(false),
+      observer_A(buffer_size), observer_F(buffer_size), observer_P(buffer_size),
+      observer_M(buffer_size), observer_N(buffer_size), observer_G(buffer_size) {
+    for(int i(0); i < 0x100; ++i){page_selected[i] = filter.empty();}
+    const char *spec(filter.c_str());
+    while(*spec != '\0'){
+      unsigned char page(*(spec++));
+      page_selected[page] = true;
+      if((page == 'G') && (*spec == ':')){
+        char *spec_end;
+        long klass(std::strtol(++spec, &spec_end, 0)), id_min(0), id_max(0xFF);
+        if((spec_end == spec) || (klass < 0) || (klass > 0xFF)){
+          throw std::invalid_argument(std::string("Invalid filter: ").append(filter));
+        }
+        spec = spec_end;
+        if(*spec == ':'){
+          id_min = id_max = std::strtol(++spec, &spec_end, 0);
+          if((spec_end == spec) || (id_min < 0) || (id_min > 0xFF)){
+            throw std::invalid_argument(std::string("Invalid filter: ").append(filter));
+          }
+          spec = spec_end;
+        }
+        if(ubx_selected.empty()){ubx_selected.assign(0x10000, false);}
+        for(long id(id_min); id <= id_max; ++id){
+          ubx_selected[(klass << 8) | id] = true;
+        }
+      }
+      if(*spec == ','){
+        ++spec;
+      }else if(*spec != '\0'){
+        throw std::invalid_argument(std::string("Invalid filter: ").append(filter));
+      }
+    }
+  }
+  virtual ~SylphideLogLoader(){}
+  
+  /**
+   * Called when a table is filled with batch records, and at the end of loading
+   * when batch is positive. The table should be cleared in the function.
+   */
+  virtual void flush(table_t &table){}
+  
+  void end_record(table_t &table){
+    table.end();
+    if((batch > 0) && (table.records >= batch)){flush(table);}
+  }
+  
+  struct handler_t {
+    SylphideLogLoader &loader;
+    void operator()(const A_Observer_t &obs){
+      typename A_Observer_t::values_t values(obs.fetch_values());
+      loader.table_A.begin()
+          .add("itow", obs.fetch_ITOW())
+          .add("values", values.values, 8)
+          .add("temperature", values.temperature);
+      loader.end_record(loader.table_A);
+    }
+    void operator()(const F_Observer_t &obs){
+      typename F_Observer_t::values_t values(obs.fetch_values());
+      loader.table_F.begin()
+          .add("itow", obs.fetch_ITOW())
+          .add("servo_in", values.servo_in, 8)
+          .add("servo_out", values.servo_out, 8);
+      loader.end_record(loader.table_F);
+    }
+    void operator()(const P_Observer_t &obs){
+      typename P_Observer_t::values_t values(obs.fetch_values());
+      loader.table_P.begin()
+          .add("itow", obs.fetch_ITOW())
+          .add("air_speed", values.air_speed, 4)
+          .add("air_alpha", values.air_alpha, 4)
+          .add("air_beta", values.air_beta, 4);
+      loader.end_record(loader.table_P);
+    }
+    void operator()(const M_Observer_t &obs){
+      typename M_Observer_t::values_t values(obs.fetch_values());
+      loader.table_M.begin()
+          .add("itow", obs.fetch_ITOW())
+          .add("x", values.x, 4)
+          .add("y", values.y, 4)
+          .add("z", values.z, 4);
+      loader.end_record(loader.table_M);
+    }
+    void operator()(const N_Observer_t &obs){
+      typename N_Observer_t::navdata_t nav(obs.fetch_navdata());
+      loader.table_N.begin()
+          .add("itow", nav.itow)
+          .add("latitude", nav.latitude).add("longitude", nav.longitude).add("altitude", nav.altitude)
+          .add("v_north", nav.v_north).add("v_east", nav.v_east).add("v_down", nav.v_down)
+          .add("heading", nav.heading).add("pitch", nav.pitch).add("roll", nav.roll);
+      loader.end_record(loader.table_N);
+    }
+    void operator()(const G_Observer_t &obs){
+      if(!obs.validate()){
+        loader.bad_packets++;
+        return;
+      }
+      typename G_Observer_t::packet_type_t packet_type(obs.packet_type());
+      unsigned int key(((unsigned int)packet_type.mclass << 8) | packet_type.mid);
+      if((!loader.ubx_selected.empty()) && (!loader.ubx_selected[key])){return;}
+      typename table_G_t::iterator it(loader.table_G.find(key));
+      if(it == loader.table_G.end()){
+        char name[16];
+        std::sprintf(name, "G:0x%02X:0x%02X", packet_type.mclass, packet_type.mid);
+        it = loader.table_G.insert(std::make_pair(key, table_t(name))).first;
+      }
+      table_t &table(it->second);
+      table.begin().add("size", obs.current_packet_size());
+      switch(packet_type.mclass){
+        case 0x01: // NAV
+        case 0x02: // RXM
+          table.add("itow", obs.fetch_ITOW());
+          break;
+      }
+      switch(key){
+        case 0x0102: { // NAV-POSLLH
+          typename G_Observer_t::position_t pos(obs.fetch_position());
+          typename G_Observer_t::position_acc_t acc(obs.fetch_position_acc());
+          table.add("longitude", pos.longitude).add("latitude", pos.latitude).add("altitude", pos.altitude)
+              .add("horizontal_acc", acc.horizontal).add("vertical_acc", acc.vertical);
+          break;
+        }
+        case 0x0103: { // NAV-STATUS
+          typename G_Observer_t::status_t status(obs.fetch_status());
+          table.add("fix_type", status.fix_type).add("status_flags", status.status_flags)
+              .add("differential", status.differential)
+              .add("time_to_first_fix_ms", status.time_to_first_fix_ms)
+              .add("time_to_reset_ms", status.time_to_reset_ms);
+          break;
+        }
+        case 0x0106: { // NAV-SOL
+          typename G_Observer_t::solution_t sol(obs.fetch_solution());
+          table.add("week", sol.week).add("fix_type", sol.fix_type).add("status_flags", sol.status_flags)
+              .add("position_ecef_cm", sol.position_ecef_cm, 3)
+              .add("position_ecef_acc_cm", sol.position_ecef_acc_cm)
+              .add("velocity_ecef_cm_s", sol.velocity_ecef_cm_s, 3)
+              .add("velocity_ecef_acc_cm_s", sol.velocity_ecef_acc_cm_s)
+              .add("satellites_used", sol.satellites_used);
+          break;
+        }
+        case 0x0112: { // NAV-VELNED
+          typename G_Observer_t::velocity_t vel(obs.fetch_velocity());
+          typename G_Observer_t::velocity_acc_t acc(obs.fetch_velocity_acc());
+          table.add("v_north", vel.north).add("v_east", vel.east).add("v_down", vel.down)
+              .add("velocity_acc", acc.acc);
+          break;
+        }
+      }
+      loader.end_record(table);
+    }
+  };
+  
+  A_Observer_t observer_A;
+  F_Observer_t observer_F;
+  P_Observer_t observer_P;
+  M_Observer_t observer_M;
+  N_Observer_t observer_N;
+  G_Observer_t observer_G;
+  bool previous_seek_next[0x100];
+  
+  /**
+   * Load a file
+   * 
+   * @return (bool) false when the file cannot be opened
+   */
+  bool load(const std::string &fname){
+    std::ifstream in(fname.c_str(), std::ios::in | std::ios::binary);
+    if(!in){return false;}
+    static const int page_size(SYLPHIDE_PAGE_SIZE);
+    std::vector<char> buf(page_size * 0x400); // 32KB, kept off the stack
+    handler_t handler = {*this};
+    for(int i(0); i < 0x100; ++i){previous_seek_next[i] = false;}
+    while((!stop) && in){
+      in.read(&buf[0], buf.size());
+      for(char *page(&buf[0]), *page_end(page + (in.gcount() / page_size) * page_size);
+          (!stop) && (page < page_end); page += page_size){
+        unsigned char page_type(*page);
+        if(!page_selected[page_type]){continue;}
+        bool &seek_next(previous_seek_next[page_type]);
+        switch(page_type){
+#define process_case(type, header) \
+case header: \
+  super_t::process_packet(page, page_size, observer_ ## type, seek_next, handler); \
+  break;
+          process_case(A, 'A');
+          process_case(F, 'F');
+          process_case(P, 'P');
+          process_case(M, 'M');
+          process_case(N, 'N');
+          process_case(G, 'G');
+#undef process_case
+        }
+      }
+    }
+    if(batch > 0){
+      table_t *tables[] = {&table_A, &table_F, &table_P, &table_M, &table_N};
+      for(unsigned int i(0); (!stop) && (i < sizeof(tables) / sizeof(tables[0])); ++i){
+        if(tables[i]->records > 0){flush(*tables[i]);}
+      }
+      for(typename table_G_t::iterator it(table_G.begin()); (!stop) && (it != table_G.end()); ++it){
+        if(it->second.records > 0){flush(it->second);}
+      }
+    }
+    return true;
+  }
+};
+%}
+
+%{
+#if defined(SWIGRUBY)
+#include <ruby/version.h>
+#if RUBY_API_VERSION_CODE >= 20000
+#include <ruby/thread.h>
+#define SYLPHIDE_LOADER_WITHOUT_GVL
+#endif
+
+template <class FloatType>
+struct SylphideLogLoader_Ruby : public SylphideLogLoader<FloatType> {
+  typedef SylphideLogLoader<FloatType> super_t;
+  typedef typename super_t::table_t table_t;
+  int state;
+  SylphideLogLoader_Ruby(const std::string &filter, const unsigned int &batch)
+      : super_t(filter, batch), state(0) {}
+  static VALUE to_hash(const table_t &table){
+    VALUE res(rb_hash_new());
+    for(unsigned int i(0); i < table.columns.size(); ++i){
+      rb_hash_aset(res,
+          rb_str_new2(table.column_names[i].c_str()),
+          rb_str_new(table.columns[i].data(), table.columns[i].size()));
+    }
+    return res;
+  }
+  static VALUE yield_table(VALUE args){
+    return rb_yield_values2(2, reinterpret_cast<VALUE *>(args));
+  }
+  void flush(table_t &table){
+    VALUE args[2] = {rb_str_new2(table.name.c_str()), to_hash(table)};
+    table.clear();
+    rb_protect(yield_table, reinterpret_cast<VALUE>(args), &state);
+    if(state != 0){super_t::stop = true;}
+  }
+  VALUE tables() const {
+    VALUE res(rb_hash_new());
+    const table_t *tables[] = {
+        &this->table_A, &this->table_F, &this->table_P,
+        &this->table_M, &this->table_N};
+    for(unsigned int i(0); i < sizeof(tables) / sizeof(tables[0]); ++i){
+      if(tables[i]->records == 0){continue;}
+      rb_hash_aset(res, rb_str_new2(tables[i]->name.c_str()), to_hash(*tables[i]));
+    }
+    for(typename super_t::table_G_t::const_iterator it(super_t::table_G.begin());
+        it != super_t::table_G.end(); ++it){
+      rb_hash_aset(res, rb_str_new2(it->second.name.c_str()), to_hash(it->second));
+    }
+    return res;
+  }
+  /**
+   * Load a file; when a block is given, tables are yielded every batch records,
+   * otherwise, the whole file is loaded without the GVL, and then a Hash of tables is returned.
+   */
+  VALUE load(const std::string &fname){
+    bool loaded;
+    if(rb_block_given_p()){
+      loaded = super_t::load(fname);
+    }else{
+      struct load_t {
+        super_t &loader;
+        const std::string &fname;
+        bool loaded;
+        static void *run(void *ptr){
+          load_t *arg(static_cast<load_t *>(ptr));
+          arg->loaded = arg->loader.load(arg->fname);
+          return NULL;
+        }
+      } arg = {*this, fname, false};
+#if defined(SYLPHIDE_LOADER_WITHOUT_GVL)
+      rb_thread_call_without_gvl(load_t::run, &arg, NULL, NULL);
+#else
+      load_t::run(&arg);
+#endif
+      loaded = arg.loaded;
+    }
+    if(!loaded){
+      throw std::runtime_error(std::string("Cannot open: ").append(fname));
+    }
+    return rb_block_given_p() ? Qnil : tables();
+  }
+};
+#endif
+%}
+
 %extend SylphideProcessor{
   %ignore set_a_handler;
   %ignore set_g_handler;
@@ -303,6 +687,29 @@ struct N_navdata_t {
   void process(const std::string &s){
     self->process(const_cast<char *>(s.c_str()), s.size());
   }
+#if defined(SWIGRUBY)
+  /**
+   * Parse a whole file in C++, and return a Hash of column-oriented tables
+   * {"A" => {"itow" => packed, "values" => packed, ...}, "G:0x01:0x02" => {...}, ...},
+   * where each column is a String packed with doubles, i.e., to be unpacked with "d*".
+   * When a block is given, (table_name, table) are yielded every batch records instead.
+   * 
+   * @param filter comma separated page types and UBX messages, for example, "A,G:0x01:0x02,G:0x02".
+   */
+  static VALUE load_file(
+      const std::string &fname, const std::string &filter = "", const unsigned int &batch = 0){
+    VALUE res(Qnil);
+    int state(0);
+    {
+      SylphideLogLoader_Ruby<FloatType> loader(
+          filter, rb_block_given_p() ? ((batch > 0) ? batch : 0x1000) : 0);
+      res = loader.load(fname);
+      state = loader.state;
+    }
+    if(state != 0){rb_jump_tag(state);}
+    return res;
+  }
+#endif
 }
 
 %include SylphideProcessor.h
@@ -91,6 +91,13 @@ shared_examples 'Matrix' do
 
       expect{ mat_type::new(*params[:rc]){raise(IndexError) } }.to raise_error(IndexError)
     end
+    it 'sets its elements with packed String, and exports them with pack' do
+      packed = compare_with.flatten.collect{|v| v.kind_of?(Complex) ? v.rect : v}.flatten.pack('d*')
+      expect( mat_type::new(params[:rc][0], params[:rc][1], packed).to_a ).to eq(compare_with)
+      expect{ mat_type::new(params[:rc][0], params[:rc][1], packed[0..-2]) }.to raise_error(ArgumentError)
+      expect( mat_type::new(compare_with).pack ).to eq(packed)
+      expect( mat_type::new(compare_with).t.pack ).to eq(mat_type::new(compare_with).t.copy.pack)
+    end
   end
   
   describe 'property' do
@@ -525,6 +532,19 @@ shared_examples 'Matrix' do
         expect{mat[2].send(func)}.to raise_error(RuntimeError)
       }
     end
+    it 'have inverse without GVL' do
+      gvl_release_size = SylphideMath::gvl_release_size
+      begin
+        SylphideMath::gvl_release_size = 0
+        expected = inversible.inverse.to_a
+        4.times.collect{Thread::new{inversible.inverse.to_a}}.each{|th|
+          expect(th.value).to eq(expected)
+        }
+        expect{mat[2].inverse}.to raise_error(RuntimeError)
+      ensure
+        SylphideMath::gvl_release_size = gvl_release_size
+      end
+    end
     it 'have /(mat)' do
       (Matrix[*((mat[0] / mat[1]).to_a)] - (Matrix[*compare_with[0]] / Matrix[*compare_with[1]])).each{|v|
         expect(v.abs).to be < params[:acceptable_delta]
@@ -0,0 +1,94 @@
+require 'rspec'
+require 'tempfile'
+
+$: << File::join(File::dirname(__FILE__), '..', 'build_SWIG')
+require 'SylphideProcessor.so'
+
+describe 'SylphideLog::load_file' do
+  let(:epochs){10}
+  let(:log){
+    pages = []
+    ubx = ''.force_encoding('ASCII-8BIT')
+    epochs.times{|i|
+      itow_ms = 1000 * i
+      pages << ['A', i, itow_ms].pack('a1CV') \
+          + 8.times.collect{|j| [(i << 8) + j].pack('N')[1..-1]}.join \
+          + [25 + i].pack('v')
+      pages << ['M', i, 0, 0, itow_ms].pack('a1C3V') \
+          + [i, -i, i * 2, 0, 0, 0, 0, 0, 0, 0, 0, 0].pack('s>*')
+      payload = [itow_ms, 1, 2, 3, 4, 5, 6].pack('Vl<l<l<l<VV') # NAV-POSLLH
+      frame = [0x01, 0x02, payload.size].pack('CCv') + payload
+      ck_a, ck_b = frame.each_byte.inject([0, 0]){|(a, b), v| [(a + v) & 0xFF, (b + a + v) & 0xFF]}
+      ubx << [0xB5, 0x62].pack('C*') << frame << [ck_a, ck_b].pack('C*')
+    }
+    ubx << "\0" * (-ubx.size % 31)
+    pages += ubx.scan(/.{31}/m).collect{|chunk| 'G' + chunk}
+    pages.join.force_encoding('ASCII-8BIT')
+  }
+  let(:fname){
+    f = Tempfile::new(['SylphideProcessor_spec', '.dat'])
+    f.binmode
+    f.write(log)
+    f.close
+    @tmp = f # keep it until the end of each example
+    f.path
+  }
+  let(:per_page){
+    res = Hash::new{|h, k| h[k] = Hash::new{|h2, k2| h2[k2] = []}}
+    SylphideProcessor::SylphideLog::new.process(log){|obs|
+      case obs
+      when SylphideProcessor::APacketObserver
+        res['A']['itow'] << obs.fetch_ITOW
+        res['A']['values'] += obs.values.values.to_a
+        res['A']['temperature'] << obs.values.temperature
+      when SylphideProcessor::MPacketObserver
+        res['M']['x'] += obs.values.x.to_a
+        res['M']['y'] += obs.values.y.to_a
+        res['M']['z'] += obs.values.z.to_a
+      when SylphideProcessor::GPacketObserver
+        next unless obs.valid?
+        table = res["G:0x%02X:0x%02X" % [obs.ubx_class, obs.ubx_id]]
+        table['itow'] << obs.fetch_ITOW
+        table['latitude'] << obs.position.latitude
+      end
+    }
+    res
+  }
+  let(:unpack){lambda{|tables|
+    Hash[*tables.collect{|k, table|
+      [k, Hash[*table.collect{|k2, v| [k2, v.unpack('d*')]}.flatten(1)]]
+    }.flatten(1)]
+  }}
+
+  it 'has the same pages and values as the per-page observers' do
+    tables = unpack.call(SylphideProcessor::SylphideLog::load_file(fname))
+    expect(tables.keys.sort).to eq(['A', 'G:0x01:0x02', 'M'])
+    expect(tables.keys.sort).to eq(per_page.keys.sort)
+    per_page.each{|k, table|
+      table.each{|k2, values|
+        expect(tables[k][k2]).to eq(values)
+      }
+    }
+    expect(tables['A']['itow'].size).to eq(epochs)
+    expect(tables['M']['itow']).to eq(epochs.times.collect{|i| i * 1.0})
+    expect(tables['G:0x01:0x02']['itow'].size).to eq(epochs)
+  end
+  it 'filters pages and UBX messages' do
+    expect(SylphideProcessor::SylphideLog::load_file(fname, 'A').keys).to eq(['A'])
+    expect(SylphideProcessor::SylphideLog::load_file(fname, 'G:0x01:0x02').keys).to eq(['G:0x01:0x02'])
+    expect(SylphideProcessor::SylphideLog::load_file(fname, 'G:0x02').keys).to eq([])
+    expect{SylphideProcessor::SylphideLog::load_file(fname, 'G:0x100')}.to raise_error(RuntimeError)
+  end
+  it 'yields tables every batch records when a block is given' do
+    yielded = Hash::new{|h, k| h[k] = Hash::new{|h2, k2| h2[k2] = ''.force_encoding('ASCII-8BIT')}}
+    res = SylphideProcessor::SylphideLog::load_file(fname, '', 3){|name, table|
+      expect(table['itow'].unpack('d*').size).to be <= 3
+      table.each{|k, v| yielded[name][k] << v}
+    }
+    expect(res).to be_nil
+    expect(unpack.call(yielded)).to eq(unpack.call(SylphideProcessor::SylphideLog::load_file(fname)))
+  end
+  it 'raises an error for a missing file' do
+    expect{SylphideProcessor::SylphideLog::load_file(fname + '.missing')}.to raise_error(RuntimeError)
+  end
+end
@@ -1,6 +1,11 @@
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
 
 #include "navigation/INS_GPS_Factory.h"
+#include "navigation/INS_Preintegration.h"
+#include "navigation/INS_GPS_Batch.h"
+#include "navigation/INS_GPS_Smoother.h"
 
 #include <boost/type_traits/is_same.hpp>
 
@@ -199,4 +204,420 @@ BOOST_AUTO_TEST_CASE(option){
       typename opt_t::bias_t<typename opt_t::kf_t<void, KalmanFilter> > >::value));
 }
 
+/**
+ * Common scenario of the filter tests, whose variation is selected by k
+ */
+template <class FINS>
+struct filter_fixture_t {
+  typedef typename FINS::float_t float_t;
+  typedef typename FINS::vec3_t vec3_t;
+  typedef typename FINS::mat_t mat_t;
+
+  static void init(FINS &fins, const int &k = 0){
+    fins.initPosition(35. / 180 * M_PI, 139. / 180 * M_PI, 100 + k);
+    fins.initVelocity(12 + 0.1 * k, -5, 0.5);
+    fins.initAttitude(0.3 - 0.01 * k, -0.1, 0.05);
+    mat_t P(fins.getFilter().getP()), Q(fins.getFilter().getQ());
+    for(unsigned int i(0); i < P.rows(); ++i){
+      // velocity [m/s], position as quaternion elements, height [m], attitude, and biases
+      P(i, i) = (i < 3) ? 1 : ((i < 6) ? 1E-12 : ((i < 7) ? 10 : ((i < 10) ? 1E-4 : 1E-6)));
+    }
+    for(unsigned int i(0); i < Q.rows(); ++i){Q(i, i) = 1E-2;}
+    fins.getFilter().setP(P);
+    fins.getFilter().setQ(Q);
+  }
+  static vec3_t accel(const int &k = 0){
+    return vec3_t(0.5 + 0.01 * k, -0.3, -9.7);
+  }
+  static vec3_t gyro(const int &k = 0){
+    return vec3_t(0.01, -0.02 * (k + 1), 0.03);
+  }
+  /**
+   * @param i index of the IMU sample
+   */
+  static GPS_Solution<float_t> gps(const int &i, const int &k = 0){
+    GPS_Solution<float_t> res;
+    res.v_n = 12; res.v_e = -5 + 0.1 * k; res.v_d = 0.5;
+    res.sigma_vel = 0.1;
+    res.latitude = 35. / 180 * M_PI + 1E-6 * i;
+    res.longitude = 139. / 180 * M_PI;
+    res.height = 100 - k;
+    res.sigma_2d = 2; res.sigma_height = 3;
+    res.valid_velocity = res.valid_position = true;
+    return res;
+  }
+  /**
+   * Compare covariance matrices in the scale of correlation
+   */
+  static void check_P(const mat_t &P_ref, const mat_t &P, const float_t &tolerance){
+    for(unsigned int i(0); i < P_ref.rows(); ++i){
+      for(unsigned int j(0); j < P_ref.columns(); ++j){
+        BOOST_CHECK_SMALL(P_ref(i, j) - P(i, j),
+            std::sqrt(P_ref(i, i) * P_ref(j, j)) * tolerance);
+      }
+    }
+  }
+};
+
+template <class FINS>
+struct sparse_predict_test_t : public FINS {
+  typedef filter_fixture_t<FINS> fixture_t;
+  typedef typename FINS::float_t float_t;
+  typedef typename FINS::mat_t mat_t;
+  typedef typename FINS::getAB_res getAB_res;
+  typedef typename FINS::sparsity_t sparsity_t;
+
+  static bool in_pattern(const std::vector<unsigned int> &row, const unsigned int &j){
+    for(unsigned int k(0); k < row.size(); ++k){
+      if(row[k] == j){return true;}
+    }
+    return false;
+  }
+
+  void run(){
+    fixture_t::init(*this);
+    getAB_res AB;
+    this->getAB(fixture_t::accel(), fixture_t::gyro(), AB);
+    mat_t A(AB.getA()), B(AB.getB());
+
+    const sparsity_t &pattern(FINS::sparsity());
+    for(unsigned int i(0); i < A.rows(); ++i){
+      BOOST_CHECK(in_pattern(pattern.phi[i], i));
+      for(unsigned int j(0); j < A.columns(); ++j){
+        if(A(i, j) != 0){BOOST_CHECK(in_pattern(pattern.phi[i], j));}
+      }
+      for(unsigned int j(0); j < B.columns(); ++j){
+        if(B(i, j) != 0){BOOST_CHECK(in_pattern(pattern.gamma[i], j));}
+      }
+    }
+
+    // positive definite P, and diagonal Q
+    mat_t L(A.rows(), A.rows()), Q(B.columns(), B.columns());
+    unsigned int seed(1);
+    for(unsigned int i(0); i < L.rows(); ++i){
+      for(unsigned int j(0); j <= i; ++j){
+        seed = seed * 1103515245 + 12345;
+        L(i, j) = (float_t)((seed >> 16) & 0x7FFF) / 0x8000 - 0.5;
+      }
+      L(i, i) += 1;
+    }
+    for(unsigned int i(0); i < Q.rows(); ++i){Q(i, i) = 1E-2 * (i + 1);}
+    mat_t P(L * L.transpose());
+
+    sparsity_t pattern_no_offset(pattern); // offsets are generated for every call
+    pattern_no_offset.phi_offset.clear();
+    pattern_no_offset.gamma_offset.clear();
+
+    typename FINS::filter_t dense(P, Q), sparse(P, Q), sparse2(P, Q);
+    for(int k(0); k < 10; ++k){
+      dense.predict(A, B, 1E-2);
+      sparse.predict(A, B, 1E-2, pattern);
+      sparse2.predict(A, B, 1E-2, pattern_no_offset);
+    }
+    mat_t P_dense(dense.getP()), P_sparse(sparse.getP()), P_sparse2(sparse2.getP());
+    for(unsigned int i(0); i < P.rows(); ++i){
+      for(unsigned int j(0); j < P.columns(); ++j){
+        BOOST_CHECK_SMALL(P_dense(i, j) - P_sparse(i, j),
+            (std::abs(P_dense(i, j)) + 1) * 1E-10);
+        BOOST_CHECK_EQUAL(P_sparse(i, j), P_sparse2(i, j));
+      }
+    }
+  }
+};
+
+BOOST_AUTO_TEST_CASE(sparse_predict){
+  sparse_predict_test_t<Filtered_INS2<INS<>, KalmanFilter> >().run();
+  sparse_predict_test_t<Filtered_INS2<INS<>, KalmanFilterUD> >().run();
+  sparse_predict_test_t<Filtered_INS_BiasEstimated<
+      Filtered_INS2<INS_BiasEstimated<INS<> >, KalmanFilter> > >().run();
+  sparse_predict_test_t<Filtered_INS_BiasEstimated<
+      Filtered_INS2<INS_BiasEstimated<INS<> >, KalmanFilterUD> > >().run();
+}
+
+template <class FINS>
+struct deferred_propagation_test_t {
+  typedef filter_fixture_t<FINS> fixture_t;
+  typedef typename FINS::mat_t mat_t;
+
+  void run(){
+    FINS fins[2];
+    for(int k(0); k < 2; ++k){
+      fixture_t::init(fins[k]);
+      // comparable variances, because the error of the approximation scales with the largest one
+      mat_t P(fins[k].getFilter().getP());
+      for(unsigned int i(0); i < P.rows(); ++i){P(i, i) = 1E-2 * (i + 1);}
+      fins[k].getFilter().setP(P);
+    }
+    fins[1].setPropagationInterval(10);
+    BOOST_REQUIRE_EQUAL(fins[1].getPropagationInterval(), 10);
+
+    // 25 samples, whose last 5 samples are flushed by getFilter()
+    for(int i(0); i < 25; ++i){
+      for(int k(0); k < 2; ++k){
+        fins[k].update(fixture_t::accel(), fixture_t::gyro(), 1E-2);
+      }
+    }
+    fixture_t::check_P(fins[0].getFilter().getP(), fins[1].getFilter().getP(), 1E-3);
+  }
+};
+
+BOOST_AUTO_TEST_CASE(deferred_propagation){
+  deferred_propagation_test_t<Filtered_INS2<INS<>, KalmanFilter> >().run();
+  deferred_propagation_test_t<Filtered_INS2<INS<>, KalmanFilterUD> >().run();
+  deferred_propagation_test_t<Filtered_INS_BiasEstimated<
+      Filtered_INS2<INS_BiasEstimated<INS<> >, KalmanFilter> > >().run();
+  deferred_propagation_test_t<Filtered_INS_BiasEstimated<
+      Filtered_INS2<INS_BiasEstimated<INS<> >, KalmanFilterUD> > >().run();
+}
+
+BOOST_AUTO_TEST_CASE(preintegration){
+  typedef INS_Preintegration<double> preint_t;
+  typedef preint_t::vec3_t vec3_t;
+  typedef Quaternion<double> quat_t;
+
+  { // single sample is passed through
+    preint_t p;
+    p.add(vec3_t(1, 2, 3), vec3_t(0.1, 0.2, 0.3), 0.01);
+    BOOST_REQUIRE_EQUAL(p.size(), 1);
+    for(int i(0); i < 3; ++i){
+      BOOST_CHECK_CLOSE(p.accel()[i], 1. * (i + 1), 1E-10);
+      BOOST_CHECK_CLOSE(p.gyro()[i], 0.1 * (i + 1), 1E-10);
+    }
+    p.clear();
+    BOOST_CHECK(p.empty());
+  }
+
+  { // sculling; constant rotation around Z axis with constant specific force along X axis,
+    // whose velocity change in the initial body frame is (sin(w T), 1 - cos(w T), 0) * a / w
+    const double w(0.2), a(3), T(0.1);
+    const int n(1000);
+    preint_t p;
+    for(int k(0); k < n; ++k){p.add(vec3_t(a, 0, 0), vec3_t(0, 0, w), T / n);}
+    BOOST_CHECK_CLOSE(p.interval(), T, 1E-8);
+    BOOST_CHECK_CLOSE(p.delta_angle()[2], w * T, 1E-8);
+    vec3_t dv(p.delta_velocity());
+    BOOST_CHECK_CLOSE(dv[0], std::sin(w * T) * a / w, 1E-2);
+    BOOST_CHECK_CLOSE(dv[1], (1. - std::cos(w * T)) * a / w, 2E-1);
+    BOOST_CHECK_SMALL(dv[2], 1E-12);
+  }
+
+  { // coning; angular speed (0, a cos(W t), a sin(W t)) causes drift around X axis
+    const double a(0.5), W(M_PI * 10), T(0.1);
+    const int n(10), sub(1000);
+    preint_t p;
+    quat_t q(1, 0, 0, 0); // reference obtained by fine integration
+    for(int k(0); k < n; ++k){
+      double t0(T * k / n), t1(T * (k + 1) / n);
+      vec3_t delta_theta( // exact integral over the sample
+          0, a / W * (std::sin(W * t1) - std::sin(W * t0)), a / W * (std::cos(W * t0) - std::cos(W * t1)));
+      p.add(vec3_t(), delta_theta / (t1 - t0), t1 - t0);
+      for(int j(0); j < sub; ++j){
+        double dt((t1 - t0) / sub), t(t0 + dt * (j + 0.5));
+        vec3_t half(vec3_t(0, a * std::cos(W * t), a * std::sin(W * t)) * (dt / 2));
+        q *= quat_t(std::cos(half.abs()), half * (std::sin(half.abs()) / half.abs()));
+      }
+    }
+    vec3_t phi_ref(q.vector() * (std::atan2(q.vector().abs(), q.scalar()) * 2 / q.vector().abs()));
+    double err_coning((p.delta_angle() - phi_ref).abs()), err_naive((p.alpha - phi_ref).abs());
+    dbg("coning error: " << err_coning << ", without compensation: " << err_naive, false);
+    BOOST_CHECK(err_coning < err_naive * 0.1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(quaternion_kernels){
+  typedef Quaternion<double> quat_t;
+  typedef Vector3<double> vec3_t;
+  std::srand(1);
+  for(int k(0); k < 100; ++k){
+    double a[4], b[4], v[3], res[4];
+    for(int i(0); i < 4; ++i){
+      a[i] = (double)std::rand() / RAND_MAX - 0.5;
+      b[i] = (double)std::rand() / RAND_MAX - 0.5;
+    }
+    for(int i(0); i < 3; ++i){v[i] = (double)std::rand() / RAND_MAX - 0.5;}
+    quat_t q_a(a), q_b(b);
+    vec3_t v_(v);
+
+    // kernels must be identical to operators
+    quat_t::product(a, b, res);
+    quat_t ab(q_a * q_b);
+    for(int i(0); i < 4; ++i){BOOST_CHECK_EQUAL(res[i], ab[i]);}
+    quat_t::product(a, v, res);
+    quat_t av(q_a * v_);
+    for(int i(0); i < 4; ++i){BOOST_CHECK_EQUAL(res[i], av[i]);}
+    double c[3] = {v[0], v[1], v[2]}, w[3] = {b[1], b[2], b[3]};
+    vec3_t::cross(c, w, c); // aliased output
+    vec3_t vw(v_ * vec3_t(w));
+    for(int i(0); i < 3; ++i){BOOST_CHECK_EQUAL(c[i], vw[i]);}
+    std::memcpy(res, a, sizeof(a));
+    quat_t::regularize(res);
+    quat_t a_r(q_a.regularize());
+    for(int i(0); i < 4; ++i){BOOST_CHECK_EQUAL(res[i], a_r[i]);}
+
+    // DCM rotates a vector in the same way as quaternion; q^{*} v q
+    Matrix_Fixed<double, 3> dcm(q_a.getDCM());
+    vec3_t rotated((a_r.conj() * v_ * a_r).vector());
+    for(int i(0); i < 3; ++i){
+      double sum(0);
+      for(int j(0); j < 3; ++j){sum += dcm(i, j) * v_[j];}
+      BOOST_CHECK_SMALL(sum - rotated[i], 1E-12);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(single_precision){
+  // slow motion, whose position increment in each step is smaller than
+  // the resolution of the position quaternion in float
+  INS<float> ins_f;
+  INS<double> ins_d;
+  const double lat0(35. / 180 * M_PI), lng0(139. / 180 * M_PI), R(6378137);
+  ins_f.initPosition(lat0, lng0, 100);
+  ins_d.initPosition(lat0, lng0, 100);
+  ins_f.initVelocity(0.5, 0.3, 0);
+  ins_d.initVelocity(0.5, 0.3, 0);
+  for(int i(0); i < 10000; ++i){
+    ins_f.update(Vector3<float>(0, 0, -9.797f), Vector3<float>(), 1E-2f);
+    ins_d.update(Vector3<double>(0, 0, -9.797), Vector3<double>(), 1E-2);
+  }
+  dbg("moved (N, E) [m]: "
+      << (ins_d.latitude() - lat0) * R << ", "
+      << (ins_d.longitude() - lng0) * R * std::cos(lat0), false);
+  BOOST_CHECK((ins_d.latitude() - lat0) * R > 40);
+  BOOST_CHECK_SMALL((ins_f.latitude() - ins_d.latitude()) * R, 1.);
+  BOOST_CHECK_SMALL((ins_f.longitude() - ins_d.longitude()) * R * std::cos(lat0), 1.);
+  BOOST_CHECK_SMALL(ins_f.height() - ins_d.height(), 1E-1);
+}
+
+template <class INS_GPS_Single, class INS_GPS_Batched>
+struct batch_test_t {
+  typedef filter_fixture_t<INS_GPS_Single> fixture_t;
+  typedef typename INS_GPS_Single::float_t float_t;
+  typedef typename INS_GPS_Single::vec3_t vec3_t;
+
+  void run(const int &size, const unsigned int &interval = 1){
+    std::vector<INS_GPS_Single> single(size);
+    INS_GPS_Batched prototype;
+    filter_fixture_t<INS_GPS_Batched>::init(prototype);
+    prototype.setPropagationInterval(interval);
+    INS_GPS_Batch<INS_GPS_Batched> batch(prototype, size);
+    for(int k(0); k < size; ++k){
+      fixture_t::init(single[k], k);
+      single[k].setPropagationInterval(interval);
+      filter_fixture_t<INS_GPS_Batched>::init(batch[k], k);
+    }
+
+    std::vector<vec3_t> accel(size), gyro(size);
+    std::vector<GPS_Solution<float_t> > gps(size);
+    for(int i(0); i < 200; ++i){
+      for(int k(0); k < size; ++k){
+        accel[k] = fixture_t::accel(k);
+        gyro[k] = fixture_t::gyro(k);
+        single[k].update(accel[k], gyro[k], 1E-2);
+      }
+      batch.update(&accel[0], &gyro[0], 1E-2);
+      if(i % 50 != 49){continue;}
+      for(int k(0); k < size; ++k){
+        gps[k] = fixture_t::gps(i, k);
+        gps[k].valid_position = (k % 3 != 1); // mixture of the numbers of observations
+        single[k].correct(gps[k]);
+      }
+      batch.correct(&gps[0]);
+    }
+
+    for(int k(0); k < size; ++k){
+      for(unsigned int i(0); i < INS_GPS_Single::STATE_VALUES; ++i){
+        BOOST_CHECK_SMALL(single[k][i] - batch[k][i], (std::abs(single[k][i]) + 1) * 1E-9);
+      }
+      fixture_t::check_P(single[k].getFilter().getP(), batch[k].getFilter().getP(), 1E-9);
+    }
+  }
+};
+
+BOOST_AUTO_TEST_CASE(batch){
+  batch_test_t<
+      INS_GPS2<Filtered_INS2<INS<>, KalmanFilter> >,
+      INS_GPS2<Filtered_INS2<INS<>, KalmanFilterBatched> > >().run(11);
+  batch_test_t<
+      INS_GPS2<Filtered_INS_BiasEstimated<
+        Filtered_INS2<INS_BiasEstimated<INS<> >, KalmanFilter> > >,
+      INS_GPS2<Filtered_INS_BiasEstimated<
+        Filtered_INS2<INS_BiasEstimated<INS<> >, KalmanFilterBatched> > > >().run(11);
+  // samples pending at the measurement update
+  batch_test_t<
+      INS_GPS2<Filtered_INS2<INS<>, KalmanFilter> >,
+      INS_GPS2<Filtered_INS2<INS<>, KalmanFilterBatched> > >().run(11, 7);
+}
+
+template <class INS_GPS>
+struct rts_smoother_test_t {
+  typedef INS_GPS_RTS_Smoother<INS_GPS> smoother_t;
+  typedef filter_fixture_t<INS_GPS> fixture_t;
+  typedef typename INS_GPS::float_t float_t;
+  typedef typename INS_GPS::mat_t mat_t;
+
+  void run(){
+    smoother_t smoother[2];
+    for(int k(0); k < 2; ++k){
+      INS_GPS &ins_gps(smoother[k]);
+      fixture_t::init(ins_gps);
+      INS_GPS_RTS_Smoother_Property<float_t> prop;
+      prop.segments = (k == 0) ? 1 : 3;
+      prop.smooth_covariance = true;
+      BOOST_REQUIRE(smoother[k].setup_smoother(prop));
+    }
+
+    std::vector<std::vector<float_t> > P_filtered;
+    for(int i(0); i < 200; ++i){
+      for(int k(0); k < 2; ++k){
+        smoother[k].update(fixture_t::accel(), fixture_t::gyro(), 1E-2);
+        if(i % 50 == 49){smoother[k].correct(fixture_t::gps(i));}
+        smoother[k].mark(1E-2 * (i + 1), 0);
+      }
+      mat_t P(smoother[0].getFilter().getP());
+      P_filtered.push_back(std::vector<float_t>());
+      for(unsigned int j(0); j < P.rows(); ++j){P_filtered.back().push_back(P(j, j));}
+    }
+    INS_GPS last(smoother[0], true);
+
+    for(int k(0); k < 2; ++k){
+      BOOST_REQUIRE(smoother[k].smooth());
+      BOOST_REQUIRE_EQUAL(smoother[k].recorded_epochs(), 201);
+    }
+    const typename smoother_t::output_t *out[2] = {NULL};
+    for(int i(0); i < 200; ++i){
+      double t[2];
+      unsigned int tag[2];
+      for(int k(0); k < 2; ++k){
+        BOOST_REQUIRE((out[k] = smoother[k].next(t[k], tag[k])));
+        BOOST_REQUIRE_EQUAL(tag[k], 0);
+        BOOST_CHECK_SMALL(t[k] - 1E-2 * (i + 1), 1E-9);
+      }
+      // segments give the identical result to the sequential recursion except for rounding errors
+      for(unsigned int j(0); j < INS_GPS::STATE_VALUES; ++j){
+        BOOST_CHECK_SMALL((*out[0])[j] - (*out[1])[j], (std::abs((*out[0])[j]) + 1) * 1E-9);
+      }
+      mat_t P(const_cast<typename smoother_t::output_t *>(out[0])->getFilter().getP());
+      for(unsigned int j(0); j < P.rows(); ++j){
+        // smoothed P is not larger than the filtered one
+        BOOST_CHECK(P(j, j) <= P_filtered[i][j] * (1. + 1E-6));
+      }
+    }
+    for(int k(0); k < 2; ++k){
+      double t;
+      unsigned int tag;
+      BOOST_CHECK(!smoother[k].next(t, tag));
+    }
+    // the last epoch is not changed by smoothing
+    for(unsigned int j(0); j < INS_GPS::STATE_VALUES; ++j){
+      BOOST_CHECK_SMALL((*out[0])[j] - last[j], (std::abs(last[j]) + 1) * 1E-9);
+    }
+  }
+};
+
+BOOST_AUTO_TEST_CASE(rts_smoother){
+  rts_smoother_test_t<INS_GPS2<Filtered_INS2<INS<>, KalmanFilter> > >().run();
+  rts_smoother_test_t<INS_GPS2<Filtered_INS_BiasEstimated<
+      Filtered_INS2<INS_BiasEstimated<INS<> >, KalmanFilter> > > >().run();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
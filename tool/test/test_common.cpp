@@ -1,4 +1,9 @@
 #include "analyze_common.h"
+#include "SylphideProcessor.h"
+#include "util/ubx_scanner.h"
+#include "calibration.h"
+#include "util/spsc_queue.h"
+#include "util/shm_ring.h"
 
 #define BOOST_TEST_MAIN
 #include <boost/test/included/unit_test.hpp>
@@ -38,4 +43,244 @@ BOOST_AUTO_TEST_CASE(roll_over_monitor){
   BOOST_CHECK_EQUAL(true, monitor.abnormal_jump_detected);
 }
 
+#if !defined(_WIN32)
+BOOST_AUTO_TEST_CASE(comport_pty){
+  // pseudo terminal instead of a real serial port
+  int master(posix_openpt(O_RDWR | O_NOCTTY));
+  BOOST_REQUIRE(master >= 0);
+  BOOST_REQUIRE((grantpt(master) == 0) && (unlockpt(master) == 0));
+
+  typedef ComportStream::buf_t::time_ns_t time_ns_t;
+  BOOST_CHECK(GlobalOptions<double>::is_comport(ptsname(master)));
+  BOOST_CHECK(GlobalOptions<double>::is_comport((std::string(ptsname(master)) + ":115200").c_str()));
+  BOOST_CHECK(!GlobalOptions<double>::is_comport("/tmp"));
+  BOOST_CHECK(!GlobalOptions<double>::is_comport("/tmp:115200"));
+  ComportStream com(ptsname(master));
+  BOOST_CHECK_EQUAL(0, com.buffer().arrival_ns());
+
+  char pattern[0x100];
+  for(unsigned int i(0); i < sizeof(pattern); ++i){pattern[i] = (char)(i * 7);}
+
+  time_ns_t arrival_last(0);
+  for(int i(0); i < 4; ++i){
+    time_ns_t t_before(ComportStream::buf_t::monotonic_ns());
+    BOOST_REQUIRE_EQUAL((ssize_t)sizeof(pattern), write(master, pattern, sizeof(pattern)));
+    char buf[sizeof(pattern)];
+    com.read(buf, sizeof(buf));
+    BOOST_REQUIRE_EQUAL((std::streamsize)sizeof(buf), com.gcount());
+    BOOST_CHECK(std::memcmp(pattern, buf, sizeof(buf)) == 0);
+    time_ns_t arrival(com.buffer().arrival_ns());
+    BOOST_CHECK(arrival >= t_before);
+    BOOST_CHECK(arrival <= ComportStream::buf_t::monotonic_ns());
+    BOOST_CHECK(arrival > arrival_last);
+    arrival_last = arrival;
+  }
+
+  close(master);
+  BOOST_CHECK(com.get() == EOF); // hang up
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(calibration_round_trip){
+  typedef StandardCalibration<double> calib_t;
+  calib_t calib;
+  calib.index_base = 1;
+  calib.index_temp_ch = 7;
+  const char *specs[] = {
+    "acc_bias_tc 1.5 -2.0 0.5",
+    "acc_bias 32768 33000 32500",
+    "acc_sf 4096 4100 4090",
+    "acc_mis 1 0.01 -0.02 0.015 1 0.005 -0.01 0.02 1",
+    "gyro_bias_tc -0.5 1.0 0.25",
+    "gyro_bias 8388608 8388000 8389000",
+    "gyro_sf 939 950 930",
+    "gyro_mis 1 -0.03 0.01 0.02 1 -0.015 0.005 0.01 1",
+  };
+  struct get_value_t {
+    static const char *get(const char *line, const char *header){
+      std::size_t length(std::strlen(header));
+      return ((std::strncmp(line, header, length) == 0) && (line[length] == ' '))
+          ? &line[length + 1] : NULL;
+    }
+  };
+  BOOST_REQUIRE(calib.check_specs(specs, get_value_t::get));
+
+  // raw => calibrate => decalibrate => raw
+  for(int temp(0); temp < 3; ++temp){
+    int raw[8] = {0, 33000 + temp * 97, 32000 - temp * 55, 34000, 8380000, 8390000 + temp * 13, 8388608, 100 * temp};
+    calib_t::result_t accel(calib.raw2accel(raw)), omega(calib.raw2omega(raw));
+    int res[8] = {0};
+    res[calib.index_temp_ch] = raw[calib.index_temp_ch];
+    BOOST_REQUIRE(calib.accel2raw(accel.values, res));
+    BOOST_REQUIRE(calib.omega2raw(omega.values, res));
+    for(int i(1); i < 7; ++i){
+      BOOST_CHECK_EQUAL(raw[i], res[i]);
+    }
+  }
+
+  // singular misalignment
+  const char *singular[] = {"acc_mis 1 0 0 1 0 0 0 0 1"};
+  BOOST_REQUIRE(calib.check_specs(singular, get_value_t::get));
+  double accel[3] = {0, 0, -9.8};
+  int res[8] = {0};
+  BOOST_CHECK(!calib.accel2raw(accel, res));
+}
+
+BOOST_AUTO_TEST_CASE(ubx_resync){
+  // UBX_Scanner of log2ubx --fast_extraction has to follow the same rule as G_Packet_Observer
+  unsigned char frame[] = {0xB5, 0x62, 0x0A, 0x04, 0x00, 0x00, 0x00, 0x00};
+  for(unsigned int i(2); i < sizeof(frame) - 2; ++i){
+    frame[6] += frame[i];
+    frame[7] += frame[6];
+  }
+  struct scanner_t : public UBX_Scanner {
+    int good, bad;
+    scanner_t() : UBX_Scanner(0x100, 0x80), good(0), bad(0) {}
+    bool frame(const unsigned char *packet, const unsigned int &size){
+      good++;
+      return true;
+    }
+    void bad_frame(){bad++;}
+  };
+  struct counter_t {
+    static int observer_frames(const std::vector<char> &stream){
+      G_Packet_Observer<> observer(0x100);
+      observer.write(&stream[0], stream.size());
+      int res((observer.ready() && observer.validate()) ? 1 : 0); // same as process_raw()
+      for(bool found(observer.seek_next()); found && observer.ready(); found = observer.seek_next()){
+        if(observer.validate()){res++;}
+      }
+      return res;
+    }
+    static int scanner_frames(const std::vector<char> &stream, const unsigned int &block){
+      scanner_t scanner;
+      for(unsigned int i(0); i < stream.size(); i += block){
+        scanner.append(&stream[i], (std::min)(block, (unsigned int)stream.size() - i));
+      }
+      return scanner.good;
+    }
+    static void check(const std::vector<char> &stream, const int &expected){
+      BOOST_CHECK_EQUAL(expected, observer_frames(stream));
+      BOOST_CHECK_EQUAL(expected, scanner_frames(stream, stream.size()));
+      BOOST_CHECK_EQUAL(expected, scanner_frames(stream, 1)); // incomplete frames are left for the next append
+    }
+  };
+  std::vector<char> stream;
+  for(int i(0); i < 2; ++i){stream.insert(stream.end(), frame, frame + sizeof(frame));}
+  counter_t::check(stream, 2);
+  stream.insert(stream.begin(), (char)0xB5);
+  counter_t::check(stream, 1); // B5 B5 62 skips the first header as a whole
+  stream.insert(stream.begin() + 1, (char)0x00);
+  counter_t::check(stream, 2); // B5 00 B5 62
+
+  stream[stream.size() - 1]++; // broken checksum of the last frame
+  scanner_t scanner;
+  scanner.append(&stream[0], stream.size());
+  BOOST_CHECK_EQUAL(1, scanner.good);
+  BOOST_CHECK_EQUAL(1, scanner.bad);
+}
+
+BOOST_AUTO_TEST_CASE(spsc_queue_policy){
+  typedef SPSC_Queue<int> queue_t;
+  queue_t q(3);
+  BOOST_REQUIRE_EQUAL(4, q.capacity()); // rounded up
+  for(int i(0); i < 4; ++i){BOOST_REQUIRE(q.push(i, queue_t::DROP));}
+  BOOST_CHECK(!q.push(4, queue_t::DROP));
+  BOOST_CHECK_EQUAL(4, q.size());
+
+  BOOST_REQUIRE(q.try_read_slot());
+  BOOST_CHECK_EQUAL(0, *q.try_read_slot());
+  q.release();
+  BOOST_REQUIRE(q.push(5, queue_t::DROP));
+  q.close();
+
+  int expected[] = {1, 2, 3, 5};
+  for(unsigned int i(0); i < sizeof(expected) / sizeof(expected[0]); ++i){
+    int *item(q.read_slot());
+    BOOST_REQUIRE(item);
+    BOOST_CHECK_EQUAL(expected[i], *item);
+    q.release();
+  }
+  BOOST_CHECK(!q.read_slot()); // closed and empty
+
+  SPSC_QueueStats stats(q.stats());
+  BOOST_CHECK_EQUAL(5u, stats.pushed);
+  BOOST_CHECK_EQUAL(1u, stats.dropped);
+  BOOST_CHECK_EQUAL(4u, stats.depth_max);
+
+  queue_t q2(2);
+  q2.cancel();
+  BOOST_REQUIRE(q2.push(0) && q2.push(1));
+  BOOST_CHECK(!q2.push(2)); // blocking push returns when cancelled
+}
+
+BOOST_AUTO_TEST_CASE(spsc_queue_thread){
+  typedef SPSC_Queue<unsigned int> queue_t;
+  static const unsigned int items(100000);
+  struct producer_t : public Thread {
+    queue_t q;
+    producer_t() : Thread(), q(0x10) {}
+    void run(){
+      for(unsigned int i(0); i < items; ++i){
+        unsigned int *slot(q.write_slot());
+        *slot = i;
+        q.commit();
+      }
+      q.close();
+    }
+  } producer;
+  BOOST_REQUIRE(producer.start());
+  unsigned int count(0);
+  bool ordered(true);
+  while(unsigned int *item = producer.q.read_slot()){
+    if(*item != count++){ordered = false;}
+    producer.q.release();
+  }
+  producer.join();
+  BOOST_CHECK(ordered);
+  BOOST_CHECK_EQUAL(items, count);
+  BOOST_CHECK_EQUAL(0u, producer.q.stats().dropped);
+}
+
+#if defined(SHM_RING_AVAILABLE)
+BOOST_AUTO_TEST_CASE(shm_ring){
+  typedef SharedMemoryRing<int> ring_t;
+  const char *name("/test_common_shm_ring");
+  ring_t::Writer writer(name, 4);
+  BOOST_REQUIRE(writer.is_open());
+  ring_t::Reader reader(name);
+  BOOST_REQUIRE(reader.is_open());
+  BOOST_CHECK(!SharedMemoryRing<double>::Reader(name).is_open()); // record size mismatch
+
+  int rec;
+  BOOST_CHECK(!reader.read(rec));
+  writer.publish(0);
+  ring_t::time_ns_t published;
+  BOOST_REQUIRE(reader.read(rec, &published));
+  BOOST_CHECK_EQUAL(0, rec);
+  BOOST_CHECK(published <= ring_t::monotonic_ns());
+
+  for(int i(1); i <= 6; ++i){writer.publish(i);} // 1 and 2 are overwritten
+  for(int i(3); i <= 6; ++i){
+    BOOST_REQUIRE(reader.read(rec));
+    BOOST_CHECK_EQUAL(i, rec);
+  }
+  BOOST_CHECK_EQUAL(2u, reader.lost());
+
+  ring_t::Reader reader2(name, true); // from the oldest
+  BOOST_REQUIRE(reader2.read(rec));
+  BOOST_CHECK_EQUAL(3, rec);
+  writer.publish(7);
+  BOOST_REQUIRE(reader2.latest(rec));
+  BOOST_CHECK_EQUAL(7, rec);
+
+  BOOST_CHECK(!reader.closed());
+  writer.close();
+  BOOST_CHECK(!reader.closed()); // 7 is not read yet
+  BOOST_REQUIRE(reader.read(rec));
+  BOOST_CHECK(reader.closed());
+  shm_unlink(name);
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -15,6 +15,7 @@
 #define BOOST_TEST_MAIN
 #include <boost/test/included/unit_test.hpp>
 #include "test_matrix/common.h"
+#include "util/thread.h"
 
 using namespace std;
 
@@ -134,6 +135,34 @@ BOOST_AUTO_TEST_CASE(copy){
   }
 }
 
+struct shallow_copier_t : public Thread {
+  typedef Array2D_Dense<content_t> storage_t;
+  const storage_t &src;
+  shallow_copier_t(const storage_t &_src) : Thread(), src(_src) {}
+  void run(){
+    for(int i(0); i < 100000; ++i){
+      storage_t a(src), b;
+      b = a;
+    }
+  }
+};
+
+BOOST_AUTO_TEST_CASE(shallow_copy_threads){
+  // shallow copies made and released in different threads must keep the reference counter
+  if(!RefCounter_Default::thread_safe || !Thread::available()){return;}
+  struct storage_t : public Array2D_Dense<content_t> {
+    storage_t() : Array2D_Dense<content_t>(4, 4) {}
+    RefCounter_Default::count_t count() const {return RefCounter_Default::get(*ref);}
+  } storage;
+  {
+    shallow_copier_t c0(storage), c1(storage), c2(storage), c3(storage);
+    shallow_copier_t *copier[] = {&c0, &c1, &c2, &c3};
+    for(int i(0); i < 4; ++i){BOOST_REQUIRE(copier[i]->start());}
+    for(int i(0); i < 4; ++i){copier[i]->join();}
+  }
+  BOOST_REQUIRE_EQUAL(storage.count(), 1);
+}
+
 BOOST_AUTO_TEST_CASE(assign_null_matrix){
   matrix_t _A(A->copy()), __A = *A;
   __A = matrix_t();
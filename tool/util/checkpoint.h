@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+/** @file
+ * @brief Binary archive to save and restore internal states
+ *
+ * The same function can be used for both saving and restoring, for example,
+ *   void checkpoint(CheckpointArchive &ar, state_t &state){ar & state.a & state.b;}
+ * Values are stored in the native byte order and memory layout without conversion
+ * in order to restore them bit-exactly. Therefore, an archive is compatible only with
+ * the program which has generated it.
+ */
+
+#include <iostream>
+#include <string>
+#include <cstddef>
+
+class CheckpointArchive {
+  protected:
+    std::ostream *out;
+    std::istream *in;
+    bool ok;
+  public:
+    CheckpointArchive(std::ostream &_out) : out(&_out), in(NULL), ok(_out.good()) {}
+    CheckpointArchive(std::istream &_in) : out(NULL), in(&_in), ok(_in.good()) {}
+
+    bool loading() const {return in != NULL;}
+    bool good() const {return ok;}
+    void invalidate(){ok = false;}
+
+    CheckpointArchive &bytes(void *buf, const std::size_t &size){
+      if(!ok){return *this;}
+      if(in){
+        ok = !in->read(static_cast<char *>(buf), size).fail();
+      }else{
+        ok = !out->write(static_cast<const char *>(buf), size).fail();
+      }
+      return *this;
+    }
+
+    /**
+     * Save or restore an object as it is.
+     * It must be trivially copyable, i.e., it must not have any pointer to be followed.
+     */
+    template <class T>
+    CheckpointArchive &pod(T &v){
+      return bytes(&v, sizeof(T));
+    }
+
+#define make_entry(type) \
+CheckpointArchive &operator&(type &v){return pod(v);}
+    make_entry(bool);
+    make_entry(char);
+    make_entry(int);
+    make_entry(unsigned int);
+    make_entry(long);
+    make_entry(unsigned long);
+    make_entry(float);
+    make_entry(double);
+#undef make_entry
+
+    CheckpointArchive &operator&(std::string &str){
+      unsigned long length(str.size());
+      (*this) & length;
+      if(!ok){return *this;}
+      if(in){
+        str.resize(length);
+        if(length > 0){bytes(&str[0], length);}
+      }else{
+        bytes(const_cast<char *>(str.data()), length);
+      }
+      return *this;
+    }
+
+    /**
+     * Save a marker, or check whether a restored marker is identical to the expected one.
+     * It is used to detect inconsistency between an archive and the restoring program.
+     */
+    CheckpointArchive &marker(const char *name){
+      std::string str(name), str_expected(str);
+      (*this) & str;
+      if(str != str_expected){ok = false;}
+      return *this;
+    }
+};
+
+#endif /* __CHECKPOINT_H__ */
@@ -46,13 +46,20 @@
 #include <termios.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <time.h>
 #include <sys/ioctl.h>
 #include <cstdio>
+#include <cerrno>
 #endif
 
 /**
  * Blocking streambuf for serial/tty port
  * 
+ * On POSIX, the port is opened in non-blocking mode, and all available data
+ * is read at once after waiting for its arrival with poll().
+ * The arrival time of each chunk is recorded with a monotonic clock,
+ * which is obtained for the last read character by arrival_ns().
  */
 template<
     class _Elem, 
@@ -64,13 +71,37 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
 #else
     typedef int handle_t;
 #endif
+    typedef unsigned long long time_ns_t;
+
+    /**
+     * Current time of monotonic clock in nanoseconds
+     */
+    static time_ns_t monotonic_ns(){
+#ifdef _WIN32
+      LARGE_INTEGER freq, count;
+      QueryPerformanceFrequency(&freq);
+      QueryPerformanceCounter(&count);
+      return (time_ns_t)((double)count.QuadPart / freq.QuadPart * 1E9);
+#else
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return (time_ns_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+    }
   protected:
     typedef std::basic_streambuf<_Elem, _Traits> super_t;
     typedef std::streamsize streamsize;
     typedef typename super_t::int_type int_type;
     handle_t handle;
+#ifdef _WIN32
     int_type in_buf;
     bool in_buf_ready;
+    time_ns_t arrival; ///< Arrival time of in_buf
+#else
+    _Elem in_block[0x1000 / sizeof(_Elem)]; ///< Get area, containing a chunk of the latest read()
+    time_ns_t arrival_current; ///< Arrival time of the chunk in the get area
+    time_ns_t arrival_previous; ///< Arrival time of the previous chunk
+#endif
     static handle_t spec2handle(const char *port_spec){
       std::string regular_name(port_spec);
 #ifdef _WIN32
@@ -100,8 +131,9 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
 #else
       // Port open
       handle_t res;
-      if((res = open(port_spec, O_RDWR | O_NOCTTY /*| O_NONBLOCK*/)) == -1){
+      if((res = open(port_spec, O_RDWR | O_NOCTTY | O_NONBLOCK)) == -1){
         // O_RDWR:For both read and write O_NOCTTY:No tty control
+        // O_NONBLOCK:Waiting for data is performed with poll()
         perror("open");
         throw std::ios_base::failure(std::string("Could not open ").append(port_spec));
       }
@@ -362,7 +394,7 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
       config_data.c_cflag |= (CLOCAL | CREAD);
       
       config_data.c_cc[VTIME] = 0;  // timer between two characters
-      config_data.c_cc[VMIN] = 1;   // blocking until n characters recption
+      config_data.c_cc[VMIN] = 1;   // blocking until n characters recption (ignored with O_NONBLOCK)
       
       tcsetattr(handle, TCSANOW, &config_data); // ݒۑ
       
@@ -404,7 +436,13 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
       return handle;
     }
     basic_ComportStreambuf(const char *port_spec)
-        : super_t(), handle(spec2handle(port_spec)), in_buf_ready(false) {
+        : super_t(), handle(spec2handle(port_spec)),
+#ifdef _WIN32
+        in_buf_ready(false), arrival(0) {
+#else
+        arrival_current(0), arrival_previous(0) {
+      this->setg(in_block, in_block, in_block);
+#endif
       config();
       clear_error();
     }
@@ -416,9 +454,9 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
 #endif
       //std::cerr << "~()" << std::endl;
     }
+#ifdef _WIN32
     void update_in_buf(){
       in_buf_ready = true;
-#ifdef _WIN32
       DWORD received;
       //static int seq_num(0);
       //seq_num++;
@@ -426,16 +464,75 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
       if(ReadFile(handle, (LPVOID)&in_buf, 1, &received, NULL)
           && (received > 0)){
         //std::cerr << "received!" << std::endl;
+        arrival = monotonic_ns();
         return;
       }
       //std::cerr << "return update_in_buf() : " << seq_num << std::endl;
+      in_buf = _Traits::eof();
+    }
+
+    /**
+     * Arrival time of the last read character
+     *
+     * @return (time_ns_t) time in monotonic_ns(), or 0 when nothing has been read
+     */
+    time_ns_t arrival_ns() const {
+      return arrival;
+    }
 #else
-      if(read(handle, (void *)&in_buf, 1)){
-        return;
-      }
+    /**
+     * Wait for arrival of data, and then read all available data at once
+     * to refill the get area.
+     *
+     * @return (bool) true when success, otherwise false, for example,
+     * when the port is closed.
+     */
+    bool update_in_buf(){
+      while(true){
+        ssize_t received(read(handle, (void *)in_block, sizeof(in_block)));
+        if(received > 0){
+          arrival_previous = arrival_current;
+          arrival_current = monotonic_ns();
+          this->setg(in_block, in_block, in_block + (received / sizeof(_Elem)));
+          return true;
+        }else if(received == 0){ // EOF
+          break;
+        }
+        switch(errno){
+          case EINTR:
+            continue;
+          case EAGAIN:
+#if defined(EWOULDBLOCK) && (EWOULDBLOCK != EAGAIN)
+          case EWOULDBLOCK:
 #endif
-      in_buf = _Traits::eof();
+            {
+              struct pollfd fds;
+              fds.fd = handle;
+              fds.events = POLLIN;
+              if((poll(&fds, 1, -1) < 0) && (errno != EINTR)){
+                perror("poll");
+                return false;
+              }
+            }
+            continue;
+        }
+        break; // Other errors, such as EIO of pty whose master side is closed
+      }
+      return false;
+    }
+
+    /**
+     * Arrival time of the last read character
+     *
+     * @return (time_ns_t) time in monotonic_ns(), or 0 when nothing has been read
+     */
+    time_ns_t arrival_ns() const {
+      // Because the get area is refilled after it has been consumed entirely,
+      // the last read character belongs to the previous chunk when no character
+      // of the current chunk has been read.
+      return (this->gptr() > this->eback()) ? arrival_current : arrival_previous;
     }
+#endif
     
   protected:
     
@@ -466,11 +563,11 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
       return comstat.cbInQue;
     }
 #else
-    /* TODO: unistd.h̒ᐅI/O̓obt@OȂ̂߁A
-     * streambuf̕Wł0Ԃł悢?
-     * @see http://sato-www.cs.titech.ac.jp/pro3/slides/unix2-4.pdf
-     * @see http://www.cplusplus.com/reference/iostream/streambuf/showmanyc/
-     */
+    streamsize showmanyc(){
+      int available(0);
+      if(ioctl(handle, FIONREAD, &available) == -1){return 0;}
+      return available;
+    }
 #endif
     
     /**
@@ -509,9 +606,15 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
         return true;
       }
 #else
-      if((c != _Traits::eof())
-          && write(handle, (const void *)&c, 1)){
-        return true;
+      while(c != _Traits::eof()){
+        if(write(handle, (const void *)&c, 1) > 0){
+          return true;
+        }
+        if((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)){break;}
+        struct pollfd fds;
+        fds.fd = handle;
+        fds.events = POLLOUT;
+        poll(&fds, 1, -1); // Wait until writable
       }
 #endif
       return (_Traits::eof());
@@ -619,8 +722,15 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
      */
     int_type underflow(){
       //std::cerr << "underflow()" << std::endl;
+#ifdef _WIN32
       if(!in_buf_ready){update_in_buf();}
       return in_buf;
+#else
+      if((this->gptr() < this->egptr()) || update_in_buf()){
+        return _Traits::to_int_type(*(this->gptr()));
+      }
+      return _Traits::eof();
+#endif
     }
     
     /**
@@ -654,11 +764,17 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
      * @return The new character available at the current get pointer position, 
      * if any. Otherwise, EOF (or [=traits::eof() for other traits) is returned. 
      */
+#ifdef _WIN32
     int_type uflow(){
       //std::cerr << "uflow()" << std::endl;
       update_in_buf();
       return in_buf;
     }
+#else
+    /* The default uflow() of std::streambuf, which advances the get pointer
+     * after underflow(), is used with the get area.
+     */
+#endif
 };
 
 template<
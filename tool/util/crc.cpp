@@ -30,8 +30,39 @@
  */
 
 #include "crc.h"
+
+/**
+ * Tables for slice-by-8 calculation, where table[k][i] is CRC of byte i followed by k zero bytes.
+ */
+struct CRC16_SliceBy8 {
+  Uint16 table[8][0x100];
+  CRC16_SliceBy8(){
+    for(int i(0); i < 0x100; ++i){
+      table[0][i] = CRC16::crc16_table[i];
+    }
+    for(int k(1); k < 8; ++k){
+      for(int i(0); i < 0x100; ++i){
+        Uint16 crc(table[k - 1][i]);
+        table[k][i] = CRC16::crc16_table[crc >> 8] ^ (Uint16)(crc << 8);
+      }
+    }
+  }
+  static const CRC16_SliceBy8 &get(){
+    static const CRC16_SliceBy8 instance;
+    return instance;
+  }
+};
  
 Uint16 CRC16::crc16(const unsigned char *buf, int size, Uint16 crc){
+  if(size >= 8){
+    const Uint16 (&t)[8][0x100](CRC16_SliceBy8::get().table);
+    for(; size >= 8; size -= 8, buf += 8){
+      crc = t[7][(crc >> 8) ^ buf[0]] ^ t[6][(crc & 0xFF) ^ buf[1]]
+          ^ t[5][buf[2]] ^ t[4][buf[3]]
+          ^ t[3][buf[4]] ^ t[2][buf[5]]
+          ^ t[1][buf[6]] ^ t[0][buf[7]];
+    }
+  }
   while(size--){
     crc = crc16_table[(crc >> 8) ^ *(buf++)] ^ (crc << 8);
   }
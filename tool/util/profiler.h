@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+/** @file
+ * @brief Lightweight per-stage profiler with scoped timers
+ *
+ * Usage:
+ *   PROFILER_SCOPE("stage name");
+ * measures the time from the statement to the end of the enclosing block.
+ * Scopes can be nested; the time of inner scopes is excluded from the self time of
+ * outer scopes. The macro is expanded to nothing unless ENABLE_PROFILER is defined
+ * as non-zero, and its measurement is skipped unless Profiler::get().active is true.
+ *
+ * The time stamp source is TSC on x86, std::chrono::steady_clock when C++11
+ * is available, otherwise std::clock(). Ticks are converted to nanoseconds
+ * with the reference clock over the whole measurement period.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstring>
+#include <ctime>
+
+#if defined(__cplusplus) && (__cplusplus >= 201103L)
+#include <chrono>
+#endif
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#define PROFILER_USE_TSC 1
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define PROFILER_USE_TSC 1
+#endif
+
+class Profiler {
+  public:
+    typedef unsigned long long tick_t;
+
+    static const int histogram_bins = 48; ///< bin[i] counts durations in [2^i, 2^(i+1)) ticks
+
+    struct stage_t {
+      const char *name;
+      unsigned long count;
+      tick_t total, self, min, max;
+      unsigned long histogram[histogram_bins];
+      stage_t(const char *_name)
+          : name(_name), count(0), total(0), self(0), min(~(tick_t)0), max(0) {
+        for(int i(0); i < histogram_bins; ++i){histogram[i] = 0;}
+      }
+      void add(const tick_t &elapsed, const tick_t &children){
+        ++count;
+        total += elapsed;
+        self += ((elapsed > children) ? (elapsed - children) : 0);
+        if(elapsed < min){min = elapsed;}
+        if(elapsed > max){max = elapsed;}
+        int bin(0);
+        for(tick_t v(elapsed >> 1); (v > 0) && (bin < (histogram_bins - 1)); v >>= 1, ++bin);
+        ++histogram[bin];
+      }
+      /**
+       * Approximated percentile, which returns the upper bound of the corresponding bin
+       *
+       * @param ratio in [0, 1]
+       */
+      tick_t percentile(const double &ratio) const {
+        unsigned long threshold((unsigned long)(ratio * count)), sum(0);
+        for(int i(0); i < histogram_bins; ++i){
+          if((sum += histogram[i]) > threshold){return ((tick_t)1 << (i + 1)) - 1;}
+        }
+        return max;
+      }
+    };
+
+    /**
+     * Current time stamp in ticks
+     */
+    static tick_t tick(){
+#if defined(PROFILER_USE_TSC)
+      return __rdtsc();
+#else
+      return reference_ns();
+#endif
+    }
+
+    /**
+     * Reference clock in nanoseconds
+     */
+    static tick_t reference_ns(){
+#if defined(__cplusplus) && (__cplusplus >= 201103L)
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+      return (tick_t)std::clock() * (1000000000 / CLOCKS_PER_SEC);
+#endif
+    }
+
+    class Scope {
+      protected:
+        stage_t *stage;
+        Scope *parent;
+        tick_t t_start, children;
+      public:
+        Scope(stage_t *_stage) : stage(NULL) {
+          Profiler &prof(get());
+          if(!prof.active){return;}
+          stage = _stage;
+          parent = prof.current;
+          prof.current = this;
+          children = 0;
+          t_start = tick();
+        }
+        ~Scope(){
+          if(!stage){return;}
+          tick_t elapsed(tick() - t_start);
+          stage->add(elapsed, children);
+          if(parent){parent->children += elapsed;}
+          get().current = parent;
+        }
+    };
+
+  protected:
+    typedef std::vector<stage_t *> stages_t;
+    stages_t stages;
+    Scope *current;
+    tick_t tick_start, ref_start;
+
+    Profiler() : stages(), current(NULL), tick_start(0), ref_start(0), active(false) {}
+    ~Profiler(){
+      for(stages_t::iterator it(stages.begin()), it_end(stages.end()); it != it_end; ++it){
+        delete *it;
+      }
+    }
+
+  public:
+    bool active;
+
+    static Profiler &get(){
+      static Profiler profiler;
+      return profiler;
+    }
+
+    /**
+     * Register a stage. The returned object lives until the end of the program.
+     */
+    static stage_t *stage(const char *name){
+      stages_t &stages(get().stages);
+      for(stages_t::iterator it(stages.begin()), it_end(stages.end()); it != it_end; ++it){
+        if(std::strcmp((*it)->name, name) == 0){return *it;}
+      }
+      stages.push_back(new stage_t(name));
+      return stages.back();
+    }
+
+    void start(){
+      active = true;
+      tick_start = tick();
+      ref_start = reference_ns();
+    }
+
+    /**
+     * @return nanoseconds per tick estimated from the elapsed time since start()
+     */
+    double ns_per_tick() const {
+#if defined(PROFILER_USE_TSC)
+      tick_t ticks(tick() - tick_start), ns(reference_ns() - ref_start);
+      return ((ticks > 0) && (ns > 0)) ? ((double)ns / ticks) : 0;
+#else
+      return 1;
+#endif
+    }
+
+    static tick_t to_ns(const double &sf, const double &ticks){
+      return (tick_t)(sf * ticks + 0.5);
+    }
+
+    /**
+     * Print summary in text
+     */
+    void print(std::ostream &out) const {
+      double sf(ns_per_tick());
+      out << "=== Profile (time in [ns], self excludes nested stages) ===" << std::endl;
+      for(stages_t::const_iterator it(stages.begin()), it_end(stages.end()); it != it_end; ++it){
+        const stage_t &s(**it);
+        if(s.count == 0){continue;}
+        out << s.name << ": count " << s.count
+            << ", total " << to_ns(sf, s.total)
+            << ", self " << to_ns(sf, s.self)
+            << ", mean " << to_ns(sf, (double)s.total / s.count)
+            << ", min " << to_ns(sf, s.min)
+            << ", p50 " << to_ns(sf, s.percentile(0.5))
+            << ", p99 " << to_ns(sf, s.percentile(0.99))
+            << ", max " << to_ns(sf, s.max) << std::endl;
+        out << "  histogram(<=ns:count)";
+        for(int i(0); i < histogram_bins; ++i){
+          if(s.histogram[i] == 0){continue;}
+          out << " " << to_ns(sf, ((tick_t)1 << (i + 1)) - 1) << ":" << s.histogram[i];
+        }
+        out << std::endl;
+      }
+    }
+
+    /**
+     * Print summary in JSON
+     */
+    void print_json(std::ostream &out) const {
+      double sf(ns_per_tick());
+      out << "{\"unit\": \"ns\", \"stages\": [";
+      bool first(true);
+      for(stages_t::const_iterator it(stages.begin()), it_end(stages.end()); it != it_end; ++it){
+        const stage_t &s(**it);
+        if(s.count == 0){continue;}
+        out << (first ? "" : ",") << std::endl
+            << "  {\"name\": \"" << s.name << "\""
+            << ", \"count\": " << s.count
+            << ", \"total\": " << to_ns(sf, s.total)
+            << ", \"self\": " << to_ns(sf, s.self)
+            << ", \"min\": " << to_ns(sf, s.min)
+            << ", \"max\": " << to_ns(sf, s.max)
+            << ", \"histogram\": [";
+        first = false;
+        bool first_bin(true);
+        for(int i(0); i < histogram_bins; ++i){
+          if(s.histogram[i] == 0){continue;}
+          out << (first_bin ? "" : ", ")
+              << "[" << to_ns(sf, ((tick_t)1 << (i + 1)) - 1) << ", " << s.histogram[i] << "]";
+          first_bin = false;
+        }
+        out << "]}";
+      }
+      out << std::endl << "]}" << std::endl;
+    }
+};
+
+#undef PROFILER_SCOPE // may be defined as a fallback in other headers
+#if defined(ENABLE_PROFILER) && ENABLE_PROFILER
+#define PROFILER_CONCAT2(a, b) a ## b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT2(a, b)
+#define PROFILER_SCOPE(name) \
+  static Profiler::stage_t *PROFILER_CONCAT(profiler_stage_, __LINE__)(Profiler::stage(name)); \
+  Profiler::Scope PROFILER_CONCAT(profiler_scope_, __LINE__)(PROFILER_CONCAT(profiler_stage_, __LINE__))
+#else
+#define PROFILER_SCOPE(name)
+#endif
+
+#endif /* __PROFILER_H__ */
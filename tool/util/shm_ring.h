@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __SHM_RING_H__
+#define __SHM_RING_H__
+
+/** @file
+ * @brief Single-writer/multi-reader ring of fixed size records on POSIX shared memory
+ *
+ * The shared memory consists of a header and slots, each of which has a sequence counter,
+ * a time stamp of publication, and a record. The writer never waits for readers;
+ * a record being overwritten is detected by a reader with the sequence counter (seqlock),
+ * and is counted as lost. The writer does not remove the shared memory at its end
+ * in order that a late reader can get the last records. It can be removed with shm_unlink(),
+ * or /dev/shm/(name) on Linux.
+ *
+ * Writer:
+ *   SharedMemoryRing<record_t>::Writer writer("/name", capacity);
+ *   writer.slot() = record; writer.commit(); // or writer.publish(record);
+ * Reader:
+ *   SharedMemoryRing<record_t>::Reader reader("/name");
+ *   record_t record;
+ *   while(reader.is_open()){
+ *     if(reader.read(record)){(use record);}else if(reader.closed()){break;}
+ *   }
+ *
+ * RecordT must be trivially copyable, and should consist of fixed size members.
+ */
+
+#include <cstddef>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#define SHM_RING_AVAILABLE 1
+#endif
+
+template <class RecordT>
+struct SharedMemoryRing {
+  typedef RecordT record_t;
+  typedef unsigned int seq_t;
+  typedef unsigned long long time_ns_t;
+
+  struct header_t {
+    char magic[8];
+    unsigned int record_size; ///< sizeof(RecordT), used to check compatibility
+    unsigned int capacity; ///< number of slots
+    seq_t written; ///< number of published records, which wraps around
+    seq_t closed; ///< non-zero after the writer has finished
+  };
+  struct slot_t {
+    seq_t seq; ///< 2n + 1 while the n-th record is written, 2n + 2 after written
+    seq_t reserved;
+    time_ns_t published_ns; ///< CLOCK_MONOTONIC at publication
+    RecordT record;
+  };
+
+  static const char *magic(){return "SHMRING";}
+
+  static std::size_t mapped_size(const unsigned int &capacity){
+    return sizeof(header_t) + sizeof(slot_t) * capacity;
+  }
+
+  static time_ns_t monotonic_ns(){
+#if defined(SHM_RING_AVAILABLE)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (time_ns_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#else
+    return 0;
+#endif
+  }
+
+#if defined(SHM_RING_AVAILABLE) // GCC atomic builtins, which are also available for C++98
+  static seq_t load(const seq_t &v){return __atomic_load_n(&v, __ATOMIC_RELAXED);}
+  static seq_t load_acquire(const seq_t &v){return __atomic_load_n(&v, __ATOMIC_ACQUIRE);}
+  static void store(seq_t &v, const seq_t &x){__atomic_store_n(&v, x, __ATOMIC_RELAXED);}
+  static void store_release(seq_t &v, const seq_t &x){__atomic_store_n(&v, x, __ATOMIC_RELEASE);}
+  static void fence_acquire(){__atomic_thread_fence(__ATOMIC_ACQUIRE);}
+  static void fence_release(){__atomic_thread_fence(__ATOMIC_RELEASE);}
+#else // unused, because shared memory cannot be opened
+  static seq_t load(const seq_t &v){return v;}
+  static seq_t load_acquire(const seq_t &v){return v;}
+  static void store(seq_t &v, const seq_t &x){v = x;}
+  static void store_release(seq_t &v, const seq_t &x){v = x;}
+  static void fence_acquire(){}
+  static void fence_release(){}
+#endif
+
+  class Mapping {
+    protected:
+      void *addr;
+      std::size_t size;
+      Mapping(const Mapping &);
+      Mapping &operator=(const Mapping &);
+    public:
+      Mapping() : addr(NULL), size(0) {}
+      ~Mapping(){unmap();}
+      bool map(const char *name, const bool &writable, const std::size_t &_size = 0){
+        unmap();
+#if defined(SHM_RING_AVAILABLE)
+        int fd(shm_open(name, writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644));
+        if(fd < 0){return false;}
+        std::size_t size_new(_size);
+        if(writable){
+          if(ftruncate(fd, (off_t)size_new) != 0){close(fd); return false;}
+        }else{
+          struct stat st;
+          if((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(header_t))){
+            close(fd); return false;
+          }
+          size_new = (std::size_t)st.st_size;
+        }
+        void *res(mmap(NULL, size_new,
+            writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0));
+        close(fd);
+        if(res == MAP_FAILED){return false;}
+        addr = res;
+        size = size_new;
+        return true;
+#else
+        return false;
+#endif
+      }
+      void unmap(){
+#if defined(SHM_RING_AVAILABLE)
+        if(addr){munmap(addr, size);}
+#endif
+        addr = NULL;
+        size = 0;
+      }
+      void *get() const {return addr;}
+      const std::size_t &mapped() const {return size;}
+  };
+
+  class Writer {
+    protected:
+      Mapping mapping;
+      header_t *header;
+      slot_t *slots;
+      seq_t index;
+    public:
+      /**
+       * Create or reset a shared memory
+       *
+       * @param name name of shared memory, which begins with '/'
+       * @param capacity number of slots
+       */
+      Writer(const char *name, const unsigned int &capacity = 0x100)
+          : mapping(), header(NULL), slots(NULL), index(0) {
+        if((capacity == 0) || !mapping.map(name, true, mapped_size(capacity))){return;}
+        header = static_cast<header_t *>(mapping.get());
+        slots = reinterpret_cast<slot_t *>(header + 1);
+        std::memset(slots, 0, sizeof(slot_t) * capacity);
+        header->record_size = sizeof(RecordT);
+        header->capacity = capacity;
+        store_release(header->closed, 0);
+        store_release(header->written, 0);
+        fence_release();
+        std::memcpy(header->magic, magic(), sizeof(header->magic)); // valid after this
+      }
+      ~Writer(){close();}
+      bool is_open() const {return header != NULL;}
+
+      /**
+       * @return (RecordT &) slot for the next record, which is invisible to readers until commit()
+       */
+      RecordT &slot(){
+        slot_t &s(slots[index % header->capacity]);
+        store(s.seq, index * 2 + 1);
+        fence_release(); // the above must precede writing the record
+        return s.record;
+      }
+      void commit(){
+        slot_t &s(slots[index % header->capacity]);
+        s.published_ns = monotonic_ns();
+        store_release(s.seq, index * 2 + 2);
+        store_release(header->written, ++index);
+      }
+      void publish(const RecordT &record){
+        slot() = record;
+        commit();
+      }
+      /**
+       * Notify readers that no more record will be published
+       */
+      void close(){
+        if(header){store_release(header->closed, 1);}
+      }
+  };
+
+  class Reader {
+    protected:
+      Mapping mapping;
+      const header_t *header;
+      const slot_t *slots;
+      seq_t index;
+      unsigned long long lost_records;
+    public:
+      /**
+       * Attach to a shared memory created by a writer
+       *
+       * @param name name of shared memory
+       * @param from_oldest when true, records already in the ring are read first,
+       * otherwise only the records published after this call are read.
+       */
+      Reader(const char *name, const bool &from_oldest = false)
+          : mapping(), header(NULL), slots(NULL), index(0), lost_records(0) {
+        if(!mapping.map(name, false)){return;}
+        const header_t *h(static_cast<const header_t *>(mapping.get()));
+        bool valid(std::memcmp(h->magic, magic(), sizeof(h->magic)) == 0);
+        fence_acquire();
+        if((!valid)
+            || (h->record_size != sizeof(RecordT))
+            || (h->capacity == 0)
+            || (mapping.mapped() < mapped_size(h->capacity))){
+          mapping.unmap();
+          return;
+        }
+        header = h;
+        slots = reinterpret_cast<const slot_t *>(header + 1);
+        index = load_acquire(header->written);
+        if(from_oldest){index -= ((index > header->capacity) ? header->capacity : index);}
+      }
+      bool is_open() const {return header != NULL;}
+      /**
+       * @return (bool) true when the writer has finished, and all the records have been read
+       */
+      bool closed() const {
+        return (load_acquire(header->closed) != 0) && (available() == 0);
+      }
+
+      /**
+       * @return (unsigned long long) number of records overwritten before being read
+       */
+      const unsigned long long &lost() const {return lost_records;}
+
+      /**
+       * @return (seq_t) number of records which can be read now, which may be larger than capacity
+       */
+      seq_t available() const {
+        return load_acquire(header->written) - index;
+      }
+
+      /**
+       * Read the next record
+       *
+       * @param record destination
+       * @param published_ns time stamp of publication, optional
+       * @return (bool) true when a record has been read, false when no record is available.
+       */
+      bool read(RecordT &record, time_ns_t *published_ns = NULL){
+        while(true){
+          seq_t written(load_acquire(header->written));
+          if((int)(written - index) < 0){index = written;} // writer restarted
+          if(written == index){return false;}
+          if(written - index > header->capacity){ // overrun
+            lost_records += (written - index - header->capacity);
+            index = written - header->capacity;
+          }
+          const slot_t &s(slots[index % header->capacity]);
+          seq_t seq(load_acquire(s.seq));
+          if(seq == index * 2 + 2){
+            std::memcpy(&record, (const void *)&s.record, sizeof(RecordT));
+            time_ns_t t(s.published_ns);
+            fence_acquire();
+            if(load(s.seq) == seq){
+              ++index;
+              if(published_ns){*published_ns = t;}
+              return true;
+            }
+          }
+          // overwritten while reading
+          ++lost_records;
+          ++index;
+        }
+      }
+
+      /**
+       * Skip to the latest record and read it
+       *
+       * @return (bool) true when a record has been read
+       */
+      bool latest(RecordT &record, time_ns_t *published_ns = NULL){
+        seq_t written(load_acquire(header->written));
+        if(written == index){return false;}
+        index = written - 1;
+        return read(record, published_ns);
+      }
+  };
+};
+
+#endif /* __SHM_RING_H__ */
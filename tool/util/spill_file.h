@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __SPILL_FILE_H__
+#define __SPILL_FILE_H__
+
+/** @file
+ * @brief Growable byte array backed by a memory-mapped file
+ *
+ * It keeps data larger than the physical memory, such as the whole results of
+ * a forward filter pass, because the kernel writes the mapped pages back to the file
+ * and reads them again on demand. The file is extended by doubling, and remapped;
+ * therefore pointers obtained with data() are invalidated by resize().
+ * When the file name is omitted, an anonymous temporary file is created in $TMPDIR or /tmp,
+ * which is removed at once and released at close().
+ * Where mmap() is unavailable, the data is held in the heap instead.
+ *
+ * Usage:
+ *   SpillFile spill;
+ *   if(spill.open()){spill.resize(size); std::memcpy(spill.data(), src, size);}
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define SPILL_FILE_USE_MMAP 1
+#else
+#include <vector>
+#endif
+
+class SpillFile {
+  protected:
+    char *head;
+    std::size_t used, capacity;
+#if defined(SPILL_FILE_USE_MMAP)
+    int fd;
+#else
+    std::vector<char> buf;
+#endif
+
+    SpillFile(const SpillFile &);
+    SpillFile &operator=(const SpillFile &);
+
+    bool reserve(const std::size_t &size){
+      if(size <= capacity){return true;}
+      std::size_t next(capacity > 0 ? capacity : 0x100000);
+      while(next < size){next *= 2;}
+#if defined(SPILL_FILE_USE_MMAP)
+      if(fd < 0){return false;}
+      if(ftruncate(fd, (off_t)next) != 0){return false;}
+      if(head){munmap(head, capacity);}
+      void *p(mmap(NULL, next, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+      if(p == MAP_FAILED){
+        head = NULL;
+        used = capacity = 0;
+        return false;
+      }
+      head = static_cast<char *>(p);
+#else
+      try{
+        buf.resize(next);
+      }catch(...){return false;}
+      head = &buf[0];
+#endif
+      capacity = next;
+      return true;
+    }
+
+  public:
+#if defined(SPILL_FILE_USE_MMAP)
+    SpillFile() : head(NULL), used(0), capacity(0), fd(-1) {}
+#else
+    SpillFile() : head(NULL), used(0), capacity(0), buf() {}
+#endif
+    ~SpillFile(){close();}
+
+    /**
+     * Create a spill file
+     *
+     * @param fname file name, which is truncated. NULL means an anonymous temporary file.
+     * @return (bool) true when success, otherwise false.
+     */
+    bool open(const char *fname = NULL){
+      close();
+#if defined(SPILL_FILE_USE_MMAP)
+      if(fname){
+        fd = ::open(fname, O_RDWR | O_CREAT | O_TRUNC, 0644);
+      }else{
+        const char *dir(std::getenv("TMPDIR"));
+        std::string path((dir && dir[0]) ? dir : "/tmp");
+        path.append("/spill_XXXXXX");
+        if((fd = mkstemp(&path[0])) >= 0){unlink(path.c_str());}
+      }
+      return fd >= 0;
+#else
+      return true;
+#endif
+    }
+
+    void close(){
+#if defined(SPILL_FILE_USE_MMAP)
+      if(head){munmap(head, capacity);}
+      if(fd >= 0){::close(fd);}
+      fd = -1;
+#else
+      std::vector<char>().swap(buf);
+#endif
+      head = NULL;
+      used = capacity = 0;
+    }
+
+    /**
+     * Change the size of the data, which is extended when required.
+     *
+     * @return (bool) true when success, otherwise false, for example, the disk is full.
+     */
+    bool resize(const std::size_t &size){
+      if(!reserve(size)){return false;}
+      used = size;
+      return true;
+    }
+
+    std::size_t size() const {return used;}
+    char *data() {return head;}
+    const char *data() const {return head;}
+};
+
+#endif /* __SPILL_FILE_H__ */
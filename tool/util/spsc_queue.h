@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __SPSC_QUEUE_H__
+#define __SPSC_QUEUE_H__
+
+/** @file
+ * @brief Bounded lock-free single-producer/single-consumer queue
+ *
+ * Slots are allocated in advance, and the producer and the consumer access them in place;
+ *   producer: if(T *slot = q.write_slot(policy)){(fill *slot); q.commit();}
+ *   consumer: while(const T *slot = q.read_slot()){(use *slot); q.release();}
+ * where read_slot() returns NULL after the producer has called close() and all items
+ * have been consumed, and write_slot() returns NULL when the queue is full under DROP policy,
+ * or after the consumer has called cancel().
+ * Each side waits with spinning, yielding, and then sleeping.
+ *
+ * The indices are synchronized with acquire/release operations of std::atomic when C++11
+ * is available, otherwise GCC atomic builtins (or volatile for old MSVC).
+ */
+
+#include <cstddef>
+
+#if (defined(__cplusplus) && (__cplusplus >= 201103L)) \
+    || (defined(_MSC_VER) && (_MSC_VER >= 1700))
+#include <atomic>
+#define SPSC_QUEUE_USE_STD_ATOMIC 1
+#endif
+
+#include "util/thread.h"
+
+struct SPSC_QueueStats {
+  unsigned int capacity;
+  unsigned int depth_max; ///< maximum number of stored items including the pushed one
+  unsigned long long pushed, dropped;
+  unsigned long long depth_total; ///< sum of depth at push
+  unsigned long producer_waits, consumer_waits; ///< number of waits for a slot or an item
+  SPSC_QueueStats()
+      : capacity(0), depth_max(0), pushed(0), dropped(0), depth_total(0),
+      producer_waits(0), consumer_waits(0) {}
+  double depth_mean() const {
+    return pushed > 0 ? ((double)depth_total / pushed) : 0;
+  }
+};
+
+template <class T>
+class SPSC_Queue {
+  public:
+    typedef unsigned int index_t;
+    typedef T value_t;
+
+    enum policy_t {
+      BLOCK, ///< producer waits for a free slot
+      DROP ///< newest item is discarded when full
+    };
+
+    typedef SPSC_QueueStats stats_t;
+
+  protected:
+#if defined(SPSC_QUEUE_USE_STD_ATOMIC)
+    typedef std::atomic<index_t> atomic_index_t;
+    static index_t load_acquire(const atomic_index_t &v){
+      return v.load(std::memory_order_acquire);
+    }
+    static void store_release(atomic_index_t &v, const index_t &x){
+      v.store(x, std::memory_order_release);
+    }
+#elif defined(_MSC_VER) // volatile has acquire/release semantics on x86
+    typedef volatile index_t atomic_index_t;
+    static index_t load_acquire(const atomic_index_t &v){return v;}
+    static void store_release(atomic_index_t &v, const index_t &x){v = x;}
+#else
+    typedef index_t atomic_index_t;
+    static index_t load_acquire(const atomic_index_t &v){
+      return __atomic_load_n(&v, __ATOMIC_ACQUIRE);
+    }
+    static void store_release(atomic_index_t &v, const index_t &x){
+      __atomic_store_n(&v, x, __ATOMIC_RELEASE);
+    }
+#endif
+    static const std::size_t cache_line = 64;
+
+    T *slots;
+    index_t mask;
+
+    // owned by the producer
+    char pad_producer[cache_line];
+    atomic_index_t tail;
+    index_t tail_local, head_cached;
+    stats_t stats_producer;
+
+    // owned by the consumer
+    char pad_consumer[cache_line];
+    atomic_index_t head;
+    index_t head_local, tail_cached;
+    unsigned long consumer_waits;
+
+    char pad_flags[cache_line];
+    atomic_index_t closed, cancelled;
+
+    static index_t round_up(const index_t &capacity){
+      index_t res(2);
+      while((res < capacity) && (res < ((index_t)1 << 30))){res <<= 1;}
+      return res;
+    }
+
+    /**
+     * Back off step by step
+     *
+     * @param count number of previous trials, which is incremented
+     */
+    static void wait(unsigned int &count){
+      if(count < 0x40){
+        // spin
+      }else if(count < 0x80){
+        Thread::yield();
+      }else{
+        Thread::sleep_us(50);
+        return;
+      }
+      ++count;
+    }
+
+    SPSC_Queue(const SPSC_Queue &);
+    SPSC_Queue &operator=(const SPSC_Queue &);
+
+  public:
+    /**
+     * @param capacity maximum number of items, which is rounded up to a power of 2
+     */
+    SPSC_Queue(const index_t &capacity)
+        : slots(NULL), mask(round_up(capacity) - 1),
+        tail(0), tail_local(0), head_cached(0), stats_producer(),
+        head(0), head_local(0), tail_cached(0), consumer_waits(0),
+        closed(0), cancelled(0) {
+      slots = new T[mask + 1];
+      stats_producer.capacity = mask + 1;
+    }
+    ~SPSC_Queue(){
+      delete [] slots;
+    }
+
+    index_t capacity() const {return mask + 1;}
+
+    /**
+     * @return number of items at the moment, which may be changed immediately
+     */
+    index_t size() const {
+      return load_acquire(tail) - load_acquire(head);
+    }
+
+    /**
+     * Statistics, which should be read after both of the producer and the consumer are stopped
+     */
+    stats_t stats() const {
+      stats_t res(stats_producer);
+      res.consumer_waits = consumer_waits;
+      return res;
+    }
+
+    // Producer side
+
+    /**
+     * @return (T *) free slot, or NULL when full
+     */
+    T *try_write_slot(){
+      if(tail_local - head_cached > mask){
+        head_cached = load_acquire(head);
+        if(tail_local - head_cached > mask){return NULL;}
+      }
+      return &slots[tail_local & mask];
+    }
+
+    /**
+     * @param policy action when full
+     * @return (T *) free slot, or NULL when the item should be discarded
+     */
+    T *write_slot(const policy_t &policy = BLOCK){
+      T *res(try_write_slot());
+      if(res){return res;}
+      if(policy == DROP){
+        ++stats_producer.dropped;
+        return NULL;
+      }
+      ++stats_producer.producer_waits;
+      for(unsigned int count(0); !(res = try_write_slot()); wait(count)){
+        if(load_acquire(cancelled)){return NULL;}
+      }
+      return res;
+    }
+
+    /**
+     * Publish the slot returned by write_slot() to the consumer
+     */
+    void commit(){
+      index_t depth(tail_local + 1 - load_acquire(head));
+      ++stats_producer.pushed;
+      stats_producer.depth_total += depth;
+      if(depth > stats_producer.depth_max){stats_producer.depth_max = depth;}
+      store_release(tail, ++tail_local);
+    }
+
+    /**
+     * Copy an item into the queue
+     *
+     * @return (bool) true when pushed, false when discarded
+     */
+    bool push(const T &item, const policy_t &policy = BLOCK){
+      T *slot(write_slot(policy));
+      if(!slot){return false;}
+      *slot = item;
+      commit();
+      return true;
+    }
+
+    /**
+     * Notify the consumer that no more item will be pushed
+     */
+    void close(){store_release(closed, 1);}
+
+    bool is_cancelled() const {return load_acquire(cancelled) != 0;}
+
+    // Consumer side
+
+    /**
+     * @return (T *) the oldest item, or NULL when empty
+     */
+    T *try_read_slot(){
+      if(head_local == tail_cached){
+        tail_cached = load_acquire(tail);
+        if(head_local == tail_cached){return NULL;}
+      }
+      return &slots[head_local & mask];
+    }
+
+    /**
+     * Wait for an item
+     *
+     * @return (T *) the oldest item, or NULL when the queue is empty and closed
+     */
+    T *read_slot(){
+      T *res(try_read_slot());
+      if(res){return res;}
+      ++consumer_waits;
+      for(unsigned int count(0); !(res = try_read_slot()); wait(count)){
+        if(load_acquire(closed)){return try_read_slot();} // check again for the last item
+      }
+      return res;
+    }
+
+    /**
+     * Return the slot returned by read_slot() to the producer
+     */
+    void release(){
+      store_release(head, ++head_local);
+    }
+
+    /**
+     * Notify the producer that no more item will be consumed
+     */
+    void cancel(){store_release(cancelled, 1);}
+
+    bool is_closed() const {return load_acquire(closed) != 0;}
+};
+
+#endif /* __SPSC_QUEUE_H__ */
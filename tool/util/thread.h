@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __THREAD_H__
+#define __THREAD_H__
+
+/** @file
+ * @brief Minimal portable thread
+ *
+ * Usage: derive Thread, implement run(), and then call start() and join().
+ * The backend is std::thread when C++11 is available, otherwise pthread or Win32 API.
+ * When none of them is available, start() returns false, and the caller is expected
+ * to perform the same job without thread.
+ */
+
+#if (defined(__cplusplus) && (__cplusplus >= 201103L)) \
+    || (defined(_MSC_VER) && (_MSC_VER >= 1700))
+#include <thread>
+#include <chrono>
+#define THREAD_USE_STD 1
+#elif defined(_WIN32)
+#include <windows.h>
+#define THREAD_USE_WIN32 1
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#define THREAD_USE_PTHREAD 1
+#endif
+
+#include <cstddef>
+
+class Thread {
+  protected:
+#if defined(THREAD_USE_STD)
+    std::thread *handle;
+#elif defined(THREAD_USE_WIN32)
+    HANDLE handle;
+    static DWORD WINAPI entry(LPVOID arg){
+      static_cast<Thread *>(arg)->run();
+      return 0;
+    }
+#elif defined(THREAD_USE_PTHREAD)
+    pthread_t handle;
+    static void *entry(void *arg){
+      static_cast<Thread *>(arg)->run();
+      return NULL;
+    }
+#endif
+    bool running;
+
+    Thread(const Thread &);
+    Thread &operator=(const Thread &);
+
+  public:
+#if defined(THREAD_USE_STD) || defined(THREAD_USE_WIN32)
+    Thread() : handle(NULL), running(false) {}
+#else
+    Thread() : handle(), running(false) {}
+#endif
+    virtual ~Thread(){join();}
+
+    /**
+     * Body of the thread
+     */
+    virtual void run() = 0;
+
+    /**
+     * @return (bool) true when thread is supported
+     */
+    static bool available(){
+#if defined(THREAD_USE_STD) || defined(THREAD_USE_WIN32) || defined(THREAD_USE_PTHREAD)
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    /**
+     * Invoke run() in a new thread
+     *
+     * @return (bool) true when success, otherwise false.
+     */
+    bool start(){
+      if(running){return false;}
+#if defined(THREAD_USE_STD)
+      try{
+        handle = new std::thread(&Thread::run, this);
+        running = true;
+      }catch(...){}
+#elif defined(THREAD_USE_WIN32)
+      running = ((handle = CreateThread(NULL, 0, entry, this, 0, NULL)) != NULL);
+#elif defined(THREAD_USE_PTHREAD)
+      running = (pthread_create(&handle, NULL, entry, this) == 0);
+#endif
+      return running;
+    }
+
+    /**
+     * Wait for the end of run(). It does nothing unless started.
+     */
+    void join(){
+      if(!running){return;}
+#if defined(THREAD_USE_STD)
+      handle->join();
+      delete handle;
+      handle = NULL;
+#elif defined(THREAD_USE_WIN32)
+      WaitForSingleObject(handle, INFINITE);
+      CloseHandle(handle);
+      handle = NULL;
+#elif defined(THREAD_USE_PTHREAD)
+      pthread_join(handle, NULL);
+#endif
+      running = false;
+    }
+
+    /**
+     * Give the processor to other threads
+     */
+    static void yield(){
+#if defined(THREAD_USE_STD)
+      std::this_thread::yield();
+#elif defined(THREAD_USE_WIN32)
+      SwitchToThread();
+#elif defined(THREAD_USE_PTHREAD)
+      sched_yield();
+#endif
+    }
+
+    /**
+     * Suspend the calling thread
+     *
+     * @param us duration in microseconds
+     */
+    static void sleep_us(const unsigned int &us){
+#if defined(THREAD_USE_STD)
+      std::this_thread::sleep_for(std::chrono::microseconds(us));
+#elif defined(THREAD_USE_WIN32)
+      Sleep((us + 999) / 1000);
+#elif defined(THREAD_USE_PTHREAD)
+      struct timespec ts = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+      nanosleep(&ts, NULL);
+#endif
+    }
+};
+
+#endif /* __THREAD_H__ */
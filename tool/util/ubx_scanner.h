@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2019, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __UBX_SCANNER_H__
+#define __UBX_SCANNER_H__
+
+/** @file
+ * @brief UBX frame scanner on a contiguous byte stream
+ *
+ * It follows the resync rule of G_Packet_Observer in SylphideProcessor.h;
+ * when 0xB5 is not followed by 0x62, both bytes are skipped,
+ * and a frame is limited to a half of the observer buffer.
+ * Therefore, the frames found by the scanner are the same as those of G_Packet_Observer,
+ * while the stream is appended in large blocks.
+ *
+ * Usage:
+ *   struct Handler : public UBX_Scanner {
+ *     Handler() : UBX_Scanner(0x10000, 0x1000) {}
+ *     bool frame(const unsigned char *packet, const unsigned int &size){...; return true;}
+ *   } handler;
+ *   handler.append(data, size);
+ */
+
+#include <vector>
+#include <cstring>
+
+class UBX_Scanner {
+  protected:
+    std::vector<char> buf;
+    unsigned int stored;
+    unsigned int max_frame_size;
+
+  public:
+    /**
+     * @param capacity size of the internal buffer, which must be larger than max_frame
+     * @param max_frame maximum frame size, which corresponds to a half of the size of G_Packet_Observer
+     */
+    UBX_Scanner(const unsigned int &capacity, const unsigned int &max_frame)
+        : buf(capacity), stored(0), max_frame_size(max_frame) {}
+    virtual ~UBX_Scanner(){}
+
+    static unsigned int le_u16(const unsigned char *buf){
+      return (unsigned int)buf[0] | ((unsigned int)buf[1] << 8);
+    }
+    static unsigned int le_u32(const unsigned char *buf){
+      return le_u16(buf) | (le_u16(buf + 2) << 16);
+    }
+
+  protected:
+    /**
+     * Called with a frame whose checksum is valid
+     *
+     * @return (bool) false to stop scanning
+     */
+    virtual bool frame(const unsigned char *packet, const unsigned int &size) = 0;
+    /**
+     * Called with a frame whose checksum is invalid
+     */
+    virtual void bad_frame(){}
+
+  public:
+    /**
+     * Scan frames in the stored stream, and leave an incomplete frame for the next scan.
+     *
+     * @return (bool) false when frame() stops scanning
+     */
+    bool scan(){
+      const unsigned char *head_ptr((const unsigned char *)&buf[0]);
+      unsigned int head(0);
+      bool res(true);
+      while(true){
+        const void *sync(std::memchr(head_ptr + head, 0xB5, stored - head));
+        if(!sync){
+          head = stored;
+          break;
+        }
+        head = (const unsigned char *)sync - head_ptr;
+        unsigned int rest(stored - head);
+        if(rest < 2){break;}
+        if(head_ptr[head + 1] != 0x62){
+          head += 2; // same as G_Packet_Observer::seek_next(), which also skips the second byte
+          continue;
+        }
+        if(rest < 6){break;}
+        unsigned int size(8 + le_u16(head_ptr + head + 4));
+        if(size > max_frame_size){size = max_frame_size;}
+        if(rest < size){break;}
+        unsigned char ck_a(0), ck_b(0);
+        for(const unsigned char *p(head_ptr + head + 2), *p_end(head_ptr + head + size - 2); p < p_end; ++p){
+          ck_a += *p;
+          ck_b += ck_a;
+        }
+        if((head_ptr[head + size - 2] != ck_a) || (head_ptr[head + size - 1] != ck_b)){
+          bad_frame();
+          ++head;
+          continue;
+        }
+        if(!(res = frame(head_ptr + head, size))){break;}
+        head += size;
+      }
+      if(head > 0){
+        std::memmove(&buf[0], &buf[head], stored -= head);
+      }
+      return res;
+    }
+
+    /**
+     * Append raw UBX stream, and scan it
+     *
+     * @return (bool) false when frame() stops scanning
+     */
+    bool append(const char *data, unsigned int size){
+      while(size > 0){
+        unsigned int copy(buf.size() - stored);
+        if(copy > size){copy = size;}
+        std::memcpy(&buf[stored], data, copy);
+        stored += copy;
+        data += copy;
+        size -= copy;
+        if(!scan()){return false;} // the rest is less than max_frame_size
+      }
+      return true;
+    }
+};
+
+#endif /* __UBX_SCANNER_H__ */